@@ -256,20 +256,22 @@ namespace llvm {
     /// end of the range.  If no Segment contains this position, but the
     /// position is in a hole, this method returns an iterator pointing to the
     /// Segment immediately after the hole.
+    ///
+    /// Short moves are found by a linear scan. Longer ones switch to an
+    /// exponential search, so skipping far ahead in a large range only
+    /// touches a logarithmic number of segments.
     iterator advanceTo(iterator I, SlotIndex Pos) {
       assert(I != end());
       if (Pos >= endIndex())
         return end();
-      while (I->end <= Pos) ++I;
-      return I;
+      return advanceToImpl(I, end(), Pos);
     }
 
     const_iterator advanceTo(const_iterator I, SlotIndex Pos) const {
       assert(I != end());
       if (Pos >= endIndex())
         return end();
-      while (I->end <= Pos) ++I;
-      return I;
+      return advanceToImpl(I, end(), Pos);
     }
 
     /// find - Return an iterator pointing to the first segment that ends after
@@ -626,6 +628,29 @@ namespace llvm {
     friend class LiveRangeUpdater;
     void addSegmentToSet(Segment S);
     void markValNoForDeletion(VNInfo *V);
+
+    /// Return the first segment in [I, E) that ends after Pos. There must be
+    /// one.
+    template <typename IteratorT>
+    static IteratorT advanceToImpl(IteratorT I, IteratorT E, SlotIndex Pos) {
+      // Most callers only move a few segments ahead.
+      for (unsigned N = 0; N != 4; ++N, ++I)
+        if (Pos < I->end)
+          return I;
+
+      // Gallop until a segment ending after Pos is found, then binary search
+      // the last stride. All segments before I + Lo end at or before Pos.
+      size_t Len = E - I;
+      size_t Lo = 0, Hi = 1;
+      while (Hi < Len && I[Hi - 1].end <= Pos) {
+        Lo = Hi;
+        Hi *= 2;
+      }
+      return std::upper_bound(I + Lo, I + std::min(Hi, Len), Pos,
+                              [](SlotIndex P, const Segment &S) {
+                                return P < S.end;
+                              });
+    }
   };
 
   inline raw_ostream &operator<<(raw_ostream &OS, const LiveRange &LR) {
@@ -30,9 +30,11 @@
 #include "llvm/CodeGen/SlotIndexes.h"
 #include "llvm/CodeGen/TargetRegisterInfo.h"
 #include "llvm/MC/LaneBitmask.h"
+#include "llvm/Support/Allocator.h"
 #include "llvm/Support/CommandLine.h"
 #include "llvm/Support/Compiler.h"
 #include "llvm/Support/ErrorHandling.h"
+#include "llvm/Support/Recycler.h"
 #include <cassert>
 #include <cstdint>
 #include <utility>
@@ -65,6 +67,13 @@ class VirtRegMap;
     /// Special pool allocator for VNInfo's (LiveInterval val#).
     VNInfo::Allocator VNInfoAllocator;
 
+    /// Arena for the LiveInterval and register unit LiveRange objects. Objects
+    /// removed during the function are recycled, and the whole arena is freed
+    /// at once by releaseMemory().
+    BumpPtrAllocator IntervalAllocator;
+    Recycler<LiveInterval> IntervalRecycler;
+    Recycler<LiveRange> RegUnitRecycler;
+
     /// Live interval pointers for all the virtual registers.
     IndexedMap<LiveInterval*, VirtReg2IndexFunctor> VirtRegIntervals;
 
@@ -143,7 +152,7 @@ class VirtRegMap;
 
     /// Interval removal.
     void removeInterval(unsigned Reg) {
-      delete VirtRegIntervals[Reg];
+      destroyInterval(VirtRegIntervals[Reg]);
       VirtRegIntervals[Reg] = nullptr;
     }
 
@@ -394,8 +403,7 @@ class VirtRegMap;
       LiveRange *LR = RegUnitRanges[Unit];
       if (!LR) {
         // Compute missing ranges on demand.
-        // Use segment set to speed-up initial computation of the live range.
-        RegUnitRanges[Unit] = LR = new LiveRange(UseSegmentSetForPhysRegs);
+        LR = createRegUnit(Unit);
         computeRegUnitRange(*LR, Unit);
       }
       return *LR;
@@ -414,7 +422,7 @@ class VirtRegMap;
     /// Remove computed live range for register unit \p Unit. Subsequent uses
     /// should rely on on-demand recomputation.
     void removeRegUnit(unsigned Unit) {
-      delete RegUnitRanges[Unit];
+      destroyRegUnit(RegUnitRanges[Unit]);
       RegUnitRanges[Unit] = nullptr;
     }
 
@@ -453,7 +461,29 @@ class VirtRegMap;
     bool computeDeadValues(LiveInterval &LI,
                            SmallVectorImpl<MachineInstr*> *dead);
 
-    static LiveInterval* createInterval(unsigned Reg);
+    LiveInterval* createInterval(unsigned Reg);
+
+    void destroyInterval(LiveInterval *LI) {
+      if (!LI)
+        return;
+      LI->~LiveInterval();
+      IntervalRecycler.Deallocate(IntervalAllocator, LI);
+    }
+
+    /// Allocate an empty live range for register unit \p Unit from the
+    /// per-function arena, so that destroyRegUnit() can recycle it.
+    LiveRange *createRegUnit(unsigned Unit) {
+      // Use segment set to speed-up initial computation of the live range.
+      return RegUnitRanges[Unit] = new (RegUnitRecycler.Allocate(
+                 IntervalAllocator)) LiveRange(UseSegmentSetForPhysRegs);
+    }
+
+    void destroyRegUnit(LiveRange *LR) {
+      if (!LR)
+        return;
+      LR->~LiveRange();
+      RegUnitRecycler.Deallocate(IntervalAllocator, LR);
+    }
 
     void printInstrs(raw_ostream &O) const;
     void dumpInstrs() const;
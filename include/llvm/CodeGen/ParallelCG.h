@@ -32,6 +32,10 @@ class raw_pwrite_stream;
 /// together are intended to be equivalent to the single output file that would
 /// have been code generated from M.
 ///
+/// The partitions are balanced by their estimated code generation cost, and
+/// assigned to OSs in a deterministic order that does not depend on which
+/// thread finishes first.
+///
 /// Writes bitcode for individual partitions into output streams in BCOSs, if
 /// BCOSs is not empty.
 ///
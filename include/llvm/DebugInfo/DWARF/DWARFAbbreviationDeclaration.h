@@ -177,6 +177,10 @@ private:
   /// If this abbreviation has a fixed byte size then FixedAttributeSize member
   /// variable below will have a value.
   Optional<FixedSizeInfo> FixedAttributeSize;
+  /// The offsets, from the end of the abbreviation code, of the values of the
+  /// leading attributes that are only preceded by fixed size attributes. This
+  /// lets getAttributeValue() jump straight to the value of those attributes.
+  SmallVector<FixedSizeInfo, 8> FixedAttributeOffsets;
 };
 
 } // end namespace llvm
@@ -90,6 +90,7 @@ class DWARFContext : public DIContext {
   std::weak_ptr<DWOFile> DWP;
   bool CheckedForDWP = false;
   std::string DWPName;
+  bool LazyDIEExtraction = false;
 
   std::unique_ptr<MCRegisterInfo> RegInfo;
 
@@ -207,6 +208,17 @@ public:
   /// Get a DIE given an exact offset.
   DWARFDie getDIEForOffset(uint32_t Offset);
 
+  /// In lazy DIE extraction mode, address lookups such as
+  /// getLineInfoForAddress() only extract the DIEs of the top-level subtrees
+  /// (children of the unit DIE) that contain a subprogram covering the address,
+  /// and DIE references are resolved by extracting the subtree they point
+  /// into, instead of extracting all the DIEs of the unit. This is meant for
+  /// clients, like symbolizers, that only do lookups: the unit's DIE indices
+  /// (getDIEIndex(), getDIEAtIndex()) only cover the DIEs extracted the usual
+  /// way. The mode carries over to the contexts of split DWARF files.
+  bool getLazyDIEExtraction() const { return LazyDIEExtraction; }
+  void setLazyDIEExtraction(bool Lazy) { LazyDIEExtraction = Lazy; }
+
   unsigned getMaxVersion() const { return MaxVersion; }
 
   void setMaxVersionIfGreater(unsigned Version) {
@@ -10,6 +10,7 @@
 #ifndef LLVM_DEBUGINFO_DWARF_DWARFUNIT_H
 #define LLVM_DEBUGINFO_DWARF_DWARFUNIT_H
 
+#include "llvm/ADT/ArrayRef.h"
 #include "llvm/ADT/Optional.h"
 #include "llvm/ADT/STLExtras.h"
 #include "llvm/ADT/SmallVector.h"
@@ -200,6 +201,36 @@ class DWARFUnit {
   /// std::map::upper_bound for address range lookup.
   std::map<uint64_t, std::pair<uint64_t, DWARFDie>> AddrDieMap;
 
+  /// The subtrees of children of the unit DIE that were extracted on their
+  /// own in lazy DIE extraction mode, keyed by the offset of their root.
+  struct DIESubtree {
+    std::vector<DWARFDebugInfoEntry> Dies;
+    /// Whether the subprograms of the subtree are in AddrDieMap.
+    bool InAddrDieMap = false;
+  };
+  std::map<uint32_t, DIESubtree> DieSubtrees;
+
+  /// The address range of a subprogram and the offset of the child of the
+  /// unit DIE whose subtree contains it.
+  struct SubprogramRange {
+    DWARFAddressRange Range;
+    uint32_t RootOffset;
+    /// The largest HighPC of this range and the ones sorted before it.
+    uint64_t MaxHighPC;
+  };
+
+  /// The index used by lazy DIE extraction, built by a single pass over the
+  /// unit that doesn't keep its DIEs: the offsets of the children of the unit
+  /// DIE, and the address ranges of all subprograms sorted by LowPC.
+  bool HasLazyIndex = false;
+  std::vector<uint32_t> TopLevelDIEOffsets;
+  std::vector<SubprogramRange> SubprogramRanges;
+
+  /// The number of subtrees with subprograms, and how many of them have been
+  /// added to AddrDieMap. Once all have, lookups need not search the ranges.
+  unsigned NumSubprogramSubtrees = 0;
+  unsigned NumSubtreesInAddrDieMap = 0;
+
   using die_iterator_range =
       iterator_range<std::vector<DWARFDebugInfoEntry>::iterator>;
 
@@ -382,19 +413,9 @@ public:
   /// \brief Return the DIE object for a given offset inside the
   /// unit's DIE vector.
   ///
-  /// The unit needs to have its DIEs extracted for this method to work.
-  DWARFDie getDIEForOffset(uint32_t Offset) {
-    extractDIEsIfNeeded(false);
-    assert(!DieArray.empty());
-    auto it = std::lower_bound(
-        DieArray.begin(), DieArray.end(), Offset,
-        [](const DWARFDebugInfoEntry &LHS, uint32_t Offset) {
-          return LHS.getOffset() < Offset;
-        });
-    if (it != DieArray.end() && it->getOffset() == Offset)
-      return DWARFDie(this, &*it);
-    return DWARFDie();
-  }
+  /// The unit's DIEs are extracted if needed. In lazy DIE extraction mode,
+  /// only the subtree that contains the DIE is.
+  DWARFDie getDIEForOffset(uint32_t Offset);
 
   uint32_t getLineTableOffset() const {
     if (IndexEntry)
@@ -423,6 +444,21 @@ private:
   /// clearDIEs - Clear parsed DIEs to keep memory usage low.
   void clearDIEs(bool KeepCUDie);
 
+  /// Returns whether DIEs are extracted lazily, which is the case in lazy DIE
+  /// extraction mode unless all the DIEs of the unit were extracted first.
+  bool isExtractingLazily() const;
+
+  /// Builds the index used by lazy DIE extraction if it wasn't built yet.
+  void buildLazyIndexIfNeeded();
+
+  /// Extracts the subtree rooted at the child of the unit DIE at RootOffset if
+  /// it wasn't extracted yet.
+  DIESubtree &extractSubtreeIfNeeded(uint32_t RootOffset);
+
+  /// Returns the DIE vector or subtree that holds Die.
+  ArrayRef<DWARFDebugInfoEntry>
+  getDIEArrayFor(const DWARFDebugInfoEntry *Die) const;
+
   /// parseDWO - Parses .dwo file for current compile unit. Returns true if
   /// it was actually constructed.
   bool parseDWO();
@@ -14,14 +14,17 @@
 #ifndef LLVM_DEBUGINFO_SYMBOLIZE_SYMBOLIZE_H
 #define LLVM_DEBUGINFO_SYMBOLIZE_SYMBOLIZE_H
 
+#include "llvm/ADT/ArrayRef.h"
 #include "llvm/DebugInfo/Symbolize/SymbolizableModule.h"
 #include "llvm/Object/Binary.h"
 #include "llvm/Object/ObjectFile.h"
 #include "llvm/Support/Error.h"
 #include <algorithm>
 #include <cstdint>
+#include <list>
 #include <map>
 #include <memory>
+#include <mutex>
 #include <string>
 #include <utility>
 #include <vector>
@@ -42,6 +45,10 @@ public:
     bool RelativeAddresses : 1;
     std::string DefaultArch;
     std::vector<std::string> DsymHints;
+    /// Approximate upper bound, in bytes, on the size of the object files
+    /// kept open for cached modules. Least recently used modules are evicted
+    /// between requests to stay under it. Zero means no limit.
+    uint64_t MaxCacheSize = 0;
 
     Options(FunctionNameKind PrintFunctions = FunctionNameKind::LinkageName,
             bool UseSymbolTable = true, bool Demangle = true,
@@ -51,6 +58,26 @@ public:
           DefaultArch(std::move(DefaultArch)) {}
   };
 
+  /// A module and an offset into it, as accepted by the batch interfaces.
+  struct Request {
+    std::string ModuleName;
+    uint64_t ModuleOffset;
+  };
+
+  /// Counters describing how the symbolizer has been used so far.
+  struct Stats {
+    /// Number of addresses symbolized.
+    uint64_t NumRequests = 0;
+    /// Number of module lookups satisfied from the cache.
+    uint64_t NumCacheHits = 0;
+    /// Number of module lookups that had to load the module.
+    uint64_t NumCacheMisses = 0;
+    /// Number of modules evicted to stay under Options::MaxCacheSize.
+    uint64_t NumEvictions = 0;
+    /// Current size, in bytes, of the object files of the cached modules.
+    uint64_t CacheSize = 0;
+  };
+
   LLVMSymbolizer(const Options &Opts = Options()) : Opts(Opts) {}
 
   ~LLVMSymbolizer() {
@@ -65,8 +92,21 @@ public:
                                                 StringRef DWPName = "");
   Expected<DIGlobal> symbolizeData(const std::string &ModuleName,
                                    uint64_t ModuleOffset);
+
+  /// Batch versions of the functions above. The requests are grouped by
+  /// module and sorted by offset, and the modules are symbolized on multiple
+  /// threads. The results are returned in the order of \p Requests and are
+  /// the same as those of symbolizing the requests one by one.
+  std::vector<Expected<DILineInfo>>
+  symbolizeCode(ArrayRef<Request> Requests, StringRef DWPName = "");
+  std::vector<Expected<DIInliningInfo>>
+  symbolizeInlinedCode(ArrayRef<Request> Requests, StringRef DWPName = "");
+  std::vector<Expected<DIGlobal>> symbolizeData(ArrayRef<Request> Requests);
+
   void flush();
 
+  Stats getStats();
+
   static std::string
   DemangleName(const std::string &Name,
                const SymbolizableModule *DbiModuleDescriptor);
@@ -83,6 +123,30 @@ private:
   Expected<SymbolizableModule *>
   getOrCreateModuleInfo(const std::string &ModuleName, StringRef DWPName = "");
 
+  Expected<SymbolizableModule *>
+  getOrCreateModuleInfoImpl(const std::string &ModuleName, StringRef DWPName);
+
+  /// Symbolize \p ModuleOffset in a module that has been loaded successfully.
+  DILineInfo symbolizeCodeInModule(SymbolizableModule *Info,
+                                   uint64_t ModuleOffset);
+  DIInliningInfo symbolizeInlinedCodeInModule(SymbolizableModule *Info,
+                                              uint64_t ModuleOffset);
+  DIGlobal symbolizeDataInModule(SymbolizableModule *Info,
+                                 uint64_t ModuleOffset);
+
+  /// Symbolize \p Requests with \p Symbolize, which is called with the module
+  /// of each request.
+  template <typename T, typename FnT>
+  std::vector<Expected<T>> symbolizeBatch(ArrayRef<Request> Requests,
+                                          StringRef DWPName, FnT Symbolize);
+
+  /// Evict least recently used modules until the cache is under
+  /// Options::MaxCacheSize. Must not be called while modules are in use.
+  void pruneModuleCache();
+
+  /// Release the binary at \p Path and the objects created from it.
+  void releaseBinary(const std::string &Path);
+
   ObjectFile *lookUpDsymFile(const std::string &Path,
                              const MachOObjectFile *ExeObj,
                              const std::string &ArchName);
@@ -100,7 +164,26 @@ private:
   Expected<ObjectFile *> getOrCreateObject(const std::string &Path,
                                           const std::string &ArchName);
 
-  std::map<std::string, std::unique_ptr<SymbolizableModule>> Modules;
+  struct CachedModule {
+    std::unique_ptr<SymbolizableModule> Module;
+    /// Size of the object files backing the module.
+    uint64_t Size = 0;
+    /// Paths of the binaries holding the object files backing the module.
+    std::vector<std::string> BinaryPaths;
+    /// Position of the module in ModuleLRU.
+    std::list<std::string>::iterator LRUPos;
+  };
+
+  std::map<std::string, CachedModule> Modules;
+
+  /// Names of the cached modules, least recently used first.
+  std::list<std::string> ModuleLRU;
+
+  /// Guards the caches and the statistics, which are accessed from multiple
+  /// threads by the batch interfaces.
+  std::mutex Mutex;
+
+  Stats Statistics;
 
   /// \brief Contains cached results of getOrCreateObjectPair().
   std::map<std::pair<std::string, std::string>, ObjectPair>
@@ -0,0 +1,112 @@
+//===- llvm/IR/BinaryRemarks.h - Binary optimization remarks ----*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file declares a writer and a reader for the binary optimization remark
+// format, a compact alternative to the YAML remark files written for
+// -pass-remarks-output.
+//
+// A binary remark file starts with the magic bytes "RMRK" and a ULEB128
+// version number, followed by a stream of records. Each record starts with a
+// one-byte tag:
+//
+//   String: the ULEB128 size of a string followed by its bytes. The strings
+//           of a file are numbered from zero in the order of their records.
+//   Remark: the ULEB128 RemarkType, the numbers of the pass name, the remark
+//           name and the function name, the location, a one-byte flag telling
+//           whether a ULEB128 hotness follows, and the ULEB128 number of
+//           arguments, each of which is the numbers of its key and value
+//           followed by its location.
+//
+// A location is the ULEB128 number of the file name plus one, or zero if
+// there is no location, followed by the ULEB128 line and column if there is
+// one. Every string is written once, just before the first remark using it,
+// so the file can be written as the remarks are emitted without keeping them.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_IR_BINARYREMARKS_H
+#define LLVM_IR_BINARYREMARKS_H
+
+#include "llvm/ADT/Optional.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Support/Error.h"
+#include <cstdint>
+
+namespace llvm {
+
+class DiagnosticInfoOptimizationBase;
+class DiagnosticLocation;
+class raw_ostream;
+
+/// The kinds of optimization remarks, named after their YAML tags.
+enum class RemarkType : uint8_t {
+  Passed,
+  Missed,
+  Analysis,
+  AnalysisFPCommute,
+  AnalysisAliasing,
+  Failure
+};
+
+struct RemarkLocation {
+  StringRef File;
+  unsigned Line = 0;
+  unsigned Column = 0;
+};
+
+struct RemarkArgument {
+  StringRef Key;
+  StringRef Val;
+  Optional<RemarkLocation> Loc;
+};
+
+/// A remark read from a binary remark file. The strings point into the
+/// buffer that was read.
+struct Remark {
+  RemarkType Type = RemarkType::Passed;
+  StringRef PassName;
+  StringRef RemarkName;
+  StringRef FunctionName;
+  Optional<RemarkLocation> Loc;
+  Optional<uint64_t> Hotness;
+  SmallVector<RemarkArgument, 4> Args;
+};
+
+/// Writes optimization remarks to a stream in the binary remark format.
+class BinaryRemarkWriter {
+  raw_ostream &OS;
+
+  /// The numbers of the strings written so far.
+  StringMap<unsigned> StringIDs;
+
+  unsigned getStringID(StringRef S);
+  void writeLocation(const DiagnosticLocation &Loc);
+
+public:
+  /// Writes the header of the format to \p OS.
+  explicit BinaryRemarkWriter(raw_ostream &OS);
+
+  void write(const DiagnosticInfoOptimizationBase &Diag);
+};
+
+/// Returns whether \p Buffer starts with the magic bytes of a binary remark
+/// file.
+bool isBinaryRemarks(StringRef Buffer);
+
+/// Reads the binary remark file in \p Buffer and calls \p Callback for each
+/// remark in it, in the order the remarks were written.
+Error readBinaryRemarks(StringRef Buffer,
+                        function_ref<void(const Remark &)> Callback);
+
+} // end namespace llvm
+
+#endif // LLVM_IR_BINARYREMARKS_H
@@ -25,6 +25,7 @@
 
 namespace llvm {
 
+class BinaryRemarkWriter;
 class DiagnosticInfo;
 enum DiagnosticSeverity : char;
 class Function;
@@ -256,6 +257,18 @@ public:
   /// set, the handler is invoked for each diagnostic message.
   void setDiagnosticsOutputFile(std::unique_ptr<yaml::Output> F);
 
+  /// Return the writer used to save optimization diagnostics in the binary
+  /// remark format, or null if they are not saved in that format.
+  BinaryRemarkWriter *getDiagnosticsBinaryOutputFile();
+  /// Set the writer used to save optimization diagnostics in the binary remark
+  /// format. It can be set together with a YAML output file, in which case
+  /// diagnostics are saved in both.
+  void setDiagnosticsBinaryOutputFile(std::unique_ptr<BinaryRemarkWriter> W);
+
+  /// Return true if optimization diagnostics are saved in a file in any
+  /// format.
+  bool hasDiagnosticsOutputFile();
+
   /// \brief Get the prefix that should be printed in front of a diagnostic of
   ///        the given \p Severity
   static const char *getDiagnosticMessagePrefix(DiagnosticSeverity Severity);
@@ -0,0 +1,256 @@
+//===- ModuleSummaryIndexTable.h - Summary index lookup tables --*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file contains data definitions and a reader and writer for summary
+// tables, an alternative on-disk format for a combined ModuleSummaryIndex that
+// can be used in place after mapping the file into memory.
+//
+// A summary table holds every summary of the combined index once, together
+// with a table of all GUIDs sorted by value, so that the summaries of a GUID
+// are found by binary search. Edges refer to other values by their index in
+// the GUID table and summaries are referred to by their offset in the file, so
+// nothing needs to be decoded up front. For each module compiled by a ThinLTO
+// backend, the table also lists the summaries that the backend needs (those
+// of the values the module defines or imports), which lets a backend
+// materialize just its own part of the index instead of reading an individual
+// index file.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_IR_MODULESUMMARYINDEXTABLE_H
+#define LLVM_IR_MODULESUMMARYINDEXTABLE_H
+
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/IR/GlobalValue.h"
+#include "llvm/IR/ModuleSummaryIndex.h"
+#include "llvm/Support/Endian.h"
+#include "llvm/Support/Error.h"
+#include <map>
+#include <string>
+
+namespace llvm {
+
+class raw_ostream;
+
+namespace summarytab {
+
+namespace storage {
+
+// The data structures in this namespace define the low-level serialization
+// format. Clients that just want to read a summary table should use the
+// summarytab::Reader class.
+
+using Word = support::ulittle32_t;
+using DWord = support::ulittle64_t;
+
+/// A reference to a string in the table.
+struct Str {
+  Word Offset, Size;
+
+  StringRef get(StringRef Data) const { return {Data.data() + Offset, Size}; }
+};
+
+/// A reference to a range of objects in the table.
+template <typename T> struct Range {
+  Word Offset, Size;
+
+  ArrayRef<T> get(StringRef Data) const {
+    return {reinterpret_cast<const T *>(Data.data() + Offset), Size};
+  }
+};
+
+/// A module of the combined index.
+struct Module {
+  Str Path;
+  DWord ModuleId;
+  Word Hash[5];
+
+  /// The offsets of the summaries needed by the backend of this module, sorted
+  /// by the path of the defining module. Empty if the module has no backend.
+  Range<Word> Needed;
+};
+
+/// The summaries of a GUID. The entries of a table are sorted by GUID, and
+/// there is an entry for every GUID that is referenced by a summary.
+struct Entry {
+  DWord GUID;
+
+  /// The offsets of the summaries, one per defining module.
+  Range<Word> Summaries;
+};
+
+/// The fields common to all summaries. The summary at a given offset starts
+/// with a GlobalValueSummary, whose Kind tells which of the structures below
+/// it is part of.
+struct GlobalValueSummary {
+  /// The GlobalValueSummary::SummaryKind of the summary.
+  Word Kind;
+
+  /// The index of the entry of the summary's GUID.
+  Word Entry;
+
+  /// The index of the module that defines the value.
+  Word Module;
+
+  /// The GVFlags of the summary: the linkage in bits 0-3, followed by one bit
+  /// each for NotEligibleToImport, Live and DSOLocal.
+  Word Flags;
+
+  DWord OriginalName;
+
+  /// The entries of the referenced values.
+  Range<Word> Refs;
+};
+
+struct VFuncId {
+  DWord GUID, Offset;
+};
+
+struct ConstVCall {
+  VFuncId VFunc;
+  Range<DWord> Args;
+};
+
+struct Call {
+  /// The entry of the callee.
+  Word Callee;
+
+  /// The CalleeInfo::HotnessType of the call.
+  Word Hotness;
+};
+
+struct FunctionSummary {
+  GlobalValueSummary Base;
+  Word InstCount;
+
+  /// The FFlags of the function: one bit each for ReadNone, ReadOnly,
+  /// NoRecurse and ReturnDoesNotAlias, starting at bit 0.
+  Word FFlags;
+
+  Range<Call> Calls;
+  Range<DWord> TypeTests;
+  Range<VFuncId> TypeTestAssumeVCalls, TypeCheckedLoadVCalls;
+  Range<ConstVCall> TypeTestAssumeConstVCalls, TypeCheckedLoadConstVCalls;
+};
+
+struct GlobalVarSummary {
+  GlobalValueSummary Base;
+};
+
+struct AliasSummary {
+  GlobalValueSummary Base;
+
+  /// The entry of the aliasee, which is defined in the same module.
+  Word Aliasee;
+};
+
+struct Header {
+  /// The magic number, which is 'L','S','U','M' in file order.
+  Word Magic;
+  enum { kMagic = 0x4d55534c };
+
+  /// Version number of the table format. This number should be incremented
+  /// when the format changes.
+  Word Version;
+  enum { kCurrentVersion = 1 };
+
+  /// The modules of the combined index, sorted by path.
+  Range<Module> Modules;
+
+  /// The GUIDs of the combined index, sorted by GUID.
+  Range<Entry> Entries;
+
+  /// The sets of CFI function definitions and declarations.
+  Range<Str> CfiFunctionDefs, CfiFunctionDecls;
+};
+
+} // end namespace storage
+
+/// Returns whether Data starts with the magic number of a summary table.
+bool isSummaryTable(StringRef Data);
+
+/// Writes the combined index Index to OS as a summary table. For each module
+/// path in ModuleToSummaries, the table lists the summaries the module's
+/// backend needs, as given by gatherImportedSummariesForModule() for the
+/// module.
+void write(
+    const ModuleSummaryIndex &Index,
+    const StringMap<std::map<std::string, GVSummaryMapTy>> &ModuleToSummaries,
+    raw_ostream &OS);
+
+/// This class reads a summary table in place. It does not own the data, which
+/// must outlive the reader.
+class Reader {
+  StringRef Data;
+  const storage::Header *Header = nullptr;
+  ArrayRef<storage::Module> Modules;
+  ArrayRef<storage::Entry> Entries;
+
+  template <typename T> ArrayRef<T> range(storage::Range<T> R) const {
+    return R.get(Data);
+  }
+  StringRef str(storage::Str S) const { return S.get(Data); }
+
+  const storage::GlobalValueSummary &summaryAt(uint32_t Offset) const {
+    return *reinterpret_cast<const storage::GlobalValueSummary *>(
+        Data.data() + Offset);
+  }
+
+  /// Returns the summary at Offset after checking that it and the ranges it
+  /// refers to are within the table, and that the entry and module indices
+  /// in it, including those of its references and callees, are valid.
+  Expected<const storage::GlobalValueSummary *>
+  getSummary(uint32_t Offset) const;
+
+  std::unique_ptr<llvm::GlobalValueSummary>
+  createSummary(const storage::GlobalValueSummary &S,
+                const DenseMap<uint32_t, ValueInfo> &EntryToValueInfo) const;
+
+public:
+  Reader() = default;
+
+  /// Checks the header and the modules of the table in Data and creates a
+  /// reader for it. The summaries are checked when they are read.
+  static Expected<Reader> create(StringRef Data);
+
+  ArrayRef<storage::Module> modules() const { return Modules; }
+  ArrayRef<storage::Entry> entries() const { return Entries; }
+
+  StringRef getModulePath(const storage::Module &M) const {
+    return str(M.Path);
+  }
+
+  /// Returns the module with path ModulePath, or nullptr if there is none.
+  const storage::Module *findModule(StringRef ModulePath) const;
+
+  /// Returns the entry of GUID, or nullptr if the table has no entry for it.
+  /// The entry is found by binary search.
+  const storage::Entry *findEntry(GlobalValue::GUID GUID) const;
+
+  /// Returns the summary of GUID defined in the module with path ModulePath,
+  /// or nullptr if there is none or the entry of GUID is corrupt.
+  const storage::GlobalValueSummary *
+  findSummaryInModule(GlobalValue::GUID GUID, StringRef ModulePath) const;
+
+  /// Adds to Index the summaries listed as needed by the backend of the module
+  /// with path ModulePath, together with the modules defining them. The
+  /// result is the same as reading the individual index written for the
+  /// module by the write-indexes ThinLTO backend, except that call edges to
+  /// local functions known only by their original name are dropped.
+  Error materializeForModule(StringRef ModulePath,
+                             ModuleSummaryIndex &Index) const;
+};
+
+} // end namespace summarytab
+} // end namespace llvm
+
+#endif // LLVM_IR_MODULESUMMARYINDEXTABLE_H
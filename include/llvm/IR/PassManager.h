@@ -46,6 +46,7 @@
 #include "llvm/IR/Module.h"
 #include "llvm/IR/PassManagerInternal.h"
 #include "llvm/Support/Debug.h"
+#include "llvm/Support/TimeProfiler.h"
 #include "llvm/Support/TypeName.h"
 #include "llvm/Support/raw_ostream.h"
 #include <algorithm>
@@ -54,6 +55,7 @@
 #include <iterator>
 #include <list>
 #include <memory>
+#include <string>
 #include <tuple>
 #include <type_traits>
 #include <utility>
@@ -402,6 +404,19 @@ struct AnalysisInfoMixin : PassInfoMixin<DerivedT> {
   }
 };
 
+namespace detail {
+
+/// Returns the name of \p IR as the detail of a time trace event. Some units
+/// of IR build their name on demand, so it is only computed when the time
+/// trace profiler is enabled.
+template <typename IRUnitT> std::string getTimeTraceDetail(IRUnitT &IR) {
+  if (!timeTraceProfilerEnabled())
+    return std::string();
+  return IR.getName();
+}
+
+} // end namespace detail
+
 /// \brief Manages a sequence of passes over a particular unit of IR.
 ///
 /// A pass manager contains a sequence of passes to run over a particular unit
@@ -453,7 +468,12 @@ public:
         dbgs() << "Running pass: " << Passes[Idx]->name() << " on "
                << IR.getName() << "\n";
 
-      PreservedAnalyses PassPA = Passes[Idx]->run(IR, AM, ExtraArgs...);
+      PreservedAnalyses PassPA;
+      {
+        TimeTraceScope PassScope(Passes[Idx]->name(),
+                                 detail::getTimeTraceDetail(IR));
+        PassPA = Passes[Idx]->run(IR, AM, ExtraArgs...);
+      }
 
       // Update the analysis manager as each pass runs and potentially
       // invalidates analyses.
@@ -861,7 +881,10 @@ private:
         dbgs() << "Running analysis: " << P.name() << " on " << IR.getName()
                << "\n";
       AnalysisResultListT &ResultList = AnalysisResultLists[&IR];
-      ResultList.emplace_back(ID, P.run(IR, *this, ExtraArgs...));
+      {
+        TimeTraceScope AnalysisScope(P.name(), detail::getTimeTraceDetail(IR));
+        ResultList.emplace_back(ID, P.run(IR, *this, ExtraArgs...));
+      }
 
       // P.run may have inserted elements into AnalysisResults and invalidated
       // RI.
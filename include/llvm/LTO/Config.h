@@ -82,6 +82,11 @@ struct Config {
   /// Whether to emit the pass manager debuggging informations.
   bool DebugPassManager = false;
 
+  /// If this field is set, the ThinLTO import lists are saved to this file,
+  /// and the next link using the same file only recomputes the import lists
+  /// of the modules affected by what changed since.
+  std::string ThinLTOImportStateFile;
+
   bool ShouldDiscardValueNames = true;
   DiagnosticHandlerFunction DiagHandler;
 
@@ -201,6 +201,24 @@ typedef std::function<std::unique_ptr<ThinBackendProc>(
 /// This ThinBackend runs the individual backend jobs in-process.
 ThinBackend createInProcessThinBackend(unsigned ParallelismLevel);
 
+/// This ThinBackend runs each backend job in a separate worker process, so that
+/// the memory used by a job is returned to the system as soon as it finishes
+/// and the peak memory of each job can be capped.
+///
+/// For each job the backend writes the individual module index to a temporary
+/// file, as the write-indexes backend does, and runs
+///   WorkerPath WorkerArgs... -thinlto-index=<index> -o <object> <module>
+/// with at most ParallelismLevel workers running at a time. Each worker may
+/// use at most MemoryLimit megabytes of memory, or any amount if MemoryLimit
+/// is zero. The worker is expected to call thinBackendWorker() and write the
+/// native object to <object>, which is then passed to AddStream. Since the
+/// workers read the modules from the paths given by their module identifiers,
+/// every ThinLTO input must be a file. The native object cache is not used.
+ThinBackend createOutOfProcessThinBackend(unsigned ParallelismLevel,
+                                          std::string WorkerPath,
+                                          std::vector<std::string> WorkerArgs,
+                                          unsigned MemoryLimit);
+
 /// This ThinBackend writes individual module indexes to files, instead of
 /// running the individual backend jobs. This backend is for distributed builds
 /// where separate processes will invoke the real backends.
@@ -215,6 +233,14 @@ ThinBackend createWriteIndexesThinBackend(std::string OldPrefix,
                                           bool ShouldEmitImportsFiles,
                                           std::string LinkedObjectsFile);
 
+/// This ThinBackend writes a single summary table (see
+/// llvm/IR/ModuleSummaryIndexTable.h) to OutputFile, instead of running the
+/// individual backend jobs. The table holds the combined index together with
+/// the list of summaries needed by each backend, so that the distributed
+/// backends can all read their part of the index from the same file, mapped
+/// into memory, instead of each reading an individual index file.
+ThinBackend createWriteSummaryTableThinBackend(std::string OutputFile);
+
 /// This class implements a resolution-based interface to LLVM's LTO
 /// functionality. It supports regular LTO, parallel LTO code generation and
 /// ThinLTO. You can use it from a linker in the following way:
@@ -46,6 +46,15 @@ Error thinBackend(Config &C, unsigned Task, AddStreamFn AddStream, Module &M,
                   const FunctionImporter::ImportMapTy &ImportList,
                   const GVSummaryMapTy &DefinedGlobals,
                   MapVector<StringRef, BitcodeModule> &ModuleMap);
+
+/// Runs a ThinLTO backend job of the out-of-process ThinLTO backend (see
+/// createOutOfProcessThinBackend()) in the current process. The module is read
+/// from ModulePath and the individual index written for it by the thin link is
+/// read from IndexPath, which may also be a summary table written by the thin
+/// link for all modules. The modules to import from are read from the paths
+/// recorded in the index.
+Error thinBackendWorker(Config &C, StringRef ModulePath, StringRef IndexPath,
+                        AddStreamFn AddStream);
 }
 }
 
@@ -35,7 +35,8 @@ public:
     return decompress({Out.data(), (size_t)DecompressedSize});
   }
 
-  /// @brief Uncompress section data to raw buffer provided.
+  /// @brief Uncompress section data to raw buffer provided. The chunks of
+  /// sections that were compressed in parallel are uncompressed in parallel.
   /// @param Buffer      Destination buffer.
   Error decompress(MutableArrayRef<char> Buffer);
 
@@ -517,6 +517,10 @@ class CoverageMapping {
   Error loadFunctionRecord(const CoverageMappingRecord &Record,
                            IndexedInstrProfReader &ProfileReader);
 
+  /// Add the function records read by \p CoverageReader.
+  Error loadFromReader(CoverageMappingReader &CoverageReader,
+                       IndexedInstrProfReader &ProfileReader);
+
 public:
   CoverageMapping(const CoverageMapping &) = delete;
   CoverageMapping &operator=(const CoverageMapping &) = delete;
@@ -528,6 +532,8 @@ public:
 
   /// Load the coverage mapping from the given object files and profile. If
   /// \p Arches is non-empty, it must specify an architecture for each object.
+  /// The objects are read one at a time, so only the coverage mapping of a
+  /// single object is kept in memory besides the loaded function records.
   static Expected<std::unique_ptr<CoverageMapping>>
   load(ArrayRef<StringRef> ObjectFilenames, StringRef ProfileFilename,
        ArrayRef<StringRef> Arches = None);
@@ -278,6 +278,42 @@ enum class HashT : uint32_t;
 
 } // end namespace IndexedInstrProf
 
+/// A profile record of an indexed profile, read in place from the profile
+/// data. Looking it up neither copies the counters nor decodes the value
+/// profile data, which is only decoded when asked for. It refers to the data of
+/// the reader it was obtained from and must not outlive it.
+class InstrProfRecordRef {
+  uint64_t Hash = 0;
+  ArrayRef<support::ulittle64_t> Counts;
+  // The value profile data, or null if there is none. It has been checked to
+  // be well formed when the record was looked up.
+  const unsigned char *ValueData = nullptr;
+  support::endianness ValueDataEndianness = support::little;
+
+public:
+  InstrProfRecordRef() = default;
+  InstrProfRecordRef(uint64_t Hash, ArrayRef<support::ulittle64_t> Counts,
+                     const unsigned char *ValueData,
+                     support::endianness ValueDataEndianness)
+      : Hash(Hash), Counts(Counts), ValueData(ValueData),
+        ValueDataEndianness(ValueDataEndianness) {}
+
+  uint64_t getHash() const { return Hash; }
+
+  /// Return the counters, in place in the profile data.
+  ArrayRef<support::ulittle64_t> getCounts() const { return Counts; }
+
+  /// Return the number of value profile sites of ValueKind, without decoding
+  /// the value profile data.
+  uint32_t getNumValueSites(uint32_t ValueKind) const;
+
+  /// Decode the value profile data into Record.
+  Error readValueProfData(InstrProfRecord &Record) const;
+
+  /// Return the record with the counters and the value profile data decoded.
+  Expected<InstrProfRecord> getRecord() const;
+};
+
 /// Trait for lookups into the on-disk hash table for the binary instrprof
 /// format.
 class InstrProfLookupTrait {
@@ -323,6 +359,11 @@ public:
                               const unsigned char *const End);
   data_type ReadData(StringRef K, const unsigned char *D, offset_type N);
 
+  /// Find the record with hash FuncHash among the records of a key stored in
+  /// the N bytes at D, without decoding any of them.
+  Expected<InstrProfRecordRef> findRecord(const unsigned char *D, offset_type N,
+                                          uint64_t FuncHash);
+
   // Used for testing purpose only.
   void setValueProfDataEndianness(support::endianness Endianness) {
     ValueProfDataEndianness = Endianness;
@@ -339,6 +380,11 @@ struct InstrProfReaderIndexBase {
   // Read all the profile records with the key equal to FuncName
   virtual Error getRecords(StringRef FuncName,
                                      ArrayRef<NamedInstrProfRecord> &Data) = 0;
+
+  // Find the profile record with the key equal to FuncName and hash FuncHash,
+  // without decoding it.
+  virtual Expected<InstrProfRecordRef> getRecordRef(StringRef FuncName,
+                                                    uint64_t FuncHash) = 0;
   virtual void advanceToNextKey() = 0;
   virtual bool atEnd() const = 0;
   virtual void setValueProfDataEndianness(support::endianness Endianness) = 0;
@@ -367,6 +413,8 @@ public:
   Error getRecords(ArrayRef<NamedInstrProfRecord> &Data) override;
   Error getRecords(StringRef FuncName,
                    ArrayRef<NamedInstrProfRecord> &Data) override;
+  Expected<InstrProfRecordRef> getRecordRef(StringRef FuncName,
+                                            uint64_t FuncHash) override;
   void advanceToNextKey() override { RecordIterator++; }
 
   bool atEnd() const override {
@@ -427,6 +475,12 @@ public:
   Expected<InstrProfRecord> getInstrProfRecord(StringRef FuncName,
                                                uint64_t FuncHash);
 
+  /// Return a reference to the record associated with FuncName and FuncHash
+  /// in the profile data. This is cheaper than getInstrProfRecord() when not
+  /// all of the record is needed.
+  Expected<InstrProfRecordRef> getInstrProfRecordRef(StringRef FuncName,
+                                                     uint64_t FuncHash);
+
   /// Fill Counts with the profile data for the given function name.
   Error getFunctionCounts(StringRef FuncName, uint64_t FuncHash,
                           std::vector<uint64_t> &Counts);
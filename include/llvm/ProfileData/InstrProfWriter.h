@@ -23,6 +23,7 @@
 #include "llvm/Support/MemoryBuffer.h"
 #include <cstdint>
 #include <memory>
+#include <vector>
 
 namespace llvm {
 
@@ -39,6 +40,8 @@ public:
 private:
   bool Sparse;
   StringMap<ProfilingData> FunctionData;
+  /// Functions taken over from other writers by addShard.
+  std::vector<StringMap<ProfilingData>> Shards;
   ProfKind ProfileKind = PF_Unknown;
   // Use raw pointer here for the incomplete type object.
   InstrProfRecordWriterTrait *InfoObj;
@@ -60,6 +63,12 @@ public:
   void mergeRecordsFromWriter(InstrProfWriter &&IPW,
                               function_ref<void(Error)> Warn);
 
+  /// Take over the functions of \p IPW, so that they are written out along
+  /// with ours. Unlike mergeRecordsFromWriter, this doesn't look at the
+  /// records, so the two writers must not have any function name in common,
+  /// e.g. because each merged a different shard of the function names.
+  void addShard(InstrProfWriter &&IPW);
+
   /// Write the profile to \c OS
   void write(raw_fd_ostream &OS);
 
@@ -78,11 +78,33 @@ struct is_error_code_enum<llvm::sampleprof_error> : std::true_type {};
 namespace llvm {
 namespace sampleprof {
 
-static inline uint64_t SPMagic() {
+enum SampleProfileFormat {
+  SPF_None = 0x0,
+  SPF_Text = 0x1,
+  SPF_Compact_Binary = 0x2,
+  SPF_GCC = 0x3,
+  SPF_Binary = 0xff
+};
+
+static inline uint64_t SPMagic(SampleProfileFormat Format = SPF_Binary) {
   return uint64_t('S') << (64 - 8) | uint64_t('P') << (64 - 16) |
          uint64_t('R') << (64 - 24) | uint64_t('O') << (64 - 32) |
          uint64_t('F') << (64 - 40) | uint64_t('4') << (64 - 48) |
-         uint64_t('2') << (64 - 56) | uint64_t(0xff);
+         uint64_t('2') << (64 - 56) | uint64_t(Format);
+}
+
+/// Get the proper representation of a string in the input Format.
+///
+/// The compact binary format refers to functions by the MD5 hash of their
+/// name, which is kept in decimal form as the name of the profile. The hash
+/// is stored in \p GUIDBuf, which must outlive the returned string.
+static inline StringRef getRepInFormat(StringRef Name,
+                                       SampleProfileFormat Format,
+                                       std::string &GUIDBuf) {
+  if (Name.empty() || Format != SPF_Compact_Binary)
+    return Name;
+  GUIDBuf = std::to_string(Function::getGUID(Name));
+  return GUIDBuf;
 }
 
 static inline uint64_t SPVersion() { return 103; }
@@ -362,7 +384,7 @@ public:
                             uint64_t Threshold) const {
     if (TotalSamples <= Threshold)
       return;
-    S.insert(Function::getGUID(Name));
+    S.insert(getGUID(Name));
     // Import hot CallTargets, which may not be available in IR because full
     // profile annotation cannot be done until backend compilation in ThinLTO.
     for (const auto &BS : BodySamples)
@@ -370,7 +392,7 @@ public:
         if (TS.getValue() > Threshold) {
           Function *Callee = M->getFunction(TS.getKey());
           if (!Callee || !Callee->getSubprogram())
-            S.insert(Function::getGUID(TS.getKey()));
+            S.insert(getGUID(TS.getKey()));
         }
     for (const auto &CS : CallsiteSamples)
       for (const auto &NameFS : CS.second)
@@ -383,6 +405,19 @@ public:
   /// Return the function name.
   const StringRef &getName() const { return Name; }
 
+  /// Return the GUID of the function named \p Name in the profile, which is
+  /// the name itself in the compact binary format.
+  static GlobalValue::GUID getGUID(StringRef Name) {
+    GlobalValue::GUID GUID;
+    if (Format == SPF_Compact_Binary && !Name.getAsInteger(10, GUID))
+      return GUID;
+    return Function::getGUID(Name);
+  }
+
+  /// The format of the profile that was last read. Function names in
+  /// profiles of the compact binary format are MD5 hashes.
+  static SampleProfileFormat Format;
+
 private:
   /// Mangled name of the function.
   StringRef Name;
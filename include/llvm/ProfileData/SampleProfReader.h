@@ -204,6 +204,43 @@
 //          in the text format documentation above).
 //        FUNCTION BODY
 //          A FUNCTION BODY entry describing the inlined function.
+//
+//
+// Compact binary format
+// ---------------------
+//
+// This is the binary format with the following differences, which make it
+// smaller and let a reader load only the functions it is interested in:
+//
+// MAGIC (uint64_t)
+//    File identifier computed by SPMagic(SPF_Compact_Binary)
+//    (0x5350524f46343202)
+//
+// NAME TABLE
+//    SIZE (uint32_t)
+//        Number of entries in the name table.
+//    NAMES
+//        A list of SIZE MD5 hashes of the function names (uint64_t), sorted
+//        by name. Profiles read from this format are named by the decimal
+//        representation of the hash.
+//
+// FUNCTION BODY entries follow the name table as in the binary format, and
+// are followed by:
+//
+// FUNCTION OFFSET TABLE
+//    SIZE (uint64_t)
+//        Number of top-level functions in the profile.
+//    OFFSETS
+//        A list of SIZE entries, one for each top-level function:
+//          NAME_IDX (uint32_t)
+//            Index into the name table indicating the function name.
+//          OFFSET (uint64_t)
+//            Offset of the FUNCTION BODY of the function from the first
+//            FUNCTION BODY in the file.
+//
+// FUNCTION OFFSET TABLE OFFSET (little-endian uint64_t, not ULEB128 encoded)
+//    Offset of the function offset table from the first FUNCTION BODY in the
+//    file, stored in the last 8 bytes of the file.
 //===----------------------------------------------------------------------===//
 
 #ifndef LLVM_PROFILEDATA_SAMPLEPROFREADER_H
@@ -212,6 +249,7 @@
 #include "llvm/ADT/SmallVector.h"
 #include "llvm/ADT/StringMap.h"
 #include "llvm/ADT/StringRef.h"
+#include "llvm/ADT/StringSet.h"
 #include "llvm/ADT/Twine.h"
 #include "llvm/IR/DiagnosticInfo.h"
 #include "llvm/IR/Function.h"
@@ -227,6 +265,7 @@
 #include <memory>
 #include <string>
 #include <system_error>
+#include <utility>
 #include <vector>
 
 namespace llvm {
@@ -264,8 +303,9 @@ namespace sampleprof {
 /// compact and I/O efficient. They can both be used interchangeably.
 class SampleProfileReader {
 public:
-  SampleProfileReader(std::unique_ptr<MemoryBuffer> B, LLVMContext &C)
-      : Profiles(0), Ctx(C), Buffer(std::move(B)) {}
+  SampleProfileReader(std::unique_ptr<MemoryBuffer> B, LLVMContext &C,
+                      SampleProfileFormat Format = SPF_None)
+      : Profiles(0), Ctx(C), Buffer(std::move(B)), Format(Format) {}
 
   virtual ~SampleProfileReader() = default;
 
@@ -275,6 +315,11 @@ public:
   /// \brief Read sample profiles from the associated file.
   virtual std::error_code read() = 0;
 
+  /// \brief Restrict the profiles read by read() to the functions defined in
+  /// \p M, for the formats that can read the profile of a function on its
+  /// own. The other formats read all the profiles.
+  virtual void collectFuncsToUse(const Module &M) {}
+
   /// \brief Print the profile for \p FName on stream \p OS.
   void dumpFunctionProfile(StringRef FName, raw_ostream &OS = dbgs());
 
@@ -286,8 +331,11 @@ public:
     // The function name may have been updated by adding suffix. In sample
     // profile, the function names are all stripped, so we need to strip
     // the function name suffix before matching with profile.
-    if (Profiles.count(F.getName().split('.').first))
-      return &Profiles[(F.getName().split('.').first)];
+    std::string GUIDBuf;
+    auto It = Profiles.find(
+        getRepInFormat(F.getName().split('.').first, Format, GUIDBuf));
+    if (It != Profiles.end())
+      return &It->second;
     return nullptr;
   }
 
@@ -311,6 +359,9 @@ public:
   /// \brief Return the profile summary.
   ProfileSummary &getSummary() { return *(Summary.get()); }
 
+  /// \brief Return the format of the profile.
+  SampleProfileFormat getFormat() const { return Format; }
+
 protected:
   /// \brief Map every function to its associated profile.
   ///
@@ -330,12 +381,15 @@ protected:
 
   /// \brief Compute summary for this profile.
   void computeSummary();
+
+  /// \brief The format of the profile.
+  SampleProfileFormat Format;
 };
 
 class SampleProfileReaderText : public SampleProfileReader {
 public:
   SampleProfileReaderText(std::unique_ptr<MemoryBuffer> B, LLVMContext &C)
-      : SampleProfileReader(std::move(B), C) {}
+      : SampleProfileReader(std::move(B), C, SPF_Text) {}
 
   /// \brief Read and validate the file header.
   std::error_code readHeader() override { return sampleprof_error::success; }
@@ -349,8 +403,9 @@ public:
 
 class SampleProfileReaderBinary : public SampleProfileReader {
 public:
-  SampleProfileReaderBinary(std::unique_ptr<MemoryBuffer> B, LLVMContext &C)
-      : SampleProfileReader(std::move(B), C) {}
+  SampleProfileReaderBinary(std::unique_ptr<MemoryBuffer> B, LLVMContext &C,
+                            SampleProfileFormat Format = SPF_Binary)
+      : SampleProfileReader(std::move(B), C, Format) {}
 
   /// \brief Read and validate the file header.
   std::error_code readHeader() override;
@@ -387,6 +442,15 @@ protected:
   /// Read the contents of the given profile instance.
   std::error_code readProfile(FunctionSamples &FProfile);
 
+  /// Read the profile of the top-level function at the current location.
+  std::error_code readFuncProfile();
+
+  /// Check the magic identifier of the file.
+  virtual std::error_code verifySPMagic(uint64_t Magic);
+
+  /// Read the name table.
+  virtual std::error_code readNameTable();
+
   /// \brief Points to the current location in the buffer.
   const uint8_t *Data = nullptr;
 
@@ -403,6 +467,47 @@ private:
   std::error_code readSummary();
 };
 
+class SampleProfileReaderCompactBinary : public SampleProfileReaderBinary {
+public:
+  SampleProfileReaderCompactBinary(std::unique_ptr<MemoryBuffer> B,
+                                   LLVMContext &C)
+      : SampleProfileReaderBinary(std::move(B), C, SPF_Compact_Binary) {}
+
+  /// \brief Read and validate the file header, and the function offset table.
+  std::error_code readHeader() override;
+
+  /// \brief Read the profiles of the functions to use from the associated
+  /// file, or all the profiles if collectFuncsToUse() was not called.
+  std::error_code read() override;
+
+  /// \brief Only read the profiles of the functions defined in \p M.
+  void collectFuncsToUse(const Module &M) override;
+
+  /// \brief Return true if \p Buffer is in the format supported by this class.
+  static bool hasFormat(const MemoryBuffer &Buffer);
+
+private:
+  std::error_code verifySPMagic(uint64_t Magic) override;
+  std::error_code readNameTable() override;
+  std::error_code readFuncOffsetTable();
+
+  /// The decimal representations of the MD5 hashes in the name table, which
+  /// NameTable refers to.
+  std::vector<std::string> GUIDNames;
+
+  /// Points to the profile of the first function.
+  const uint8_t *ProfilesStart = nullptr;
+
+  /// The offset of the profile of each top-level function from
+  /// ProfilesStart.
+  std::vector<std::pair<StringRef, uint64_t>> FuncOffsetTable;
+
+  /// The names, in the profile's representation, of the functions whose
+  /// profiles are read, unless UseAllFuncs is set.
+  StringSet<> FuncsToUse;
+  bool UseAllFuncs = true;
+};
+
 using InlineCallStack = SmallVector<FunctionSamples *, 10>;
 
 // Supported histogram types in GCC.  Currently, we only need support for
@@ -421,7 +526,8 @@ enum HistType {
 class SampleProfileReaderGCC : public SampleProfileReader {
 public:
   SampleProfileReaderGCC(std::unique_ptr<MemoryBuffer> B, LLVMContext &C)
-      : SampleProfileReader(std::move(B), C), GcovBuffer(Buffer.get()) {}
+      : SampleProfileReader(std::move(B), C, SPF_GCC),
+        GcovBuffer(Buffer.get()) {}
 
   /// \brief Read and validate the file header.
   std::error_code readHeader() override;
@@ -24,12 +24,12 @@
 #include <cstdint>
 #include <memory>
 #include <system_error>
+#include <utility>
+#include <vector>
 
 namespace llvm {
 namespace sampleprof {
 
-enum SampleProfileFormat { SPF_None = 0, SPF_Text, SPF_Binary, SPF_GCC };
-
 /// \brief Sample-based profile writer. Base class.
 class SampleProfileWriter {
 public:
@@ -43,7 +43,7 @@ public:
   /// Write all the sample profiles in the given map of samples.
   ///
   /// \returns status code of the file update operation.
-  std::error_code write(const StringMap<FunctionSamples> &ProfileMap);
+  virtual std::error_code write(const StringMap<FunctionSamples> &ProfileMap);
 
   raw_ostream &getOutputStream() { return *OutputStream; }
 
@@ -105,22 +105,59 @@ private:
 class SampleProfileWriterBinary : public SampleProfileWriter {
 public:
   std::error_code write(const FunctionSamples &S) override;
+  using SampleProfileWriter::write;
 
 protected:
   SampleProfileWriterBinary(std::unique_ptr<raw_ostream> &OS)
       : SampleProfileWriter(OS) {}
 
+  virtual std::error_code writeMagicIdent();
+  virtual std::error_code writeNameTable();
   std::error_code
   writeHeader(const StringMap<FunctionSamples> &ProfileMap) override;
   std::error_code writeSummary();
   std::error_code writeNameIdx(StringRef FName);
   std::error_code writeBody(const FunctionSamples &S);
 
+  MapVector<StringRef, uint32_t> NameTable;
+
 private:
   void addName(StringRef FName);
   void addNames(const FunctionSamples &S);
 
-  MapVector<StringRef, uint32_t> NameTable;
+  friend ErrorOr<std::unique_ptr<SampleProfileWriter>>
+  SampleProfileWriter::create(std::unique_ptr<raw_ostream> &OS,
+                              SampleProfileFormat Format);
+};
+
+/// \brief Sample-based profile writer (compact binary format).
+///
+/// The name table holds the MD5 hashes of the function names instead of the
+/// names, and the profiles of the top-level functions are followed by a table
+/// of their offsets, so that a reader can load just the functions it needs.
+class SampleProfileWriterCompactBinary : public SampleProfileWriterBinary {
+public:
+  std::error_code write(const FunctionSamples &S) override;
+  std::error_code write(const StringMap<FunctionSamples> &ProfileMap) override;
+
+protected:
+  SampleProfileWriterCompactBinary(std::unique_ptr<raw_ostream> &OS)
+      : SampleProfileWriterBinary(OS) {}
+
+  std::error_code writeMagicIdent() override;
+  std::error_code writeNameTable() override;
+  std::error_code
+  writeHeader(const StringMap<FunctionSamples> &ProfileMap) override;
+
+private:
+  std::error_code writeFuncOffsetTable();
+
+  /// The stream position where the profiles of the functions start.
+  uint64_t ProfilesStart = 0;
+
+  /// The offset of the profile of each top-level function, relative to
+  /// ProfilesStart.
+  std::vector<std::pair<StringRef, uint64_t>> FuncOffsetTable;
 
   friend ErrorOr<std::unique_ptr<SampleProfileWriter>>
   SampleProfileWriter::create(std::unique_ptr<raw_ostream> &OS,
@@ -67,11 +67,25 @@ Expected<CachePruningPolicy> parseCachePruningPolicy(StringRef PolicyStr);
 /// Peform pruning using the supplied policy, returns true if pruning
 /// occured, i.e. if Policy.Interval was expired.
 ///
+/// When the cache has to shrink to meet the file count or size limits,
+/// entries are removed in increasing order of their recorded cost per byte
+/// (see recordCacheEntryCost()), so that the entries that save the least
+/// compile time for the space they take go first. Entries without a recorded
+/// cost are removed first, largest first.
+///
 /// As a safeguard against data loss if the user specifies the wrong directory
 /// as their cache directory, this function will ignore files not matching the
 /// pattern "llvmcache-*".
 bool pruneCache(StringRef Path, CachePruningPolicy Policy);
 
+/// Record that producing the cache entry \p EntryName (a file name matching
+/// "llvmcache-*") in the cache directory \p Path took \p Cost. The costs are
+/// appended to the "llvmcache.costs" file in the directory, which may be
+/// shared by several processes at once, and are used by pruneCache() to pick
+/// which entries to evict.
+void recordCacheEntryCost(StringRef Path, StringRef EntryName,
+                          std::chrono::milliseconds Cost);
+
 } // namespace llvm
 
 #endif
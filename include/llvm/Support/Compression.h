@@ -42,6 +42,25 @@ Error uncompress(StringRef InputBuffer,
                  SmallVectorImpl<char> &UncompressedBuffer,
                  size_t UncompressedSize);
 
+/// The size of the chunks compressParallel() splits its input into.
+const size_t DefaultParallelChunkSize = 1 << 20;
+
+/// Compresses \p InputBuffer like compress(), but if it is larger than
+/// \p ChunkSize, splits it into chunks of that size that are deflated
+/// independently and in parallel. Every chunk but the last ends with a sync
+/// flush, so the chunks form a single zlib stream that any zlib consumer can
+/// uncompress. The output does not depend on the number of threads.
+Error compressParallel(StringRef InputBuffer,
+                       SmallVectorImpl<char> &CompressedBuffer,
+                       CompressionLevel Level = DefaultCompression,
+                       size_t ChunkSize = DefaultParallelChunkSize);
+
+/// Uncompresses \p InputBuffer like uncompress(). If the stream was written
+/// by compressParallel(), its chunks are inflated in parallel; any other
+/// stream is uncompressed serially.
+Error uncompressParallel(StringRef InputBuffer, char *UncompressedBuffer,
+                         size_t &UncompressedSize);
+
 uint32_t crc32(StringRef Buffer);
 
 }  // End of namespace zlib
@@ -60,25 +60,40 @@ public:
     ++Count;
   }
 
-  void dec() {
+  /// Returns true if this brought the count to zero.
+  bool dec() {
     std::unique_lock<std::mutex> lock(Mutex);
-    if (--Count == 0)
-      Cond.notify_all();
+    if (--Count != 0)
+      return false;
+    Cond.notify_all();
+    return true;
   }
 
   void sync() const {
     std::unique_lock<std::mutex> lock(Mutex);
     Cond.wait(lock, [&] { return Count == 0; });
   }
+
+  bool isDone() const {
+    std::unique_lock<std::mutex> lock(Mutex);
+    return Count == 0;
+  }
 };
 
+/// \brief A group of tasks run on the shared work-stealing executor.
+///
+/// Groups may be nested: a pool thread waiting for a group in sync() keeps
+/// running other queued tasks, and only blocks while there are none, so e.g. a
+/// parallel_for_each whose body itself calls parallel_sort uses every core.
 class TaskGroup {
   Latch L;
 
 public:
+  ~TaskGroup() { sync(); }
+
   void spawn(std::function<void()> f);
 
-  void sync() const { L.sync(); }
+  void sync() const;
 };
 
 #if defined(_MSC_VER)
@@ -0,0 +1,92 @@
+//===- llvm/Support/TimeProfiler.h - Hierarchical Time Profiler -*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file declares a hierarchical time profiler that records the begin and
+// end of nested events, such as the run of a pass on a function, and writes
+// them in the Chrome Trace Event format, which can be viewed with
+// chrome://tracing or speedscope. Unlike Timer, which only accumulates totals,
+// it shows which invocation of a pass made a compile slow.
+//
+// The profiler is enabled per thread by timeTraceProfilerInitialize(); when it
+// is not enabled, a TimeTraceScope costs a single thread-local load.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_SUPPORT_TIMEPROFILER_H
+#define LLVM_SUPPORT_TIMEPROFILER_H
+
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Support/Compiler.h"
+#include "llvm/Support/Error.h"
+
+namespace llvm {
+
+class raw_ostream;
+struct TimeTraceProfiler;
+
+/// The profiler of the current thread, or null if it is not enabled.
+extern LLVM_THREAD_LOCAL TimeTraceProfiler *TimeTraceProfilerInstance;
+
+/// Enables the time trace profiler on the current thread. Events shorter than
+/// \p TimeTraceGranularity microseconds are not recorded, which keeps the
+/// traces of large compiles small. \p ProcName names the process in the
+/// trace.
+void timeTraceProfilerInitialize(unsigned TimeTraceGranularity,
+                                 StringRef ProcName);
+
+/// Disables the time trace profiler of the current thread and discards its
+/// events.
+void timeTraceProfilerCleanup();
+
+/// Returns whether the time trace profiler is enabled on the current thread.
+inline bool timeTraceProfilerEnabled() {
+  return TimeTraceProfilerInstance != nullptr;
+}
+
+/// Writes the recorded events to \p OS as Chrome Trace Event JSON. Besides
+/// the events themselves, the trace holds one "Total <name>" event per event
+/// name with the accumulated time of its outermost occurrences.
+void timeTraceProfilerWrite(raw_ostream &OS);
+
+/// Writes the recorded events to \p PreferredFileName, or, if it is empty, to
+/// \p FallbackFileName with ".time-trace" appended.
+Error timeTraceProfilerWrite(StringRef PreferredFileName,
+                             StringRef FallbackFileName);
+
+/// Begins an event named \p Name. \p Detail tells the instances of the event
+/// apart, e.g. it is the name of the function a pass runs on. Events must be
+/// ended in the reverse order in which they began.
+void timeTraceProfilerBegin(StringRef Name, StringRef Detail);
+
+/// Ends the innermost event that has begun.
+void timeTraceProfilerEnd();
+
+/// Records an event for the lifetime of the scope if the time trace profiler
+/// is enabled.
+class TimeTraceScope {
+  bool Active;
+
+public:
+  TimeTraceScope(StringRef Name, StringRef Detail = StringRef())
+      : Active(TimeTraceProfilerInstance != nullptr) {
+    if (Active)
+      timeTraceProfilerBegin(Name, Detail);
+  }
+  ~TimeTraceScope() {
+    if (Active)
+      timeTraceProfilerEnd();
+  }
+
+  TimeTraceScope(const TimeTraceScope &) = delete;
+  TimeTraceScope &operator=(const TimeTraceScope &) = delete;
+};
+
+} // end namespace llvm
+
+#endif // LLVM_SUPPORT_TIMEPROFILER_H
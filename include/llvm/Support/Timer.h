@@ -157,10 +157,18 @@ public:
 /// you to declare a new timer, AND specify the region to time, all in one
 /// statement.  All timers with the same name are merged.  This is primarily
 /// used for debugging and for hunting performance problems.
+///
+/// When the time trace profiler is enabled, the region is also recorded as a
+/// time trace event named after the Description, whether or not the timer
+/// itself is Enabled.
 struct NamedRegionTimer : public TimeRegion {
   explicit NamedRegionTimer(StringRef Name, StringRef Description,
                             StringRef GroupName,
                             StringRef GroupDescription, bool Enabled = true);
+  ~NamedRegionTimer();
+
+private:
+  bool InTimeTrace;
 };
 
 /// The TimerGroup class is used to group together related timers into a single
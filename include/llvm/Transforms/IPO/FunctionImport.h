@@ -17,6 +17,7 @@
 #include "llvm/IR/ModuleSummaryIndex.h"
 #include "llvm/IR/PassManager.h"
 #include "llvm/Support/Error.h"
+#include "llvm/Support/MemoryBuffer.h"
 #include <functional>
 #include <map>
 #include <memory>
@@ -24,10 +25,12 @@
 #include <system_error>
 #include <unordered_set>
 #include <utility>
+#include <vector>
 
 namespace llvm {
 
 class Module;
+class raw_ostream;
 
 /// The function importer is automatically importing function from other modules
 /// based on the provided summary informations.
@@ -90,6 +93,49 @@ void ComputeCrossModuleImport(
     StringMap<FunctionImporter::ImportMapTy> &ImportLists,
     StringMap<FunctionImporter::ExportSetTy> &ExportLists);
 
+/// The import lists computed by a previous link, kept so that the next link
+/// only has to recompute the imports of the modules affected by the changes
+/// to the index. See ComputeCrossModuleImportIncrementally().
+struct CrossModuleImportState {
+  struct ModuleState {
+    /// The hash of the module the imports were computed for, and its position
+    /// in the link, which decides the order of the summary lists.
+    ModuleHash Hash;
+    uint64_t ModuleId;
+    /// The sorted GUIDs of the globals the module defined, and of those of
+    /// them that were dead.
+    std::vector<GlobalValue::GUID> Defined, Dead;
+    /// The sorted GUIDs of every callee whose summaries were looked at while
+    /// computing the imports.
+    std::vector<GlobalValue::GUID> Examined;
+    FunctionImporter::ImportMapTy ImportList;
+  };
+
+  /// The values of the options that affect import decisions.
+  std::string OptionsKey;
+  StringMap<ModuleState> Modules;
+
+  /// Read a state written by write().
+  static Expected<CrossModuleImportState> read(MemoryBufferRef Buffer);
+
+  /// Write the state to \p OS.
+  void write(raw_ostream &OS) const;
+};
+
+/// Compute the same import and export lists as ComputeCrossModuleImport(),
+/// reusing the import list recorded in \p PrevState for every module that did
+/// not change and did not look at any value defined by a module that changed.
+/// The import lists of all modules are recorded in \p NewState. \p PrevState
+/// may be null, in which case everything is computed from scratch.
+///
+/// Returns the number of modules whose import lists were recomputed.
+unsigned ComputeCrossModuleImportIncrementally(
+    const ModuleSummaryIndex &Index,
+    const StringMap<GVSummaryMapTy> &ModuleToDefinedGVSummaries,
+    StringMap<FunctionImporter::ImportMapTy> &ImportLists,
+    StringMap<FunctionImporter::ExportSetTy> &ExportLists,
+    const CrossModuleImportState *PrevState, CrossModuleImportState &NewState);
+
 /// Compute all the imports for the given module using the Index.
 ///
 /// \p ImportList will be populated with a map that can be passed to
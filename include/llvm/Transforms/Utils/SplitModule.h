@@ -26,6 +26,11 @@ class Module;
 /// Splits the module M into N linkable partitions. The function ModuleCallback
 /// is called N times passing each individual partition as the MPart argument.
 ///
+/// By default, globals that do not need to be kept together are assigned to
+/// partitions by a hash of their names. If BalanceByCost is set, they are
+/// instead packed so that the partitions have about the same estimated
+/// code generation cost, which evens out the work of a parallel backend.
+///
 /// FIXME: This function does not deal with the somewhat subtle symbol
 /// visibility issues around module splitting, including (but not limited to):
 ///
@@ -36,7 +41,7 @@ class Module;
 void SplitModule(
     std::unique_ptr<Module> M, unsigned N,
     function_ref<void(std::unique_ptr<Module> MPart)> ModuleCallback,
-    bool PreserveLocals = false);
+    bool PreserveLocals = false, bool BalanceByCost = false);
 
 } // end namespace llvm
 
@@ -14,9 +14,12 @@
 #define LLVM_XRAY_TRACE_H
 
 #include <cstdint>
+#include <iterator>
+#include <memory>
 #include <vector>
 
 #include "llvm/ADT/StringRef.h"
+#include "llvm/ADT/iterator_range.h"
 #include "llvm/Support/Error.h"
 #include "llvm/Support/FileSystem.h"
 #include "llvm/XRay/XRayRecord.h"
@@ -65,6 +68,87 @@ public:
 /// |Filename|.
 Expected<Trace> loadTraceFile(StringRef Filename, bool Sort = false);
 
+/// A TraceReader decodes the records of an XRay trace file one at a time, in
+/// the order they appear in the file. Binary logs are memory mapped and decoded
+/// in place as the reader advances, so walking a trace this way takes memory
+/// independent of the number of records it contains. YAML traces are parsed
+/// up-front.
+///
+/// Usage:
+///
+///   auto ReaderOrErr = TraceReader::create("xray-log.something.xray");
+///   if (!ReaderOrErr)
+///     // Handle the error here.
+///   Error Err = Error::success();
+///   for (const XRayRecord &R : (*ReaderOrErr)->records(Err)) {
+///     // ... do something with R here.
+///   }
+///   if (Err)
+///     // Handle the error here.
+///
+class TraceReader {
+public:
+  /// Input iterator over the records of a TraceReader. Decoding errors end the
+  /// iteration and are reported through the Error passed to records().
+  class record_iterator {
+    TraceReader *Reader = nullptr;
+    Error *E = nullptr;
+    XRayRecord Record;
+
+    void advance();
+
+  public:
+    using iterator_category = std::input_iterator_tag;
+    using value_type = XRayRecord;
+    using difference_type = std::ptrdiff_t;
+    using pointer = const XRayRecord *;
+    using reference = const XRayRecord &;
+
+    record_iterator() = default;
+    record_iterator(TraceReader *Reader, Error *E) : Reader(Reader), E(E) {
+      advance();
+    }
+
+    const XRayRecord &operator*() const { return Record; }
+    const XRayRecord *operator->() const { return &Record; }
+
+    bool operator==(const record_iterator &Other) const {
+      return Reader == Other.Reader;
+    }
+    bool operator!=(const record_iterator &Other) const {
+      return !(*this == Other);
+    }
+
+    record_iterator &operator++() {
+      advance();
+      return *this;
+    }
+  };
+
+  /// Opens and memory maps \p Filename, detects its format and reads its file
+  /// header.
+  static Expected<std::unique_ptr<TraceReader>> create(StringRef Filename);
+
+  virtual ~TraceReader();
+
+  /// Provides access to the XRay trace file header.
+  const XRayFileHeader &getFileHeader() const { return FileHeader; }
+
+  /// Decodes the next record of the trace into \p Record. Returns false once
+  /// all records have been read.
+  virtual Expected<bool> readNextRecord(XRayRecord &Record) = 0;
+
+  /// Iterates over the records not read yet. Code iterating over the range
+  /// must check \p Err once the loop is done.
+  iterator_range<record_iterator> records(Error &Err) {
+    return make_range(record_iterator(this, &Err), record_iterator());
+  }
+
+protected:
+  XRayFileHeader FileHeader;
+  std::unique_ptr<sys::fs::mapped_file_region> MappedFile;
+};
+
 } // namespace xray
 } // namespace llvm
 
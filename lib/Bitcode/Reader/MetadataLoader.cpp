@@ -102,6 +102,12 @@ static cl::opt<bool> DisableLazyLoading(
     cl::desc("Force disable the lazy-loading on-demand of metadata when "
              "loading bitcode for importing."));
 
+static cl::opt<bool> OnDemandModuleMetadata(
+    "ondemand-module-mds-loading", cl::init(false), cl::Hidden,
+    cl::desc("Load module-level metadata on demand for every module, not only "
+             "when loading bitcode for importing. MDStrings stay in the "
+             "bitcode buffer until first referenced."));
+
 namespace {
 
 static int64_t unrotateSign(uint64_t U) { return U & 1 ? ~(U >> 1) : U >> 1; }
@@ -856,8 +862,10 @@ Error MetadataLoader::MetadataLoaderImpl::parseMetadata(bool ModuleLevel) {
 
   // We lazy-load module-level metadata: we build an index for each record, and
   // then load individual record as needed, starting with the named metadata.
-  if (ModuleLevel && IsImporting && MetadataList.empty() &&
-      !DisableLazyLoading) {
+  // Every node reachable from the module is loaded by the time it is fully
+  // materialized, so this is also valid outside of importing when requested.
+  if (ModuleLevel && (IsImporting || OnDemandModuleMetadata) &&
+      MetadataList.empty() && !DisableLazyLoading) {
     auto SuccessOrErr = lazyLoadModuleMetadataBlock();
     if (!SuccessOrErr)
       return SuccessOrErr.takeError();
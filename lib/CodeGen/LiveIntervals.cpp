@@ -20,6 +20,7 @@
 #include "llvm/ADT/DepthFirstIterator.h"
 #include "llvm/ADT/SmallPtrSet.h"
 #include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/Statistic.h"
 #include "llvm/ADT/iterator_range.h"
 #include "llvm/Analysis/AliasAnalysis.h"
 #include "llvm/CodeGen/LiveInterval.h"
@@ -57,6 +58,9 @@ using namespace llvm;
 
 #define DEBUG_TYPE "regalloc"
 
+STATISTIC(NumLiveRangeBytes,
+          "Number of bytes allocated for live ranges and value numbers");
+
 char LiveIntervals::ID = 0;
 char &llvm::LiveIntervalsID = LiveIntervals::ID;
 INITIALIZE_PASS_BEGIN(LiveIntervals, "liveintervals",
@@ -103,21 +107,30 @@ LiveIntervals::LiveIntervals() : MachineFunctionPass(ID) {
 
 LiveIntervals::~LiveIntervals() {
   delete LRCalc;
+  IntervalRecycler.clear(IntervalAllocator);
+  RegUnitRecycler.clear(IntervalAllocator);
 }
 
 void LiveIntervals::releaseMemory() {
-  // Free the live intervals themselves.
+  // Destroy the live intervals themselves. Their memory is released in bulk
+  // below.
   for (unsigned i = 0, e = VirtRegIntervals.size(); i != e; ++i)
-    delete VirtRegIntervals[TargetRegisterInfo::index2VirtReg(i)];
+    destroyInterval(VirtRegIntervals[TargetRegisterInfo::index2VirtReg(i)]);
   VirtRegIntervals.clear();
   RegMaskSlots.clear();
   RegMaskBits.clear();
   RegMaskBlocks.clear();
 
   for (LiveRange *LR : RegUnitRanges)
-    delete LR;
+    destroyRegUnit(LR);
   RegUnitRanges.clear();
 
+  NumLiveRangeBytes += IntervalAllocator.getBytesAllocated() +
+                       VNInfoAllocator.getBytesAllocated();
+  IntervalRecycler.clear(IntervalAllocator);
+  RegUnitRecycler.clear(IntervalAllocator);
+  IntervalAllocator.Reset();
+
   // Release VNInfo memory regions, VNInfo objects don't need to be dtor'd.
   VNInfoAllocator.Reset();
 }
@@ -187,7 +200,8 @@ LLVM_DUMP_METHOD void LiveIntervals::dumpInstrs() const {
 
 LiveInterval* LiveIntervals::createInterval(unsigned reg) {
   float Weight = TargetRegisterInfo::isPhysicalRegister(reg) ? huge_valf : 0.0F;
-  return new LiveInterval(reg, Weight);
+  return new (IntervalRecycler.Allocate(IntervalAllocator))
+      LiveInterval(reg, Weight);
 }
 
 /// Compute the live interval of a virtual register, based on defs and uses.
@@ -329,8 +343,7 @@ void LiveIntervals::computeLiveInRegUnits() {
         unsigned Unit = *Units;
         LiveRange *LR = RegUnitRanges[Unit];
         if (!LR) {
-          // Use segment set to speed-up initial computation of the live range.
-          LR = RegUnitRanges[Unit] = new LiveRange(UseSegmentSetForPhysRegs);
+          LR = createRegUnit(Unit);
           NewRanges.push_back(Unit);
         }
         VNInfo *VNI = LR->createDeadDef(Begin, getVNInfoAllocator());
@@ -20,6 +20,7 @@
 #include "llvm/ADT/STLExtras.h"
 #include "llvm/ADT/SmallString.h"
 #include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/Statistic.h"
 #include "llvm/ADT/StringRef.h"
 #include "llvm/ADT/Twine.h"
 #include "llvm/Analysis/ConstantFolding.h"
@@ -76,6 +77,9 @@ using namespace llvm;
 
 #define DEBUG_TYPE "codegen"
 
+STATISTIC(NumMachineFunctionBytes,
+          "Number of bytes allocated by machine functions");
+
 static cl::opt<unsigned>
 AlignAllFunctions("align-all-functions",
                   cl::desc("Force the alignment of all functions."),
@@ -188,6 +192,7 @@ MachineFunction::~MachineFunction() {
 }
 
 void MachineFunction::clear() {
+  NumMachineFunctionBytes += Allocator.getBytesAllocated();
   Properties.reset();
   // Don't call destructors on MachineInstr and MachineOperand. All of their
   // memory comes from the BumpPtrAllocator which is about to be purged.
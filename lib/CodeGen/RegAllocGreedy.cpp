@@ -72,6 +72,7 @@
 #include "llvm/Target/TargetMachine.h"
 #include <algorithm>
 #include <cassert>
+#include <chrono>
 #include <cstdint>
 #include <memory>
 #include <queue>
@@ -85,6 +86,8 @@ using namespace llvm;
 STATISTIC(NumGlobalSplits, "Number of split global live ranges");
 STATISTIC(NumLocalSplits,  "Number of split local live ranges");
 STATISTIC(NumEvicted,      "Number of interferences evicted");
+STATISTIC(NumIntfCacheHits, "Number of interference checks reused");
+STATISTIC(NumIntfCacheMisses, "Number of interference checks computed");
 
 static cl::opt<SplitEditor::ComplementSpillMode> SplitSpillMode(
     "split-spill-mode", cl::Hidden,
@@ -142,6 +145,33 @@ static RegisterRegAlloc greedyRegAlloc("greedy", "greedy register allocator",
 
 namespace {
 
+/// Wall time and number of invocations of one allocator phase. Reported as an
+/// analysis remark when remarks are enabled for the allocator.
+struct PhaseStats {
+  std::chrono::nanoseconds Time{0};
+  unsigned Count = 0;
+};
+
+/// Accumulate the time spent in a scope into a PhaseStats. Unlike
+/// NamedRegionTimer this is cheap enough to be keyed off remark emission.
+class PhaseTimer {
+  PhaseStats *Stats;
+  std::chrono::steady_clock::time_point Start;
+
+public:
+  PhaseTimer(PhaseStats &S, bool Enabled) : Stats(Enabled ? &S : nullptr) {
+    if (Stats)
+      Start = std::chrono::steady_clock::now();
+  }
+
+  ~PhaseTimer() {
+    if (!Stats)
+      return;
+    Stats->Time += std::chrono::steady_clock::now() - Start;
+    ++Stats->Count;
+  }
+};
+
 class RAGreedy : public MachineFunctionPass,
                  public RegAllocBase,
                  private LiveRangeEdit::Delegate {
@@ -256,6 +286,40 @@ class RAGreedy : public MachineFunctionPass,
     ExtraRegInfo[VirtReg.reg].Stage = Stage;
   }
 
+  // Bumped whenever a live range is modified. Cached interference results
+  // for older versions are stale. This is kept apart from ExtraRegInfo, whose
+  // size tells LRE_DidCloneVirtReg which registers the allocator has seen.
+  IndexedMap<unsigned, VirtReg2IndexFunctor> RangeVersions;
+
+  void bumpVersion(unsigned Reg) {
+    RangeVersions.grow(Reg);
+    ++RangeVersions[Reg];
+  }
+
+  /// Fixed (register mask or register unit) interference found for a
+  /// (VirtReg, PhysReg) pair, together with the state it was computed from.
+  /// Unlike virtual register interference, this doesn't change when other
+  /// live ranges are assigned or evicted, so it stays valid across eviction
+  /// and splitting rounds as long as VirtReg and the fixed register unit
+  /// ranges are unchanged.
+  struct CachedInterference {
+    unsigned Version;
+    SlotIndex Begin, End;
+    size_t NumSegments;
+    size_t RegUnitSegments;
+    LiveRegMatrix::InterferenceKind Kind;
+  };
+
+  DenseMap<std::pair<unsigned, unsigned>, CachedInterference> IntfResults;
+
+  LiveRegMatrix::InterferenceKind checkInterference(LiveInterval &VirtReg,
+                                                    unsigned PhysReg);
+
+  // Per-function phase timings, collected when analysis remarks are enabled.
+  bool TimePhases;
+  PhaseStats EvictStats, LocalSplitStats, GlobalSplitStats, SpillStats,
+      SpillWeightStats;
+
   template<typename Iterator>
   void setStage(Iterator Begin, Iterator End, LiveRangeStage NewStage) {
     ExtraRegInfo.resize(MRI->getNumVirtRegs());
@@ -540,6 +604,9 @@ private:
                                    FoldedSpills);
     }
   }
+
+  /// Report the time spent in each allocator phase for the function.
+  void reportPhaseTimes();
 };
 
 } // end anonymous namespace
@@ -622,6 +689,7 @@ void RAGreedy::getAnalysisUsage(AnalysisUsage &AU) const {
 
 bool RAGreedy::LRE_CanEraseVirtReg(unsigned VirtReg) {
   LiveInterval &LI = LIS->getInterval(VirtReg);
+  bumpVersion(VirtReg);
   if (VRM->hasPhys(VirtReg)) {
     Matrix->unassign(LI);
     aboutToRemoveInterval(LI);
@@ -636,6 +704,7 @@ bool RAGreedy::LRE_CanEraseVirtReg(unsigned VirtReg) {
 }
 
 void RAGreedy::LRE_WillShrinkVirtReg(unsigned VirtReg) {
+  bumpVersion(VirtReg);
   if (!VRM->hasPhys(VirtReg))
     return;
 
@@ -646,6 +715,8 @@ void RAGreedy::LRE_WillShrinkVirtReg(unsigned VirtReg) {
 }
 
 void RAGreedy::LRE_DidCloneVirtReg(unsigned New, unsigned Old) {
+  bumpVersion(Old);
+
   // Cloning a register we haven't even heard about yet?  Just ignore it.
   if (!ExtraRegInfo.inBounds(Old))
     return;
@@ -663,6 +734,8 @@ void RAGreedy::releaseMemory() {
   SpillerInstance.reset();
   ExtraRegInfo.clear();
   GlobalCand.clear();
+  IntfResults.clear();
+  RangeVersions.clear();
 }
 
 void RAGreedy::enqueue(LiveInterval *LI) { enqueue(Queue, LI); }
@@ -741,6 +814,60 @@ LiveInterval *RAGreedy::dequeue(PQueue &CurQueue) {
   return LI;
 }
 
+//===----------------------------------------------------------------------===//
+//                        Interference Result Cache
+//===----------------------------------------------------------------------===//
+
+/// checkInterference - Like LiveRegMatrix::checkInterference, but reuse fixed
+/// interference found by an earlier query when neither VirtReg nor the fixed
+/// live ranges of PhysReg changed since.
+///
+/// Free and virtual register results are always recomputed: the matrix
+/// queries they leave behind are read by later eviction checks.
+LiveRegMatrix::InterferenceKind
+RAGreedy::checkInterference(LiveInterval &VirtReg, unsigned PhysReg) {
+  // Fixed register unit ranges can only shrink during allocation (when dead
+  // defs are erased), so the total number of segments changes whenever they
+  // do. Compute any missing ranges first so that the interference query
+  // below can't change the count.
+  size_t RegUnitSegments = 0;
+  for (MCRegUnitIterator Units(PhysReg, TRI); Units.isValid(); ++Units)
+    RegUnitSegments += LIS->getRegUnit(*Units).size();
+
+  RangeVersions.grow(VirtReg.reg);
+  unsigned Version = RangeVersions[VirtReg.reg];
+  SlotIndex Begin = VirtReg.empty() ? SlotIndex() : VirtReg.beginIndex();
+  SlotIndex End = VirtReg.empty() ? SlotIndex() : VirtReg.endIndex();
+
+  auto I = IntfResults.find(std::make_pair(VirtReg.reg, PhysReg));
+  if (I != IntfResults.end()) {
+    const CachedInterference &C = I->second;
+    if (C.Version == Version && C.Begin == Begin && C.End == End &&
+        C.NumSegments == VirtReg.size() &&
+        C.RegUnitSegments == RegUnitSegments) {
+      ++NumIntfCacheHits;
+#ifdef EXPENSIVE_CHECKS
+      assert(Matrix->checkInterference(VirtReg, PhysReg) == C.Kind &&
+             "Stale interference cache entry");
+#endif
+      return C.Kind;
+    }
+  }
+
+  ++NumIntfCacheMisses;
+  LiveRegMatrix::InterferenceKind Kind =
+      Matrix->checkInterference(VirtReg, PhysReg);
+  if (Kind <= LiveRegMatrix::IK_VirtReg) {
+    if (I != IntfResults.end())
+      IntfResults.erase(I);
+    return Kind;
+  }
+
+  IntfResults[std::make_pair(VirtReg.reg, PhysReg)] = {
+      Version, Begin, End, VirtReg.size(), RegUnitSegments, Kind};
+  return Kind;
+}
+
 //===----------------------------------------------------------------------===//
 //                            Direct Assignment
 //===----------------------------------------------------------------------===//
@@ -752,7 +879,7 @@ unsigned RAGreedy::tryAssign(LiveInterval &VirtReg,
   Order.rewind();
   unsigned PhysReg;
   while ((PhysReg = Order.next()))
-    if (!Matrix->checkInterference(VirtReg, PhysReg))
+    if (!checkInterference(VirtReg, PhysReg))
       break;
   if (!PhysReg || Order.isHint())
     return PhysReg;
@@ -858,7 +985,7 @@ bool RAGreedy::shouldEvict(LiveInterval &A, bool IsHint,
 bool RAGreedy::canEvictInterference(LiveInterval &VirtReg, unsigned PhysReg,
                                     bool IsHint, EvictionCost &MaxCost) {
   // It is only possible to evict virtual register interference.
-  if (Matrix->checkInterference(VirtReg, PhysReg) > LiveRegMatrix::IK_VirtReg)
+  if (checkInterference(VirtReg, PhysReg) > LiveRegMatrix::IK_VirtReg)
     return false;
 
   bool IsLocal = LIS->intervalIsInOneMBB(VirtReg);
@@ -1087,6 +1214,7 @@ unsigned RAGreedy::tryEvict(LiveInterval &VirtReg,
                             unsigned CostPerUseLimit) {
   NamedRegionTimer T("evict", "Evict", TimerGroupName, TimerGroupDescription,
                      TimePassesIsEnabled);
+  PhaseTimer PT(EvictStats, TimePhases);
 
   // Keep track of the cheapest interference seen so far.
   EvictionCost BestCost;
@@ -2341,6 +2469,7 @@ unsigned RAGreedy::trySplit(LiveInterval &VirtReg, AllocationOrder &Order,
   if (LIS->intervalIsInOneMBB(VirtReg)) {
     NamedRegionTimer T("local_split", "Local Splitting", TimerGroupName,
                        TimerGroupDescription, TimePassesIsEnabled);
+    PhaseTimer PT(LocalSplitStats, TimePhases);
     SA->analyze(&VirtReg);
     unsigned PhysReg = tryLocalSplit(VirtReg, Order, NewVRegs);
     if (PhysReg || !NewVRegs.empty())
@@ -2350,6 +2479,7 @@ unsigned RAGreedy::trySplit(LiveInterval &VirtReg, AllocationOrder &Order,
 
   NamedRegionTimer T("global_split", "Global Splitting", TimerGroupName,
                      TimerGroupDescription, TimePassesIsEnabled);
+  PhaseTimer PT(GlobalSplitStats, TimePhases);
 
   SA->analyze(&VirtReg);
 
@@ -2360,6 +2490,7 @@ unsigned RAGreedy::trySplit(LiveInterval &VirtReg, AllocationOrder &Order,
   if (SA->didRepairRange()) {
     // VirtReg has changed, so all cached queries are invalid.
     Matrix->invalidateVirtRegs();
+    bumpVersion(VirtReg.reg);
     if (unsigned PhysReg = tryAssign(VirtReg, Order, NewVRegs))
       return PhysReg;
   }
@@ -2989,6 +3120,7 @@ unsigned RAGreedy::selectOrSplitImpl(LiveInterval &VirtReg,
   } else {
     NamedRegionTimer T("spill", "Spiller", TimerGroupName,
                        TimerGroupDescription, TimePassesIsEnabled);
+    PhaseTimer PT(SpillStats, TimePhases);
     LiveRangeEdit LRE(&VirtReg, NewVRegs, *MF, *LIS, VRM, this, &DeadRemats);
     spiller().spill(LRE);
     setStage(NewVRegs.begin(), NewVRegs.end(), RS_Done);
@@ -3069,6 +3201,32 @@ void RAGreedy::reportNumberOfSplillsReloads(MachineLoop *L, unsigned &Reloads,
   }
 }
 
+void RAGreedy::reportPhaseTimes() {
+  if (!TimePhases)
+    return;
+
+  using namespace ore;
+  auto Micros = [](const PhaseStats &S) {
+    return (unsigned long long)
+        std::chrono::duration_cast<std::chrono::microseconds>(S.Time).count();
+  };
+  ORE->emit([&]() {
+    MachineOptimizationRemarkAnalysis R(DEBUG_TYPE, "RegAllocTime",
+                                        DebugLoc(), &MF->front());
+    R << "register allocation spent " << NV("EvictTime", Micros(EvictStats))
+      << "us in " << NV("NumEvict", EvictStats.Count) << " evictions, "
+      << NV("LocalSplitTime", Micros(LocalSplitStats)) << "us in "
+      << NV("NumLocalSplit", LocalSplitStats.Count) << " local splits, "
+      << NV("GlobalSplitTime", Micros(GlobalSplitStats)) << "us in "
+      << NV("NumGlobalSplit", GlobalSplitStats.Count) << " global splits, "
+      << NV("SpillTime", Micros(SpillStats)) << "us in "
+      << NV("NumSpill", SpillStats.Count) << " spills and "
+      << NV("SpillWeightTime", Micros(SpillWeightStats))
+      << "us computing spill weights";
+    return R;
+  });
+}
+
 bool RAGreedy::runOnMachineFunction(MachineFunction &mf) {
   DEBUG(dbgs() << "********** GREEDY REGISTER ALLOCATION **********\n"
                << "********** Function: " << mf.getName() << '\n');
@@ -3104,7 +3262,16 @@ bool RAGreedy::runOnMachineFunction(MachineFunction &mf) {
 
   initializeCSRCost();
 
-  calculateSpillWeightsAndHints(*LIS, mf, VRM, *Loops, *MBFI);
+  TimePhases = ORE->allowExtraAnalysis(DEBUG_TYPE);
+  EvictStats = LocalSplitStats = GlobalSplitStats = SpillStats =
+      SpillWeightStats = PhaseStats();
+  IntfResults.clear();
+  RangeVersions.clear();
+
+  {
+    PhaseTimer PT(SpillWeightStats, TimePhases);
+    calculateSpillWeightsAndHints(*LIS, mf, VRM, *Loops, *MBFI);
+  }
 
   DEBUG(LIS->dump());
 
@@ -3122,6 +3289,7 @@ bool RAGreedy::runOnMachineFunction(MachineFunction &mf) {
   tryHintsRecoloring();
   postOptimization();
   reportNumberOfSplillsReloads();
+  reportPhaseTimes();
 
   releaseMemory();
   return true;
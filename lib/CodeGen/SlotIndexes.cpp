@@ -23,6 +23,7 @@ INITIALIZE_PASS(SlotIndexes, DEBUG_TYPE,
 
 STATISTIC(NumLocalRenum,  "Number of local renumberings");
 STATISTIC(NumGlobalRenum, "Number of global renumberings");
+STATISTIC(NumIndexListBytes, "Number of bytes allocated for index lists");
 
 void SlotIndexes::getAnalysisUsage(AnalysisUsage &au) const {
   au.setPreservesAll();
@@ -34,6 +35,7 @@ void SlotIndexes::releaseMemory() {
   MBBRanges.clear();
   idx2MBBMap.clear();
   indexList.clear();
+  NumIndexListBytes += ileAllocator.getBytesAllocated();
   ileAllocator.Reset();
 }
 
@@ -17,6 +17,7 @@
 #include "llvm/Support/DataExtractor.h"
 #include "llvm/Support/Format.h"
 #include "llvm/Support/raw_ostream.h"
+#include <algorithm>
 #include <cstddef>
 #include <cstdint>
 
@@ -30,6 +31,7 @@ void DWARFAbbreviationDeclaration::clear() {
   HasChildren = false;
   AttributeSpecs.clear();
   FixedAttributeSize.reset();
+  FixedAttributeOffsets.clear();
 }
 
 DWARFAbbreviationDeclaration::DWARFAbbreviationDeclaration() {
@@ -63,6 +65,10 @@ DWARFAbbreviationDeclaration::extract(DataExtractor Data,
     auto A = static_cast<Attribute>(Data.getULEB128(OffsetPtr));
     auto F = static_cast<Form>(Data.getULEB128(OffsetPtr));
     if (A && F) {
+      // While all the previous attributes have a fixed byte size, so does the
+      // offset of this one.
+      if (FixedAttributeSize)
+        FixedAttributeOffsets.push_back(*FixedAttributeSize);
       bool IsImplicitConst = (F == DW_FORM_implicit_const);
       if (IsImplicitConst) {
         int64_t V = Data.getSLEB128(OffsetPtr);
@@ -176,7 +182,14 @@ Optional<DWARFFormValue> DWARFAbbreviationDeclaration::getAttributeValue(
   // skipping the attribute data.
   uint32_t Offset = DIEOffset + CodeByteSize;
   uint32_t AttrIndex = 0;
-  for (const auto &Spec : AttributeSpecs) {
+  // Jump over as many attributes as have a fixed offset.
+  if (!FixedAttributeOffsets.empty()) {
+    AttrIndex = std::min<uint32_t>(*MatchAttrIndex,
+                                   FixedAttributeOffsets.size() - 1);
+    Offset += FixedAttributeOffsets[AttrIndex].getByteSize(U);
+  }
+  for (uint32_t E = AttributeSpecs.size(); AttrIndex != E; ++AttrIndex) {
+    const AttributeSpec &Spec = AttributeSpecs[AttrIndex];
     if (*MatchAttrIndex == AttrIndex) {
       // We have arrived at the attribute to extract, extract if from Offset.
       DWARFFormValue FormValue(Spec.Form);
@@ -193,7 +206,6 @@ Optional<DWARFFormValue> DWARFAbbreviationDeclaration::getAttributeValue(
     else
       DWARFFormValue::skipValue(Spec.Form, DebugInfoData, &Offset,
                                 U.getFormParams());
-    ++AttrIndex;
   }
   return None;
 }
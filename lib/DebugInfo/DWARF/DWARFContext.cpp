@@ -41,6 +41,7 @@
 #include "llvm/Support/Error.h"
 #include "llvm/Support/Format.h"
 #include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/Parallel.h"
 #include "llvm/Support/Path.h"
 #include "llvm/Support/TargetRegistry.h"
 #include "llvm/Support/raw_ostream.h"
@@ -226,6 +227,18 @@ buildLineToUnitMap(DWARFContext::cu_iterator_range CUs,
   return LineToUnit;
 }
 
+/// Extract the DIEs of all \p CUs on multiple threads. Extracting a unit only
+/// touches that unit, except for the lookup of its abbreviation set in the
+/// shared, lazily populated DWARFDebugAbbrev, so do that up front.
+static void extractDIEsInParallel(DWARFContext::cu_iterator_range CUs) {
+  for (const auto &CU : CUs)
+    CU->getAbbreviations();
+  parallel::for_each(parallel::par, CUs.begin(), CUs.end(),
+                     [](const std::unique_ptr<DWARFCompileUnit> &CU) {
+                       CU->getUnitDIE(/*ExtractUnitDIEOnly=*/false);
+                     });
+}
+
 void DWARFContext::dump(
     raw_ostream &OS, DIDumpOptions DumpOpts,
     std::array<Optional<uint64_t>, DIDT_ID_Count> DumpOffsets) {
@@ -270,9 +283,11 @@ void DWARFContext::dump(
       if (DumpOffset)
         getDIEForOffset(DumpOffset.getValue())
             .dump(OS, 0, DumpOpts.noImplicitRecursion());
-      else
+      else {
+        extractDIEsInParallel(CUs);
         for (const auto &CU : CUs)
           CU->dump(OS, DumpOpts);
+      }
     }
   };
   dumpDebugInfo(Explicit, ".debug_info", DObj->getInfoSection(),
@@ -994,6 +1009,7 @@ DWARFContext::getDWOContext(StringRef AbsolutePath) {
   auto S = std::make_shared<DWOFile>();
   S->File = std::move(Obj.get());
   S->Context = DWARFContext::create(*S->File.getBinary());
+  S->Context->setLazyDIEExtraction(LazyDIEExtraction);
   *Entry = S;
   auto *Ctxt = S->Context.get();
   return std::shared_ptr<DWARFContext>(std::move(S), Ctxt);
@@ -12,6 +12,7 @@
 #include "llvm/DebugInfo/DWARF/DWARFContext.h"
 #include "llvm/DebugInfo/DWARF/DWARFDebugArangeSet.h"
 #include "llvm/Support/DataExtractor.h"
+#include "llvm/Support/Parallel.h"
 #include <algorithm>
 #include <cassert>
 #include <cstdint>
@@ -19,6 +20,7 @@
 #include <vector>
 
 using namespace llvm;
+using namespace dwarf;
 
 void DWARFDebugAranges::extract(DataExtractor DebugArangesData) {
   if (!DebugArangesData.isValidOffset(0))
@@ -50,15 +52,34 @@ void DWARFDebugAranges::generate(DWARFContext *CTX) {
   // Generate aranges from DIEs: even if .debug_aranges section is present,
   // it may describe only a small subset of compilation units, so we need to
   // manually build aranges for the rest of them.
-  for (const auto &CU : CTX->compile_units()) {
-    uint32_t CUOffset = CU->getOffset();
-    if (ParsedCUOffsets.insert(CUOffset).second) {
-      DWARFAddressRangesVector CURanges;
-      CU->collectAddressRanges(CURanges);
-      for (const auto &R : CURanges)
-        appendRange(CUOffset, R.LowPC, R.HighPC);
-    }
+  std::vector<DWARFCompileUnit *> CUs;
+  for (const auto &CU : CTX->compile_units())
+    if (ParsedCUOffsets.insert(CU->getOffset()).second)
+      CUs.push_back(CU.get());
+
+  // Collecting the ranges of a unit parses its DIEs, which only touches that
+  // unit, except for the lookup of its abbreviation set in the shared
+  // DWARFDebugAbbrev and for the .dwo files loaded through the context. Do
+  // the former up front and handle split units on this thread, so that the
+  // remaining units can be parsed in parallel.
+  std::vector<DWARFAddressRangesVector> CURanges(CUs.size());
+  std::vector<size_t> SplitCUs;
+  for (size_t I = 0, E = CUs.size(); I != E; ++I) {
+    CUs[I]->getAbbreviations();
+    if (CUs[I]->getUnitDIE().find(DW_AT_GNU_dwo_name))
+      SplitCUs.push_back(I);
   }
+  parallel::for_each_n(parallel::par, size_t(0), CUs.size(), [&](size_t I) {
+    if (!std::binary_search(SplitCUs.begin(), SplitCUs.end(), I))
+      CUs[I]->collectAddressRanges(CURanges[I]);
+  });
+  for (size_t I : SplitCUs)
+    CUs[I]->collectAddressRanges(CURanges[I]);
+
+  // Append the ranges in unit order so the result matches a serial build.
+  for (size_t I = 0, E = CUs.size(); I != E; ++I)
+    for (const auto &R : CURanges[I])
+      appendRange(CUs[I]->getOffset(), R.LowPC, R.HighPC);
 
   construct();
 }
@@ -8,7 +8,9 @@
 //===----------------------------------------------------------------------===//
 
 #include "llvm/DebugInfo/DWARF/DWARFUnit.h"
+#include "llvm/ADT/STLExtras.h"
 #include "llvm/ADT/SmallString.h"
+#include "llvm/ADT/SmallVector.h"
 #include "llvm/ADT/StringRef.h"
 #include "llvm/DebugInfo/DWARF/DWARFAbbreviationDeclaration.h"
 #include "llvm/DebugInfo/DWARF/DWARFContext.h"
@@ -161,6 +163,12 @@ void DWARFUnit::clear() {
   RangeSectionBase = 0;
   AddrOffsetSectionBase = 0;
   clearDIEs(false);
+  DieSubtrees.clear();
+  HasLazyIndex = false;
+  TopLevelDIEOffsets.clear();
+  SubprogramRanges.clear();
+  NumSubprogramSubtrees = 0;
+  NumSubtreesInAddrDieMap = 0;
   DWO.reset();
 }
 
@@ -311,6 +319,131 @@ void DWARFUnit::clearDIEs(bool KeepCUDie) {
   }
 }
 
+bool DWARFUnit::isExtractingLazily() const {
+  return Context.getLazyDIEExtraction() &&
+         (HasLazyIndex || DieArray.size() <= 1);
+}
+
+void DWARFUnit::buildLazyIndexIfNeeded() {
+  if (HasLazyIndex)
+    return;
+  HasLazyIndex = true;
+  // The unit DIE is needed to read address ranges.
+  if (!getUnitDIE())
+    return;
+
+  uint32_t DIEOffset = Offset + getHeaderSize();
+  uint32_t NextCUOffset = getNextUnitOffset();
+  DWARFDebugInfoEntry DIE;
+  DWARFDataExtractor DebugInfoData = getDebugInfoExtractor();
+  uint32_t Depth = 0;
+  uint32_t RootOffset = 0;
+  while (DIE.extractFast(*this, &DIEOffset, DebugInfoData, NextCUOffset,
+                         Depth)) {
+    const DWARFAbbreviationDeclaration *AbbrDecl =
+        DIE.getAbbreviationDeclarationPtr();
+    if (!AbbrDecl) {
+      // NULL DIE.
+      if (Depth > 0)
+        --Depth;
+      if (Depth == 0)
+        break;
+      continue;
+    }
+    if (Depth == 1) {
+      RootOffset = DIE.getOffset();
+      TopLevelDIEOffsets.push_back(RootOffset);
+    }
+    // The DIE only lives until the next one is extracted, which is all that
+    // reading its attributes needs.
+    if (Depth > 0 && AbbrDecl->getTag() == DW_TAG_subprogram)
+      for (const auto &R : DWARFDie(this, &DIE).getAddressRanges()) {
+        // The ranges of a subtree are contiguous before sorting.
+        if (SubprogramRanges.empty() ||
+            SubprogramRanges.back().RootOffset != RootOffset)
+          ++NumSubprogramSubtrees;
+        SubprogramRanges.push_back({R, RootOffset, 0});
+      }
+    if (AbbrDecl->hasChildren())
+      ++Depth;
+    else if (Depth == 0)
+      break;
+  }
+
+  std::stable_sort(SubprogramRanges.begin(), SubprogramRanges.end(),
+                   [](const SubprogramRange &LHS, const SubprogramRange &RHS) {
+                     return LHS.Range.LowPC < RHS.Range.LowPC;
+                   });
+  uint64_t MaxHighPC = 0;
+  for (SubprogramRange &R : SubprogramRanges)
+    R.MaxHighPC = MaxHighPC = std::max(MaxHighPC, R.Range.HighPC);
+}
+
+DWARFUnit::DIESubtree &DWARFUnit::extractSubtreeIfNeeded(uint32_t RootOffset) {
+  DIESubtree &Subtree = DieSubtrees[RootOffset];
+  if (!Subtree.Dies.empty())
+    return Subtree;
+
+  uint32_t DIEOffset = RootOffset;
+  uint32_t NextCUOffset = getNextUnitOffset();
+  DWARFDebugInfoEntry DIE;
+  DWARFDataExtractor DebugInfoData = getDebugInfoExtractor();
+  uint32_t Depth = 1;
+  while (DIE.extractFast(*this, &DIEOffset, DebugInfoData, NextCUOffset,
+                         Depth)) {
+    Subtree.Dies.push_back(DIE);
+    if (const DWARFAbbreviationDeclaration *AbbrDecl =
+            DIE.getAbbreviationDeclarationPtr()) {
+      if (AbbrDecl->hasChildren())
+        ++Depth;
+    } else {
+      --Depth;
+    }
+    // We are done when we are back at the depth of the root.
+    if (Depth <= 1)
+      break;
+  }
+  return Subtree;
+}
+
+ArrayRef<DWARFDebugInfoEntry>
+DWARFUnit::getDIEArrayFor(const DWARFDebugInfoEntry *Die) const {
+  if (!DieArray.empty() && Die >= DieArray.data() &&
+      Die < DieArray.data() + DieArray.size())
+    return DieArray;
+  auto It = DieSubtrees.upper_bound(Die->getOffset());
+  assert(It != DieSubtrees.begin() && "DIE is not part of this unit");
+  return (--It)->second.Dies;
+}
+
+DWARFDie DWARFUnit::getDIEForOffset(uint32_t Offset) {
+  ArrayRef<DWARFDebugInfoEntry> Dies;
+  if (isExtractingLazily()) {
+    buildLazyIndexIfNeeded();
+    DWARFDie UnitDie = getUnitDIE();
+    if (UnitDie && UnitDie.getOffset() == Offset)
+      return UnitDie;
+    // Find the child of the unit DIE whose subtree contains Offset.
+    auto It = std::upper_bound(TopLevelDIEOffsets.begin(),
+                               TopLevelDIEOffsets.end(), Offset);
+    if (It == TopLevelDIEOffsets.begin())
+      return DWARFDie();
+    Dies = extractSubtreeIfNeeded(*--It).Dies;
+  } else {
+    extractDIEsIfNeeded(false);
+    assert(!DieArray.empty());
+    Dies = DieArray;
+  }
+  auto it = std::lower_bound(
+      Dies.begin(), Dies.end(), Offset,
+      [](const DWARFDebugInfoEntry &LHS, uint32_t Offset) {
+        return LHS.getOffset() < Offset;
+      });
+  if (it != Dies.end() && it->getOffset() == Offset)
+    return DWARFDie(this, &*it);
+  return DWARFDie();
+}
+
 void DWARFUnit::collectAddressRanges(DWARFAddressRangesVector &CURanges) {
   DWARFDie UnitDie = getUnitDIE();
   if (!UnitDie)
@@ -327,9 +460,17 @@ void DWARFUnit::collectAddressRanges(DWARFAddressRangesVector &CURanges) {
   // is accurate. If the DIEs weren't parsed, then we don't want all dies for
   // all compile units to stay loaded when they weren't needed. So we can end
   // up parsing the DWARF and then throwing them all away to keep memory usage
-  // down.
-  const bool ClearDIEs = extractDIEsIfNeeded(false) > 1;
-  getUnitDIE().collectChildrenAddressRanges(CURanges);
+  // down. When extracting lazily, the ranges of the subprograms are part of
+  // the lazy index, so no DIEs are kept at all.
+  bool ClearDIEs = false;
+  if (isExtractingLazily()) {
+    buildLazyIndexIfNeeded();
+    for (const SubprogramRange &R : SubprogramRanges)
+      CURanges.push_back(R.Range);
+  } else {
+    ClearDIEs = extractDIEsIfNeeded(false) > 1;
+    getUnitDIE().collectChildrenAddressRanges(CURanges);
+  }
 
   // Collect address ranges from DIEs in .dwo if necessary.
   bool DWOCreated = parseDWO();
@@ -372,9 +513,39 @@ void DWARFUnit::updateAddressDieMap(DWARFDie Die) {
 }
 
 DWARFDie DWARFUnit::getSubroutineForAddress(uint64_t Address) {
-  extractDIEsIfNeeded(false);
-  if (AddrDieMap.empty())
-    updateAddressDieMap(getUnitDIE());
+  if (isExtractingLazily()) {
+    // Only add the subtrees with a subprogram covering Address to the map.
+    buildLazyIndexIfNeeded();
+    if (NumSubtreesInAddrDieMap != NumSubprogramSubtrees) {
+      // The ranges covering Address start at or before it, and walking back
+      // from the last of those can stop at the first range whose MaxHighPC
+      // shows that neither it nor any range before it reaches Address.
+      auto It = std::upper_bound(
+          SubprogramRanges.begin(), SubprogramRanges.end(), Address,
+          [](uint64_t Address, const SubprogramRange &R) {
+            return Address < R.Range.LowPC;
+          });
+      SmallVector<uint32_t, 4> RootOffsets;
+      while (It != SubprogramRanges.begin() && (--It)->MaxHighPC > Address)
+        if (Address < It->Range.HighPC)
+          RootOffsets.push_back(It->RootOffset);
+      // Add the subtrees in the order of their ranges, like a forward scan.
+      for (uint32_t RootOffset : reverse(RootOffsets)) {
+        DIESubtree &Subtree = extractSubtreeIfNeeded(RootOffset);
+        if (Subtree.InAddrDieMap)
+          continue;
+        Subtree.InAddrDieMap = true;
+        ++NumSubtreesInAddrDieMap;
+        // A corrupt subtree may have no DIEs at all.
+        if (!Subtree.Dies.empty())
+          updateAddressDieMap(DWARFDie(this, &Subtree.Dies[0]));
+      }
+    }
+  } else {
+    extractDIEsIfNeeded(false);
+    if (AddrDieMap.empty())
+      updateAddressDieMap(getUnitDIE());
+  }
   auto R = AddrDieMap.upper_bound(Address);
   if (R == AddrDieMap.begin())
     return DWARFDie();
@@ -423,9 +594,10 @@ DWARFDie DWARFUnit::getParent(const DWARFDebugInfoEntry *Die) {
     return getUnitDIE();
   // Look for previous DIE with a depth that is one less than the Die's depth.
   const uint32_t ParentDepth = Depth - 1;
-  for (uint32_t I = getDIEIndex(Die) - 1; I > 0; --I) {
-    if (DieArray[I].getDepth() == ParentDepth)
-      return DWARFDie(this, &DieArray[I]);
+  ArrayRef<DWARFDebugInfoEntry> Dies = getDIEArrayFor(Die);
+  for (uint32_t I = Die - Dies.data(); I > 0; --I) {
+    if (Dies[I - 1].getDepth() == ParentDepth)
+      return DWARFDie(this, &Dies[I - 1]);
   }
   return DWARFDie();
 }
@@ -441,11 +613,24 @@ DWARFDie DWARFUnit::getSibling(const DWARFDebugInfoEntry *Die) {
   if (Die->getAbbreviationDeclarationPtr() == nullptr)
     return DWARFDie();
 
+  ArrayRef<DWARFDebugInfoEntry> Dies = getDIEArrayFor(Die);
+  // The sibling of the root of a subtree is the root of the next one.
+  if (Depth == 1 && Dies.data() != DieArray.data()) {
+    auto It = std::upper_bound(TopLevelDIEOffsets.begin(),
+                               TopLevelDIEOffsets.end(), Die->getOffset());
+    if (It == TopLevelDIEOffsets.end())
+      return DWARFDie();
+    const DIESubtree &Next = extractSubtreeIfNeeded(*It);
+    if (Next.Dies.empty())
+      return DWARFDie();
+    return DWARFDie(this, &Next.Dies[0]);
+  }
+
   // Find the next DIE whose depth is the same as the Die's depth.
-  for (size_t I = getDIEIndex(Die) + 1, EndIdx = DieArray.size(); I < EndIdx;
+  for (size_t I = Die - Dies.data() + 1, EndIdx = Dies.size(); I < EndIdx;
        ++I) {
-    if (DieArray[I].getDepth() == Depth)
-      return DWARFDie(this, &DieArray[I]);
+    if (Dies[I].getDepth() == Depth)
+      return DWARFDie(this, &Dies[I]);
   }
   return DWARFDie();
 }
@@ -454,11 +639,23 @@ DWARFDie DWARFUnit::getFirstChild(const DWARFDebugInfoEntry *Die) {
   if (!Die->hasChildren())
     return DWARFDie();
 
+  // The first child of the unit DIE is the root of the first subtree.
+  if (Die->getDepth() == 0 && DieArray.size() == 1 && isExtractingLazily()) {
+    buildLazyIndexIfNeeded();
+    if (TopLevelDIEOffsets.empty())
+      return DWARFDie();
+    const DIESubtree &First = extractSubtreeIfNeeded(TopLevelDIEOffsets[0]);
+    if (First.Dies.empty())
+      return DWARFDie();
+    return DWARFDie(this, &First.Dies[0]);
+  }
+
   // We do not want access out of bounds when parsing corrupted debug data.
-  size_t I = getDIEIndex(Die) + 1;
-  if (I >= DieArray.size())
+  ArrayRef<DWARFDebugInfoEntry> Dies = getDIEArrayFor(Die);
+  size_t I = Die - Dies.data() + 1;
+  if (I >= Dies.size())
     return DWARFDie();
-  return DWARFDie(this, &DieArray[I]);
+  return DWARFDie(this, &Dies[I]);
 }
 
 const DWARFAbbreviationDeclarationSet *DWARFUnit::getAbbreviations() const {
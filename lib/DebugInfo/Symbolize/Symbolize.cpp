@@ -15,6 +15,7 @@
 
 #include "SymbolizableObjectFile.h"
 
+#include "llvm/ADT/Optional.h"
 #include "llvm/ADT/STLExtras.h"
 #include "llvm/BinaryFormat/COFF.h"
 #include "llvm/Config/config.h"
@@ -30,11 +31,14 @@
 #include "llvm/Support/Errc.h"
 #include "llvm/Support/FileSystem.h"
 #include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/Parallel.h"
 #include "llvm/Support/Path.h"
 #include <algorithm>
 #include <cassert>
 #include <cstdlib>
 #include <cstring>
+#include <numeric>
+#include <tuple>
 
 #if defined(_MSC_VER)
 #include <Windows.h>
@@ -52,6 +56,53 @@
 namespace llvm {
 namespace symbolize {
 
+DILineInfo LLVMSymbolizer::symbolizeCodeInModule(SymbolizableModule *Info,
+                                                 uint64_t ModuleOffset) {
+  // If the user is giving us relative addresses, add the preferred base of the
+  // object to the offset before we do the query. It's what DIContext expects.
+  if (Opts.RelativeAddresses)
+    ModuleOffset += Info->getModulePreferredBase();
+
+  DILineInfo LineInfo = Info->symbolizeCode(ModuleOffset, Opts.PrintFunctions,
+                                            Opts.UseSymbolTable);
+  if (Opts.Demangle)
+    LineInfo.FunctionName = DemangleName(LineInfo.FunctionName, Info);
+  return LineInfo;
+}
+
+DIInliningInfo
+LLVMSymbolizer::symbolizeInlinedCodeInModule(SymbolizableModule *Info,
+                                             uint64_t ModuleOffset) {
+  // If the user is giving us relative addresses, add the preferred base of the
+  // object to the offset before we do the query. It's what DIContext expects.
+  if (Opts.RelativeAddresses)
+    ModuleOffset += Info->getModulePreferredBase();
+
+  DIInliningInfo InlinedContext = Info->symbolizeInlinedCode(
+      ModuleOffset, Opts.PrintFunctions, Opts.UseSymbolTable);
+  if (Opts.Demangle) {
+    for (int i = 0, n = InlinedContext.getNumberOfFrames(); i < n; i++) {
+      auto *Frame = InlinedContext.getMutableFrame(i);
+      Frame->FunctionName = DemangleName(Frame->FunctionName, Info);
+    }
+  }
+  return InlinedContext;
+}
+
+DIGlobal LLVMSymbolizer::symbolizeDataInModule(SymbolizableModule *Info,
+                                               uint64_t ModuleOffset) {
+  // If the user is giving us relative addresses, add the preferred base of
+  // the object to the offset before we do the query. It's what DIContext
+  // expects.
+  if (Opts.RelativeAddresses)
+    ModuleOffset += Info->getModulePreferredBase();
+
+  DIGlobal Global = Info->symbolizeData(ModuleOffset);
+  if (Opts.Demangle)
+    Global.Name = DemangleName(Global.Name, Info);
+  return Global;
+}
+
 Expected<DILineInfo>
 LLVMSymbolizer::symbolizeCode(const std::string &ModuleName,
                               uint64_t ModuleOffset, StringRef DWPName) {
@@ -66,16 +117,7 @@ LLVMSymbolizer::symbolizeCode(const std::string &ModuleName,
   if (!Info)
     return DILineInfo();
 
-  // If the user is giving us relative addresses, add the preferred base of the
-  // object to the offset before we do the query. It's what DIContext expects.
-  if (Opts.RelativeAddresses)
-    ModuleOffset += Info->getModulePreferredBase();
-
-  DILineInfo LineInfo = Info->symbolizeCode(ModuleOffset, Opts.PrintFunctions,
-                                            Opts.UseSymbolTable);
-  if (Opts.Demangle)
-    LineInfo.FunctionName = DemangleName(LineInfo.FunctionName, Info);
-  return LineInfo;
+  return symbolizeCodeInModule(Info, ModuleOffset);
 }
 
 Expected<DIInliningInfo>
@@ -92,20 +134,7 @@ LLVMSymbolizer::symbolizeInlinedCode(const std::string &ModuleName,
   if (!Info)
     return DIInliningInfo();
 
-  // If the user is giving us relative addresses, add the preferred base of the
-  // object to the offset before we do the query. It's what DIContext expects.
-  if (Opts.RelativeAddresses)
-    ModuleOffset += Info->getModulePreferredBase();
-
-  DIInliningInfo InlinedContext = Info->symbolizeInlinedCode(
-      ModuleOffset, Opts.PrintFunctions, Opts.UseSymbolTable);
-  if (Opts.Demangle) {
-    for (int i = 0, n = InlinedContext.getNumberOfFrames(); i < n; i++) {
-      auto *Frame = InlinedContext.getMutableFrame(i);
-      Frame->FunctionName = DemangleName(Frame->FunctionName, Info);
-    }
-  }
-  return InlinedContext;
+  return symbolizeInlinedCodeInModule(Info, ModuleOffset);
 }
 
 Expected<DIGlobal> LLVMSymbolizer::symbolizeData(const std::string &ModuleName,
@@ -121,23 +150,164 @@ Expected<DIGlobal> LLVMSymbolizer::symbolizeData(const std::string &ModuleName,
   if (!Info)
     return DIGlobal();
 
-  // If the user is giving us relative addresses, add the preferred base of
-  // the object to the offset before we do the query. It's what DIContext
-  // expects.
-  if (Opts.RelativeAddresses)
-    ModuleOffset += Info->getModulePreferredBase();
+  return symbolizeDataInModule(Info, ModuleOffset);
+}
 
-  DIGlobal Global = Info->symbolizeData(ModuleOffset);
-  if (Opts.Demangle)
-    Global.Name = DemangleName(Global.Name, Info);
-  return Global;
+template <typename T, typename FnT>
+std::vector<Expected<T>>
+LLVMSymbolizer::symbolizeBatch(ArrayRef<Request> Requests, StringRef DWPName,
+                               FnT Symbolize) {
+  // Sort the requests by module and offset, so that each module is looked up
+  // once and its debug info is walked in address order.
+  std::vector<size_t> Order(Requests.size());
+  std::iota(Order.begin(), Order.end(), 0);
+  std::stable_sort(Order.begin(), Order.end(), [&](size_t L, size_t R) {
+    return std::tie(Requests[L].ModuleName, Requests[L].ModuleOffset) <
+           std::tie(Requests[R].ModuleName, Requests[R].ModuleOffset);
+  });
+
+  // Split the sorted requests into one group per module.
+  std::vector<std::pair<size_t, size_t>> Groups;
+  for (size_t I = 0, E = Order.size(); I != E;) {
+    size_t J = I + 1;
+    while (J != E &&
+           Requests[Order[J]].ModuleName == Requests[Order[I]].ModuleName)
+      ++J;
+    Groups.emplace_back(I, J);
+    I = J;
+  }
+
+  // Modules are only evicted between batches, so that the modules of this
+  // batch stay alive while they are used.
+  {
+    std::lock_guard<std::mutex> Lock(Mutex);
+    pruneModuleCache();
+  }
+
+  // Each module is used by a single thread, as the debug info of a module is
+  // parsed lazily and is not thread-safe.
+  std::vector<Optional<Expected<T>>> Results(Requests.size());
+  parallel::for_each_n(parallel::par, size_t(0), Groups.size(), [&](size_t G) {
+    auto Begin = Order.begin() + Groups[G].first;
+    auto End = Order.begin() + Groups[G].second;
+    Expected<SymbolizableModule *> InfoOrErr = [&] {
+      std::lock_guard<std::mutex> Lock(Mutex);
+      Statistics.NumRequests += End - Begin;
+      return getOrCreateModuleInfoImpl(Requests[*Begin].ModuleName, DWPName);
+    }();
+
+    // As when symbolizing the requests one by one, a module that fails to
+    // load reports the error for the first request only.
+    SymbolizableModule *Info = nullptr;
+    if (InfoOrErr)
+      Info = *InfoOrErr;
+    else
+      Results[*std::min_element(Begin, End)] =
+          Expected<T>(InfoOrErr.takeError());
+    for (auto I = Begin; I != End; ++I) {
+      if (Results[*I])
+        continue;
+      // A null module means an error has already been reported. Return an
+      // empty result.
+      if (Info)
+        Results[*I] = Expected<T>(Symbolize(Info, Requests[*I].ModuleOffset));
+      else
+        Results[*I] = Expected<T>(T());
+    }
+  });
+
+  std::vector<Expected<T>> Ret;
+  Ret.reserve(Results.size());
+  for (Optional<Expected<T>> &Result : Results)
+    Ret.push_back(std::move(*Result));
+  return Ret;
+}
+
+std::vector<Expected<DILineInfo>>
+LLVMSymbolizer::symbolizeCode(ArrayRef<Request> Requests, StringRef DWPName) {
+  return symbolizeBatch<DILineInfo>(
+      Requests, DWPName, [&](SymbolizableModule *Info, uint64_t Offset) {
+        return symbolizeCodeInModule(Info, Offset);
+      });
+}
+
+std::vector<Expected<DIInliningInfo>>
+LLVMSymbolizer::symbolizeInlinedCode(ArrayRef<Request> Requests,
+                                     StringRef DWPName) {
+  return symbolizeBatch<DIInliningInfo>(
+      Requests, DWPName, [&](SymbolizableModule *Info, uint64_t Offset) {
+        return symbolizeInlinedCodeInModule(Info, Offset);
+      });
+}
+
+std::vector<Expected<DIGlobal>>
+LLVMSymbolizer::symbolizeData(ArrayRef<Request> Requests) {
+  return symbolizeBatch<DIGlobal>(
+      Requests, "", [&](SymbolizableModule *Info, uint64_t Offset) {
+        return symbolizeDataInModule(Info, Offset);
+      });
 }
 
 void LLVMSymbolizer::flush() {
+  std::lock_guard<std::mutex> Lock(Mutex);
   ObjectForUBPathAndArch.clear();
   BinaryForPath.clear();
   ObjectPairForPathArch.clear();
   Modules.clear();
+  ModuleLRU.clear();
+  Statistics.CacheSize = 0;
+}
+
+LLVMSymbolizer::Stats LLVMSymbolizer::getStats() {
+  std::lock_guard<std::mutex> Lock(Mutex);
+  return Statistics;
+}
+
+void LLVMSymbolizer::pruneModuleCache() {
+  if (!Opts.MaxCacheSize)
+    return;
+  while (Statistics.CacheSize > Opts.MaxCacheSize && !ModuleLRU.empty()) {
+    auto I = Modules.find(ModuleLRU.front());
+    assert(I != Modules.end() && "module missing from the cache");
+    CachedModule Evicted = std::move(I->second);
+    Modules.erase(I);
+    ModuleLRU.pop_front();
+    Statistics.CacheSize -= Evicted.Size;
+    ++Statistics.NumEvictions;
+
+    // Release the binaries of the module unless another module uses them.
+    Evicted.Module.reset();
+    for (const std::string &Path : Evicted.BinaryPaths) {
+      bool InUse = any_of(Modules, [&](const decltype(Modules)::value_type &M) {
+        return is_contained(M.second.BinaryPaths, Path);
+      });
+      if (!InUse)
+        releaseBinary(Path);
+    }
+  }
+}
+
+void LLVMSymbolizer::releaseBinary(const std::string &Path) {
+  // Drop the object pairs referring to objects of the binary before the
+  // objects themselves.
+  for (auto I = ObjectPairForPathArch.begin(),
+            E = ObjectPairForPathArch.end();
+       I != E;) {
+    const ObjectFile *DbgObj = I->second.second;
+    if (I->first.first == Path || (DbgObj && DbgObj->getFileName() == Path))
+      I = ObjectPairForPathArch.erase(I);
+    else
+      ++I;
+  }
+  for (auto I = ObjectForUBPathAndArch.begin(),
+            E = ObjectForUBPathAndArch.end();
+       I != E;) {
+    if (I->first.first == Path)
+      I = ObjectForUBPathAndArch.erase(I);
+    else
+      ++I;
+  }
+  BinaryForPath.erase(Path);
 }
 
 namespace {
@@ -366,10 +536,39 @@ LLVMSymbolizer::getOrCreateObject(const std::string &Path,
 Expected<SymbolizableModule *>
 LLVMSymbolizer::getOrCreateModuleInfo(const std::string &ModuleName,
                                       StringRef DWPName) {
+  std::lock_guard<std::mutex> Lock(Mutex);
+  pruneModuleCache();
+  ++Statistics.NumRequests;
+  return getOrCreateModuleInfoImpl(ModuleName, DWPName);
+}
+
+Expected<SymbolizableModule *>
+LLVMSymbolizer::getOrCreateModuleInfoImpl(const std::string &ModuleName,
+                                          StringRef DWPName) {
   const auto &I = Modules.find(ModuleName);
   if (I != Modules.end()) {
-    return I->second.get();
+    ++Statistics.NumCacheHits;
+    ModuleLRU.splice(ModuleLRU.end(), ModuleLRU, I->second.LRUPos);
+    return I->second.Module.get();
   }
+  ++Statistics.NumCacheMisses;
+
+  // Adds the module to the cache, accounting for the object files backing it.
+  auto InsertModule = [&](std::unique_ptr<SymbolizableModule> Module,
+                          ObjectPair Objects) {
+    CachedModule &Entry = Modules[ModuleName];
+    Entry.Module = std::move(Module);
+    for (ObjectFile *Obj : {Objects.first, Objects.second}) {
+      if (!Obj || is_contained(Entry.BinaryPaths, Obj->getFileName()))
+        continue;
+      Entry.Size += Obj->getData().size();
+      Entry.BinaryPaths.push_back(Obj->getFileName());
+    }
+    Entry.LRUPos = ModuleLRU.insert(ModuleLRU.end(), ModuleName);
+    Statistics.CacheSize += Entry.Size;
+    return Entry.Module.get();
+  };
+
   std::string BinaryName = ModuleName;
   std::string ArchName = Opts.DefaultArch;
   size_t ColonPos = ModuleName.find_last_of(':');
@@ -384,8 +583,7 @@ LLVMSymbolizer::getOrCreateModuleInfo(const std::string &ModuleName,
   auto ObjectsOrErr = getOrCreateObjectPair(BinaryName, ArchName);
   if (!ObjectsOrErr) {
     // Failed to find valid object file.
-    Modules.insert(
-        std::make_pair(ModuleName, std::unique_ptr<SymbolizableModule>()));
+    InsertModule(nullptr, ObjectPair(nullptr, nullptr));
     return ObjectsOrErr.takeError();
   }
   ObjectPair Objects = ObjectsOrErr.get();
@@ -402,28 +600,30 @@ LLVMSymbolizer::getOrCreateModuleInfo(const std::string &ModuleName,
       std::unique_ptr<IPDBSession> Session;
       if (auto Err = loadDataForEXE(PDB_ReaderType::DIA,
                                     Objects.first->getFileName(), Session)) {
-        Modules.insert(
-            std::make_pair(ModuleName, std::unique_ptr<SymbolizableModule>()));
+        InsertModule(nullptr, Objects);
         return std::move(Err);
       }
       Context.reset(new PDBContext(*CoffObject, std::move(Session)));
     }
   }
-  if (!Context)
-    Context = DWARFContext::create(*Objects.second, nullptr,
-                                   DWARFContext::defaultErrorHandler, DWPName);
+  if (!Context) {
+    auto DICtx = DWARFContext::create(*Objects.second, nullptr,
+                                      DWARFContext::defaultErrorHandler,
+                                      DWPName);
+    // Symbolization only needs the DIEs of the functions it looks up.
+    DICtx->setLazyDIEExtraction(true);
+    Context = std::move(DICtx);
+  }
   assert(Context);
   auto InfoOrErr =
       SymbolizableObjectFile::create(Objects.first, std::move(Context));
   std::unique_ptr<SymbolizableModule> SymMod;
   if (InfoOrErr)
     SymMod = std::move(InfoOrErr.get());
-  auto InsertResult =
-      Modules.insert(std::make_pair(ModuleName, std::move(SymMod)));
-  assert(InsertResult.second);
+  SymbolizableModule *Module = InsertModule(std::move(SymMod), Objects);
   if (auto EC = InfoOrErr.getError())
     return errorCodeToError(EC);
-  return InsertResult.first->second.get();
+  return Module;
 }
 
 namespace {
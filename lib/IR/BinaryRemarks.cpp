@@ -0,0 +1,276 @@
+//===- BinaryRemarks.cpp - Binary optimization remarks --------------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file implements the writer and the reader of the binary optimization
+// remark format.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/IR/BinaryRemarks.h"
+#include "llvm/IR/DiagnosticInfo.h"
+#include "llvm/IR/Function.h"
+#include "llvm/IR/GlobalValue.h"
+#include "llvm/Support/ErrorHandling.h"
+#include "llvm/Support/LEB128.h"
+#include "llvm/Support/raw_ostream.h"
+#include <vector>
+
+using namespace llvm;
+
+static const char Magic[] = {'R', 'M', 'R', 'K'};
+static const uint64_t Version = 1;
+
+namespace {
+enum RecordTag : uint8_t { StringTag = 1, RemarkTag = 2 };
+} // end anonymous namespace
+
+static RemarkType getRemarkType(const DiagnosticInfoOptimizationBase &Diag) {
+  switch (Diag.getKind()) {
+  case DK_OptimizationRemark:
+  case DK_MachineOptimizationRemark:
+    return RemarkType::Passed;
+  case DK_OptimizationRemarkMissed:
+  case DK_MachineOptimizationRemarkMissed:
+    return RemarkType::Missed;
+  case DK_OptimizationRemarkAnalysis:
+  case DK_MachineOptimizationRemarkAnalysis:
+    return RemarkType::Analysis;
+  case DK_OptimizationRemarkAnalysisFPCommute:
+    return RemarkType::AnalysisFPCommute;
+  case DK_OptimizationRemarkAnalysisAliasing:
+    return RemarkType::AnalysisAliasing;
+  case DK_OptimizationFailure:
+    return RemarkType::Failure;
+  default:
+    llvm_unreachable("Unknown remark type");
+  }
+}
+
+BinaryRemarkWriter::BinaryRemarkWriter(raw_ostream &OS) : OS(OS) {
+  OS.write(Magic, sizeof(Magic));
+  encodeULEB128(Version, OS);
+}
+
+unsigned BinaryRemarkWriter::getStringID(StringRef S) {
+  auto Insertion = StringIDs.insert({S, StringIDs.size()});
+  if (Insertion.second) {
+    OS << char(StringTag);
+    encodeULEB128(S.size(), OS);
+    OS << S;
+  }
+  return Insertion.first->second;
+}
+
+void BinaryRemarkWriter::writeLocation(const DiagnosticLocation &Loc) {
+  if (!Loc.isValid()) {
+    encodeULEB128(0, OS);
+    return;
+  }
+  encodeULEB128(getStringID(Loc.getFilename()) + 1, OS);
+  encodeULEB128(Loc.getLine(), OS);
+  encodeULEB128(Loc.getColumn(), OS);
+}
+
+void BinaryRemarkWriter::write(const DiagnosticInfoOptimizationBase &Diag) {
+  DiagnosticLocation Loc = Diag.getLocation();
+  StringRef FunctionName =
+      GlobalValue::dropLLVMManglingEscape(Diag.getFunction().getName());
+  ArrayRef<DiagnosticInfoOptimizationBase::Argument> Args = Diag.getArgs();
+
+  // The remark record can only refer to strings that were written before it,
+  // so write the new strings first.
+  getStringID(Diag.getPassName());
+  getStringID(Diag.getRemarkName());
+  getStringID(FunctionName);
+  if (Loc.isValid())
+    getStringID(Loc.getFilename());
+  for (const DiagnosticInfoOptimizationBase::Argument &Arg : Args) {
+    getStringID(Arg.Key);
+    getStringID(Arg.Val);
+    if (Arg.Loc.isValid())
+      getStringID(Arg.Loc.getFilename());
+  }
+
+  OS << char(RemarkTag);
+  encodeULEB128(static_cast<uint8_t>(getRemarkType(Diag)), OS);
+  encodeULEB128(getStringID(Diag.getPassName()), OS);
+  encodeULEB128(getStringID(Diag.getRemarkName()), OS);
+  encodeULEB128(getStringID(FunctionName), OS);
+  writeLocation(Loc);
+  Optional<uint64_t> Hotness = Diag.getHotness();
+  OS << char(Hotness.hasValue());
+  if (Hotness)
+    encodeULEB128(*Hotness, OS);
+  encodeULEB128(Args.size(), OS);
+  for (const DiagnosticInfoOptimizationBase::Argument &Arg : Args) {
+    encodeULEB128(getStringID(Arg.Key), OS);
+    encodeULEB128(getStringID(Arg.Val), OS);
+    writeLocation(Arg.Loc);
+  }
+}
+
+bool llvm::isBinaryRemarks(StringRef Buffer) {
+  return Buffer.startswith(StringRef(Magic, sizeof(Magic)));
+}
+
+namespace {
+
+/// Reads the records of a binary remark file.
+class BinaryRemarkReader {
+  const uint8_t *Ptr;
+  const uint8_t *End;
+
+  /// The strings read so far, indexed by their number.
+  std::vector<StringRef> Strings;
+
+  /// The remark being read, which is reused to keep its argument storage.
+  Remark R;
+
+  static Error malformed(const Twine &Message) {
+    return make_error<StringError>("malformed binary remarks: " + Message,
+                                   inconvertibleErrorCode());
+  }
+
+  Error readULEB128(uint64_t &Value) {
+    unsigned N;
+    const char *Message;
+    Value = decodeULEB128(Ptr, &N, End, &Message);
+    if (Message)
+      return malformed(Message);
+    Ptr += N;
+    return Error::success();
+  }
+
+  Error readString(StringRef &S) {
+    uint64_t ID;
+    if (Error E = readULEB128(ID))
+      return E;
+    if (ID >= Strings.size())
+      return malformed("unknown string " + Twine(ID));
+    S = Strings[ID];
+    return Error::success();
+  }
+
+  Error readLocation(Optional<RemarkLocation> &Loc) {
+    uint64_t File, Line, Column;
+    if (Error E = readULEB128(File))
+      return E;
+    if (File == 0) {
+      Loc = None;
+      return Error::success();
+    }
+    if (File > Strings.size())
+      return malformed("unknown string " + Twine(File - 1));
+    if (Error E = readULEB128(Line))
+      return E;
+    if (Error E = readULEB128(Column))
+      return E;
+    Loc = RemarkLocation();
+    Loc->File = Strings[File - 1];
+    Loc->Line = Line;
+    Loc->Column = Column;
+    return Error::success();
+  }
+
+  Error readStringRecord() {
+    uint64_t Size;
+    if (Error E = readULEB128(Size))
+      return E;
+    if (Size > uint64_t(End - Ptr))
+      return malformed("string extends past end");
+    Strings.emplace_back(reinterpret_cast<const char *>(Ptr), Size);
+    Ptr += Size;
+    return Error::success();
+  }
+
+  Error readRemarkRecord() {
+    uint64_t Type;
+    if (Error E = readULEB128(Type))
+      return E;
+    if (Type > static_cast<uint8_t>(RemarkType::Failure))
+      return malformed("unknown remark type " + Twine(Type));
+    R.Type = static_cast<RemarkType>(Type);
+    if (Error E = readString(R.PassName))
+      return E;
+    if (Error E = readString(R.RemarkName))
+      return E;
+    if (Error E = readString(R.FunctionName))
+      return E;
+    if (Error E = readLocation(R.Loc))
+      return E;
+
+    if (Ptr == End)
+      return malformed("remark extends past end");
+    R.Hotness = None;
+    if (*Ptr++) {
+      uint64_t Hotness;
+      if (Error E = readULEB128(Hotness))
+        return E;
+      R.Hotness = Hotness;
+    }
+
+    uint64_t NumArgs;
+    if (Error E = readULEB128(NumArgs))
+      return E;
+    R.Args.clear();
+    for (uint64_t I = 0; I != NumArgs; ++I) {
+      R.Args.emplace_back();
+      RemarkArgument &Arg = R.Args.back();
+      if (Error E = readString(Arg.Key))
+        return E;
+      if (Error E = readString(Arg.Val))
+        return E;
+      if (Error E = readLocation(Arg.Loc))
+        return E;
+    }
+    return Error::success();
+  }
+
+public:
+  explicit BinaryRemarkReader(StringRef Buffer)
+      : Ptr(reinterpret_cast<const uint8_t *>(Buffer.data())),
+        End(Ptr + Buffer.size()) {}
+
+  Error read(function_ref<void(const Remark &)> Callback) {
+    if (size_t(End - Ptr) < sizeof(Magic) ||
+        !isBinaryRemarks(
+            StringRef(reinterpret_cast<const char *>(Ptr), sizeof(Magic))))
+      return malformed("invalid magic");
+    Ptr += sizeof(Magic);
+    uint64_t FileVersion;
+    if (Error E = readULEB128(FileVersion))
+      return E;
+    if (FileVersion != Version)
+      return malformed("unsupported version " + Twine(FileVersion));
+
+    while (Ptr != End) {
+      switch (*Ptr++) {
+      case StringTag:
+        if (Error E = readStringRecord())
+          return E;
+        break;
+      case RemarkTag:
+        if (Error E = readRemarkRecord())
+          return E;
+        Callback(R);
+        break;
+      default:
+        return malformed("unknown record tag " + Twine(unsigned(Ptr[-1])));
+      }
+    }
+    return Error::success();
+  }
+};
+
+} // end anonymous namespace
+
+Error llvm::readBinaryRemarks(StringRef Buffer,
+                              function_ref<void(const Remark &)> Callback) {
+  return BinaryRemarkReader(Buffer).read(Callback);
+}
@@ -18,6 +18,7 @@
 #include "llvm/ADT/StringMap.h"
 #include "llvm/ADT/StringRef.h"
 #include "llvm/ADT/Twine.h"
+#include "llvm/IR/BinaryRemarks.h"
 #include "llvm/IR/DiagnosticInfo.h"
 #include "llvm/IR/DiagnosticPrinter.h"
 #include "llvm/IR/Metadata.h"
@@ -167,6 +168,19 @@ void LLVMContext::setDiagnosticsOutputFile(std::unique_ptr<yaml::Output> F) {
   pImpl->DiagnosticsOutputFile = std::move(F);
 }
 
+BinaryRemarkWriter *LLVMContext::getDiagnosticsBinaryOutputFile() {
+  return pImpl->DiagnosticsBinaryOutputFile.get();
+}
+
+void LLVMContext::setDiagnosticsBinaryOutputFile(
+    std::unique_ptr<BinaryRemarkWriter> W) {
+  pImpl->DiagnosticsBinaryOutputFile = std::move(W);
+}
+
+bool LLVMContext::hasDiagnosticsOutputFile() {
+  return pImpl->DiagnosticsOutputFile || pImpl->DiagnosticsBinaryOutputFile;
+}
+
 DiagnosticHandler::DiagnosticHandlerTy
 LLVMContext::getDiagnosticHandlerCallBack() const {
   return pImpl->DiagHandler->DiagHandlerCallback;
@@ -234,6 +248,8 @@ void LLVMContext::diagnose(const DiagnosticInfo &DI) {
       auto *P = const_cast<DiagnosticInfoOptimizationBase *>(OptDiagBase);
       *Out << P;
     }
+    if (BinaryRemarkWriter *W = getDiagnosticsBinaryOutputFile())
+      W->write(*OptDiagBase);
   }
   // If there is a report handler, use it.
   if (pImpl->DiagHandler &&
@@ -0,0 +1,563 @@
+//===- ModuleSummaryIndexTable.cpp - Summary index lookup tables ----------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file implements the reader and writer of summary tables.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/IR/ModuleSummaryIndexTable.h"
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/Support/raw_ostream.h"
+#include <algorithm>
+#include <vector>
+
+using namespace llvm;
+using namespace summarytab;
+
+static uint32_t encodeGVFlags(GlobalValueSummary::GVFlags Flags) {
+  return Flags.Linkage | (Flags.NotEligibleToImport << 4) |
+         (Flags.Live << 5) | (Flags.DSOLocal << 6);
+}
+
+static GlobalValueSummary::GVFlags decodeGVFlags(uint32_t RawFlags) {
+  return GlobalValueSummary::GVFlags(
+      static_cast<GlobalValue::LinkageTypes>(RawFlags & 0xf),
+      (RawFlags >> 4) & 1, (RawFlags >> 5) & 1, (RawFlags >> 6) & 1);
+}
+
+static uint32_t encodeFFlags(FunctionSummary::FFlags Flags) {
+  return Flags.ReadNone | (Flags.ReadOnly << 1) | (Flags.NoRecurse << 2) |
+         (Flags.ReturnDoesNotAlias << 3);
+}
+
+static FunctionSummary::FFlags decodeFFlags(uint32_t RawFlags) {
+  FunctionSummary::FFlags Flags;
+  Flags.ReadNone = RawFlags & 1;
+  Flags.ReadOnly = (RawFlags >> 1) & 1;
+  Flags.NoRecurse = (RawFlags >> 2) & 1;
+  Flags.ReturnDoesNotAlias = (RawFlags >> 3) & 1;
+  return Flags;
+}
+
+namespace {
+
+// The table is built in a single buffer. Fixed-size parts are reserved first
+// and filled in once the offsets of the data they refer to are known.
+class Writer {
+  const ModuleSummaryIndex &Index;
+  SmallVector<char, 0> Buf;
+
+  DenseMap<GlobalValue::GUID, uint32_t> EntryIndex;
+  StringMap<uint32_t> ModuleIndex;
+  DenseMap<const GlobalValueSummary *, uint32_t> SummaryOffset;
+
+  template <typename T> uint32_t reserve(size_t N) {
+    uint32_t Offset = Buf.size();
+    Buf.resize(Buf.size() + N * sizeof(T));
+    return Offset;
+  }
+
+  template <typename T> T &at(uint32_t Offset) {
+    return *reinterpret_cast<T *>(Buf.data() + Offset);
+  }
+
+  template <typename T> storage::Range<T> addRange(ArrayRef<T> Elts) {
+    storage::Range<T> R;
+    R.Offset = Buf.size();
+    R.Size = Elts.size();
+    Buf.append(reinterpret_cast<const char *>(Elts.begin()),
+               reinterpret_cast<const char *>(Elts.end()));
+    return R;
+  }
+
+  storage::Str addString(StringRef S) {
+    storage::Str Str;
+    Str.Offset = Buf.size();
+    Str.Size = S.size();
+    Buf.append(S.begin(), S.end());
+    return Str;
+  }
+
+  uint32_t getEntry(GlobalValue::GUID GUID) const {
+    auto I = EntryIndex.find(GUID);
+    assert(I != EntryIndex.end() && "GUID not in the index");
+    return I->second;
+  }
+
+  storage::Range<storage::Word> addEntryList(ArrayRef<ValueInfo> VIs);
+  storage::Range<storage::VFuncId>
+  addVFuncIds(ArrayRef<FunctionSummary::VFuncId> VFuncs);
+  storage::Range<storage::ConstVCall>
+  addConstVCalls(ArrayRef<FunctionSummary::ConstVCall> VCalls);
+  uint32_t addSummary(uint32_t Entry, GlobalValueSummary &S);
+  storage::Range<storage::Str> addStringSet(const std::set<std::string> &Set);
+
+public:
+  Writer(const ModuleSummaryIndex &Index) : Index(Index) {}
+
+  void build(const StringMap<std::map<std::string, GVSummaryMapTy>>
+                 &ModuleToSummaries);
+
+  void write(raw_ostream &OS) { OS.write(Buf.data(), Buf.size()); }
+};
+
+} // end anonymous namespace
+
+storage::Range<storage::Word> Writer::addEntryList(ArrayRef<ValueInfo> VIs) {
+  std::vector<storage::Word> Entries;
+  for (ValueInfo VI : VIs)
+    Entries.emplace_back(getEntry(VI.getGUID()));
+  return addRange<storage::Word>(Entries);
+}
+
+storage::Range<storage::VFuncId>
+Writer::addVFuncIds(ArrayRef<FunctionSummary::VFuncId> VFuncs) {
+  std::vector<storage::VFuncId> Ids(VFuncs.size());
+  for (unsigned I = 0; I != VFuncs.size(); ++I) {
+    Ids[I].GUID = VFuncs[I].GUID;
+    Ids[I].Offset = VFuncs[I].Offset;
+  }
+  return addRange<storage::VFuncId>(Ids);
+}
+
+storage::Range<storage::ConstVCall>
+Writer::addConstVCalls(ArrayRef<FunctionSummary::ConstVCall> VCalls) {
+  std::vector<storage::ConstVCall> Calls(VCalls.size());
+  for (unsigned I = 0; I != VCalls.size(); ++I) {
+    Calls[I].VFunc.GUID = VCalls[I].VFunc.GUID;
+    Calls[I].VFunc.Offset = VCalls[I].VFunc.Offset;
+    std::vector<storage::DWord> Args(VCalls[I].Args.begin(),
+                                     VCalls[I].Args.end());
+    Calls[I].Args = addRange<storage::DWord>(Args);
+  }
+  return addRange<storage::ConstVCall>(Calls);
+}
+
+uint32_t Writer::addSummary(uint32_t Entry, GlobalValueSummary &S) {
+  uint32_t Offset;
+  switch (S.getSummaryKind()) {
+  case GlobalValueSummary::AliasKind: {
+    Offset = reserve<storage::AliasSummary>(1);
+    at<storage::AliasSummary>(Offset).Aliasee =
+        getEntry(cast<AliasSummary>(S).getAliaseeGUID());
+    break;
+  }
+  case GlobalValueSummary::GlobalVarKind:
+    Offset = reserve<storage::GlobalVarSummary>(1);
+    break;
+  case GlobalValueSummary::FunctionKind: {
+    auto &FS = cast<FunctionSummary>(S);
+    Offset = reserve<storage::FunctionSummary>(1);
+    at<storage::FunctionSummary>(Offset).InstCount = FS.instCount();
+    at<storage::FunctionSummary>(Offset).FFlags = encodeFFlags(FS.fflags());
+
+    std::vector<storage::Call> Calls(FS.calls().size());
+    for (unsigned I = 0; I != Calls.size(); ++I) {
+      Calls[I].Callee = getEntry(FS.calls()[I].first.getGUID());
+      Calls[I].Hotness = static_cast<uint8_t>(FS.calls()[I].second.Hotness);
+    }
+    auto CallsR = addRange<storage::Call>(Calls);
+    at<storage::FunctionSummary>(Offset).Calls = CallsR;
+
+    std::vector<storage::DWord> TypeTests(FS.type_tests().begin(),
+                                          FS.type_tests().end());
+    auto TypeTestsR = addRange<storage::DWord>(TypeTests);
+    at<storage::FunctionSummary>(Offset).TypeTests = TypeTestsR;
+
+    auto TTAVCallsR = addVFuncIds(FS.type_test_assume_vcalls());
+    at<storage::FunctionSummary>(Offset).TypeTestAssumeVCalls = TTAVCallsR;
+    auto TCLVCallsR = addVFuncIds(FS.type_checked_load_vcalls());
+    at<storage::FunctionSummary>(Offset).TypeCheckedLoadVCalls = TCLVCallsR;
+    auto TTACVCallsR = addConstVCalls(FS.type_test_assume_const_vcalls());
+    at<storage::FunctionSummary>(Offset).TypeTestAssumeConstVCalls =
+        TTACVCallsR;
+    auto TCLCVCallsR = addConstVCalls(FS.type_checked_load_const_vcalls());
+    at<storage::FunctionSummary>(Offset).TypeCheckedLoadConstVCalls =
+        TCLCVCallsR;
+    break;
+  }
+  }
+
+  auto RefsR = addEntryList(S.refs());
+  auto &Base = at<storage::GlobalValueSummary>(Offset);
+  Base.Kind = S.getSummaryKind();
+  Base.Entry = Entry;
+  Base.Module = ModuleIndex.lookup(S.modulePath());
+  Base.Flags = encodeGVFlags(S.flags());
+  Base.OriginalName = S.getOriginalName();
+  Base.Refs = RefsR;
+  return Offset;
+}
+
+storage::Range<storage::Str>
+Writer::addStringSet(const std::set<std::string> &Set) {
+  std::vector<storage::Str> Strs;
+  for (const std::string &S : Set)
+    Strs.push_back(addString(S));
+  return addRange<storage::Str>(Strs);
+}
+
+void Writer::build(
+    const StringMap<std::map<std::string, GVSummaryMapTy>> &ModuleToSummaries) {
+  reserve<storage::Header>(1);
+
+  std::vector<const ModuleSummaryIndex::ModuleInfo *> Modules;
+  for (const auto &M : Index.modulePaths())
+    Modules.push_back(&M);
+  std::sort(Modules.begin(), Modules.end(),
+            [](const ModuleSummaryIndex::ModuleInfo *A,
+               const ModuleSummaryIndex::ModuleInfo *B) {
+              return A->first() < B->first();
+            });
+  uint32_t ModulesOffset = reserve<storage::Module>(Modules.size());
+  auto ModuleAt = [&](unsigned I) -> storage::Module & {
+    return at<storage::Module>(ModulesOffset + I * sizeof(storage::Module));
+  };
+  for (unsigned I = 0; I != Modules.size(); ++I) {
+    ModuleIndex[Modules[I]->first()] = I;
+    auto Path = addString(Modules[I]->first());
+    storage::Module &M = ModuleAt(I);
+    M.Path = Path;
+    M.ModuleId = Modules[I]->second.first;
+    for (unsigned J = 0; J != 5; ++J)
+      M.Hash[J] = Modules[I]->second.second[J];
+  }
+
+  // The global value map is ordered by GUID, which gives the order of the
+  // entries.
+  uint32_t NumEntries = 0;
+  for (const auto &I : Index)
+    EntryIndex[I.first] = NumEntries++;
+  uint32_t EntriesOffset = reserve<storage::Entry>(NumEntries);
+  for (const auto &I : Index) {
+    uint32_t Entry = EntryIndex[I.first];
+    std::vector<storage::Word> Offsets;
+    for (auto &S : I.second.SummaryList) {
+      uint32_t Offset = addSummary(Entry, *S);
+      SummaryOffset[S.get()] = Offset;
+      Offsets.emplace_back(Offset);
+    }
+    auto SummariesR = addRange<storage::Word>(Offsets);
+    auto &E =
+        at<storage::Entry>(EntriesOffset + Entry * sizeof(storage::Entry));
+    E.GUID = I.first;
+    E.Summaries = SummariesR;
+  }
+
+  for (const auto &MS : ModuleToSummaries) {
+    std::vector<storage::Word> Needed;
+    for (const auto &DefM : MS.second) {
+      std::vector<std::pair<GlobalValue::GUID, const GlobalValueSummary *>>
+          Summaries(DefM.second.begin(), DefM.second.end());
+      std::sort(Summaries.begin(), Summaries.end(), llvm::less_first());
+      for (const auto &S : Summaries)
+        Needed.emplace_back(SummaryOffset.lookup(S.second));
+    }
+    auto NeededR = addRange<storage::Word>(Needed);
+    assert(ModuleIndex.count(MS.first()) && "Module not in the index");
+    ModuleAt(ModuleIndex.lookup(MS.first())).Needed = NeededR;
+  }
+
+  auto CfiFunctionDefsR = addStringSet(Index.cfiFunctionDefs());
+  auto CfiFunctionDeclsR = addStringSet(Index.cfiFunctionDecls());
+
+  auto &Hdr = at<storage::Header>(0);
+  Hdr.Magic = storage::Header::kMagic;
+  Hdr.Version = storage::Header::kCurrentVersion;
+  Hdr.Modules.Offset = ModulesOffset;
+  Hdr.Modules.Size = Modules.size();
+  Hdr.Entries.Offset = EntriesOffset;
+  Hdr.Entries.Size = NumEntries;
+  Hdr.CfiFunctionDefs = CfiFunctionDefsR;
+  Hdr.CfiFunctionDecls = CfiFunctionDeclsR;
+}
+
+bool summarytab::isSummaryTable(StringRef Data) {
+  return Data.size() >= sizeof(storage::Word) &&
+         reinterpret_cast<const storage::Header *>(Data.data())->Magic ==
+             storage::Header::kMagic;
+}
+
+void summarytab::write(
+    const ModuleSummaryIndex &Index,
+    const StringMap<std::map<std::string, GVSummaryMapTy>> &ModuleToSummaries,
+    raw_ostream &OS) {
+  Writer W(Index);
+  W.build(ModuleToSummaries);
+  W.write(OS);
+}
+
+template <typename T>
+static bool isInBounds(storage::Range<T> R, StringRef Data) {
+  return uint64_t(R.Offset) + uint64_t(R.Size) * sizeof(T) <= Data.size();
+}
+
+static bool isInBounds(storage::Str S, StringRef Data) {
+  return uint64_t(S.Offset) + uint64_t(S.Size) <= Data.size();
+}
+
+/// Returns whether an object of type T at Offset is within Data.
+template <typename T>
+static bool isObjectInBounds(uint32_t Offset, StringRef Data) {
+  return uint64_t(Offset) + sizeof(T) <= Data.size();
+}
+
+static Error createCorruptTableError() {
+  return make_error<StringError>("Corrupt summary table",
+                                 inconvertibleErrorCode());
+}
+
+Expected<Reader> Reader::create(StringRef Data) {
+  if (Data.size() < sizeof(storage::Header) || !isSummaryTable(Data))
+    return make_error<StringError>("Invalid summary table",
+                                   inconvertibleErrorCode());
+
+  Reader R;
+  R.Data = Data;
+  R.Header = reinterpret_cast<const storage::Header *>(Data.data());
+  if (R.Header->Version != storage::Header::kCurrentVersion)
+    return make_error<StringError>("Unsupported summary table version",
+                                   inconvertibleErrorCode());
+  if (!isInBounds(R.Header->Modules, Data) ||
+      !isInBounds(R.Header->Entries, Data) ||
+      !isInBounds(R.Header->CfiFunctionDefs, Data) ||
+      !isInBounds(R.Header->CfiFunctionDecls, Data))
+    return make_error<StringError>("Truncated summary table",
+                                   inconvertibleErrorCode());
+  R.Modules = R.range(R.Header->Modules);
+  R.Entries = R.range(R.Header->Entries);
+
+  // The modules are few and are searched by path, so check them up front.
+  for (const storage::Module &M : R.Modules)
+    if (!isInBounds(M.Path, Data) || !isInBounds(M.Needed, Data))
+      return createCorruptTableError();
+  for (const auto &Set :
+       {R.Header->CfiFunctionDefs, R.Header->CfiFunctionDecls})
+    for (storage::Str S : R.range(Set))
+      if (!isInBounds(S, Data))
+        return createCorruptTableError();
+  return R;
+}
+
+Expected<const storage::GlobalValueSummary *>
+Reader::getSummary(uint32_t Offset) const {
+  if (!isObjectInBounds<storage::GlobalValueSummary>(Offset, Data))
+    return createCorruptTableError();
+  const storage::GlobalValueSummary &S = summaryAt(Offset);
+  if (S.Entry >= Entries.size() || S.Module >= Modules.size() ||
+      !isInBounds(S.Refs, Data))
+    return createCorruptTableError();
+  for (uint32_t Entry : range(S.Refs))
+    if (Entry >= Entries.size())
+      return createCorruptTableError();
+
+  switch (uint32_t(S.Kind)) {
+  case GlobalValueSummary::GlobalVarKind:
+    return &S;
+  case GlobalValueSummary::AliasKind:
+    if (!isObjectInBounds<storage::AliasSummary>(Offset, Data) ||
+        reinterpret_cast<const storage::AliasSummary &>(S).Aliasee >=
+            Entries.size())
+      return createCorruptTableError();
+    return &S;
+  case GlobalValueSummary::FunctionKind: {
+    if (!isObjectInBounds<storage::FunctionSummary>(Offset, Data))
+      return createCorruptTableError();
+    auto &FS = reinterpret_cast<const storage::FunctionSummary &>(S);
+    if (!isInBounds(FS.Calls, Data) || !isInBounds(FS.TypeTests, Data) ||
+        !isInBounds(FS.TypeTestAssumeVCalls, Data) ||
+        !isInBounds(FS.TypeCheckedLoadVCalls, Data) ||
+        !isInBounds(FS.TypeTestAssumeConstVCalls, Data) ||
+        !isInBounds(FS.TypeCheckedLoadConstVCalls, Data))
+      return createCorruptTableError();
+    for (const storage::Call &C : range(FS.Calls))
+      if (C.Callee >= Entries.size())
+        return createCorruptTableError();
+    for (const auto &R :
+         {FS.TypeTestAssumeConstVCalls, FS.TypeCheckedLoadConstVCalls})
+      for (const storage::ConstVCall &C : range(R))
+        if (!isInBounds(C.Args, Data))
+          return createCorruptTableError();
+    return &S;
+  }
+  }
+  return createCorruptTableError();
+}
+
+const storage::Module *Reader::findModule(StringRef ModulePath) const {
+  auto I = std::lower_bound(Modules.begin(), Modules.end(), ModulePath,
+                            [&](const storage::Module &M, StringRef Path) {
+                              return str(M.Path) < Path;
+                            });
+  if (I == Modules.end() || str(I->Path) != ModulePath)
+    return nullptr;
+  return I;
+}
+
+const storage::Entry *Reader::findEntry(GlobalValue::GUID GUID) const {
+  auto I = std::lower_bound(Entries.begin(), Entries.end(), GUID,
+                            [](const storage::Entry &E, GlobalValue::GUID G) {
+                              return E.GUID < G;
+                            });
+  if (I == Entries.end() || I->GUID != GUID)
+    return nullptr;
+  return I;
+}
+
+const storage::GlobalValueSummary *
+Reader::findSummaryInModule(GlobalValue::GUID GUID,
+                            StringRef ModulePath) const {
+  const storage::Entry *E = findEntry(GUID);
+  const storage::Module *M = findModule(ModulePath);
+  if (!E || !M || !isInBounds(E->Summaries, Data))
+    return nullptr;
+  for (uint32_t Offset : range(E->Summaries)) {
+    Expected<const storage::GlobalValueSummary *> S = getSummary(Offset);
+    if (!S) {
+      consumeError(S.takeError());
+      return nullptr;
+    }
+    if ((*S)->Module == uint32_t(M - Modules.begin()))
+      return *S;
+  }
+  return nullptr;
+}
+
+static std::vector<FunctionSummary::VFuncId>
+getVFuncIds(ArrayRef<storage::VFuncId> Ids) {
+  std::vector<FunctionSummary::VFuncId> VFuncs;
+  for (const storage::VFuncId &Id : Ids)
+    VFuncs.push_back({Id.GUID, Id.Offset});
+  return VFuncs;
+}
+
+std::unique_ptr<GlobalValueSummary> Reader::createSummary(
+    const storage::GlobalValueSummary &S,
+    const DenseMap<uint32_t, ValueInfo> &EntryToValueInfo) const {
+  // Like the bitcode writer, only keep the edges to values that are part of
+  // the materialized index.
+  auto GetValueInfo = [&](uint32_t Entry) {
+    return EntryToValueInfo.lookup(Entry);
+  };
+  std::vector<ValueInfo> Refs;
+  for (uint32_t Entry : range(S.Refs))
+    if (ValueInfo VI = GetValueInfo(Entry))
+      Refs.push_back(VI);
+
+  auto Flags = decodeGVFlags(S.Flags);
+  if (S.Kind == GlobalValueSummary::GlobalVarKind)
+    return llvm::make_unique<GlobalVarSummary>(Flags, std::move(Refs));
+
+  assert(S.Kind == GlobalValueSummary::FunctionKind);
+  auto &FS = reinterpret_cast<const storage::FunctionSummary &>(S);
+  std::vector<FunctionSummary::EdgeTy> Calls;
+  for (const storage::Call &C : range(FS.Calls))
+    if (ValueInfo VI = GetValueInfo(C.Callee))
+      Calls.push_back(
+          {VI, CalleeInfo(static_cast<CalleeInfo::HotnessType>(
+                   uint32_t(C.Hotness)))});
+
+  auto GetConstVCalls = [&](storage::Range<storage::ConstVCall> R) {
+    std::vector<FunctionSummary::ConstVCall> VCalls;
+    for (const storage::ConstVCall &C : range(R)) {
+      ArrayRef<storage::DWord> Args = range(C.Args);
+      VCalls.push_back({{C.VFunc.GUID, C.VFunc.Offset},
+                        std::vector<uint64_t>(Args.begin(), Args.end())});
+    }
+    return VCalls;
+  };
+
+  ArrayRef<storage::DWord> TypeTests = range(FS.TypeTests);
+  return llvm::make_unique<FunctionSummary>(
+      Flags, FS.InstCount, decodeFFlags(FS.FFlags), std::move(Refs),
+      std::move(Calls),
+      std::vector<GlobalValue::GUID>(TypeTests.begin(), TypeTests.end()),
+      getVFuncIds(range(FS.TypeTestAssumeVCalls)),
+      getVFuncIds(range(FS.TypeCheckedLoadVCalls)),
+      GetConstVCalls(FS.TypeTestAssumeConstVCalls),
+      GetConstVCalls(FS.TypeCheckedLoadConstVCalls));
+}
+
+Error Reader::materializeForModule(StringRef ModulePath,
+                                   ModuleSummaryIndex &Index) const {
+  const storage::Module *M = findModule(ModulePath);
+  if (!M)
+    return make_error<StringError>("Module " + ModulePath +
+                                       " not found in summary table",
+                                   inconvertibleErrorCode());
+  // Check all the needed summaries before adding anything to Index.
+  std::vector<const storage::GlobalValueSummary *> Needed;
+  for (uint32_t Offset : range(M->Needed)) {
+    Expected<const storage::GlobalValueSummary *> S = getSummary(Offset);
+    if (!S)
+      return S.takeError();
+    Needed.push_back(*S);
+  }
+
+  DenseMap<uint32_t, StringRef> ModuleToPath;
+  auto AddModule = [&](uint32_t ModuleIdx) {
+    const storage::Module &DefM = Modules[ModuleIdx];
+    ModuleHash Hash;
+    std::copy(std::begin(DefM.Hash), std::end(DefM.Hash), Hash.begin());
+    ModuleToPath[ModuleIdx] =
+        Index.addModule(str(DefM.Path), DefM.ModuleId, Hash)->first();
+  };
+  AddModule(M - Modules.begin());
+
+  // The individual index gives a value id to each needed value and to the
+  // aliasees of the needed aliases, even those not imported themselves.
+  DenseMap<uint32_t, ValueInfo> EntryToValueInfo;
+  auto AddValue = [&](uint32_t Entry) {
+    if (!EntryToValueInfo.count(Entry))
+      EntryToValueInfo[Entry] = Index.getOrInsertValueInfo(Entries[Entry].GUID);
+  };
+  for (const storage::GlobalValueSummary *SP : Needed) {
+    const storage::GlobalValueSummary &S = *SP;
+    AddValue(S.Entry);
+    if (S.Kind == GlobalValueSummary::AliasKind)
+      AddValue(reinterpret_cast<const storage::AliasSummary &>(S).Aliasee);
+    if (!ModuleToPath.count(S.Module))
+      AddModule(S.Module);
+  }
+
+  auto AddSummary = [&](const storage::GlobalValueSummary &S,
+                        std::unique_ptr<GlobalValueSummary> Summary) {
+    Summary->setModulePath(ModuleToPath[S.Module]);
+    if (GlobalValue::isLocalLinkage(Summary->linkage()))
+      Summary->setOriginalName(S.OriginalName);
+    Index.addGlobalValueSummary(EntryToValueInfo[S.Entry], std::move(Summary));
+  };
+
+  // Aliases are added last so that their aliasees are found.
+  SmallVector<const storage::AliasSummary *, 8> Aliases;
+  for (const storage::GlobalValueSummary *SP : Needed) {
+    const storage::GlobalValueSummary &S = *SP;
+    if (S.Kind == GlobalValueSummary::AliasKind) {
+      Aliases.push_back(reinterpret_cast<const storage::AliasSummary *>(&S));
+      continue;
+    }
+    AddSummary(S, createSummary(S, EntryToValueInfo));
+  }
+
+  for (const storage::AliasSummary *AS : Aliases) {
+    auto Alias = llvm::make_unique<AliasSummary>(decodeGVFlags(AS->Base.Flags));
+    GlobalValue::GUID AliaseeGUID = Entries[AS->Aliasee].GUID;
+    Alias->setAliasee(
+        Index.findSummaryInModule(AliaseeGUID, ModuleToPath[AS->Base.Module]));
+    Alias->setAliaseeGUID(AliaseeGUID);
+    AddSummary(AS->Base, std::move(Alias));
+  }
+
+  for (storage::Str S : range(Header->CfiFunctionDefs))
+    Index.cfiFunctionDefs().insert(str(S));
+  for (storage::Str S : range(Header->CfiFunctionDecls))
+    Index.cfiFunctionDecls().insert(str(S));
+  return Error::success();
+}
@@ -12,16 +12,47 @@
 //===----------------------------------------------------------------------===//
 
 #include "llvm/LTO/Caching.h"
+#include "llvm/ADT/Statistic.h"
 #include "llvm/ADT/StringExtras.h"
+#include "llvm/Support/CachePruning.h"
 #include "llvm/Support/Errc.h"
+#include "llvm/Support/LockFileManager.h"
 #include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/Path.h"
 #include "llvm/Support/Process.h"
 #include "llvm/Support/raw_ostream.h"
 
+#include <chrono>
+
 using namespace llvm;
 using namespace llvm::lto;
 
+#define DEBUG_TYPE "lto-cache"
+
+STATISTIC(NumCacheHits, "Number of native objects found in the cache");
+STATISTIC(NumCacheMisses, "Number of native objects not found in the cache");
+STATISTIC(NumKBytesReused, "Kilobytes of native objects reused from the cache");
+STATISTIC(NumMillisCompiling,
+          "Milliseconds spent producing native objects missing from the cache");
+
+/// Look up \p EntryPath in the cache and add it to the link on a hit.
+static bool loadCacheEntry(StringRef EntryPath, unsigned Task,
+                           const AddBufferFn &AddBuffer) {
+  ErrorOr<std::unique_ptr<MemoryBuffer>> MBOrErr =
+      MemoryBuffer::getFile(EntryPath);
+  if (MBOrErr) {
+    ++NumCacheHits;
+    NumKBytesReused += (*MBOrErr)->getBufferSize() / 1024;
+    AddBuffer(Task, std::move(*MBOrErr), EntryPath);
+    return true;
+  }
+
+  if (MBOrErr.getError() != errc::no_such_file_or_directory)
+    report_fatal_error(Twine("Failed to open cache file ") + EntryPath +
+                       ": " + MBOrErr.getError().message() + "\n");
+  return false;
+}
+
 Expected<NativeObjectCache> lto::localCache(StringRef CacheDirectoryPath,
                                             AddBufferFn AddBuffer) {
   if (std::error_code EC = sys::fs::create_directories(CacheDirectoryPath))
@@ -33,16 +64,20 @@ Expected<NativeObjectCache> lto::localCache(StringRef CacheDirectoryPath,
     SmallString<64> EntryPath;
     sys::path::append(EntryPath, CacheDirectoryPath, "llvmcache-" + Key);
     // First, see if we have a cache hit.
-    ErrorOr<std::unique_ptr<MemoryBuffer>> MBOrErr =
-        MemoryBuffer::getFile(EntryPath);
-    if (MBOrErr) {
-      AddBuffer(Task, std::move(*MBOrErr), EntryPath);
+    if (loadCacheEntry(EntryPath, Task, AddBuffer))
       return AddStreamFn();
-    }
 
-    if (MBOrErr.getError() != errc::no_such_file_or_directory)
-      report_fatal_error(Twine("Failed to open cache file ") + EntryPath +
-                         ": " + MBOrErr.getError().message() + "\n");
+    // Lock the entry so that linkers sharing the cache directory produce it
+    // only once. If another process holds the lock, wait for it and use its
+    // result; if it gave up, produce the entry ourselves.
+    auto Lock = std::make_shared<LockFileManager>(EntryPath);
+    if (Lock->getState() == LockFileManager::LFS_Shared) {
+      Lock->waitForUnlock();
+      if (loadCacheEntry(EntryPath, Task, AddBuffer))
+        return AddStreamFn();
+    }
+    ++NumCacheMisses;
+    auto Start = std::chrono::steady_clock::now();
 
     // This native object stream is responsible for commiting the resulting
     // file to the cache and calling AddBuffer to add it to the link.
@@ -51,13 +86,16 @@ Expected<NativeObjectCache> lto::localCache(StringRef CacheDirectoryPath,
       sys::fs::TempFile TempFile;
       std::string EntryPath;
       unsigned Task;
+      std::shared_ptr<LockFileManager> Lock;
+      std::chrono::steady_clock::time_point Start;
 
       CacheStream(std::unique_ptr<raw_pwrite_stream> OS, AddBufferFn AddBuffer,
                   sys::fs::TempFile TempFile, std::string EntryPath,
-                  unsigned Task)
+                  unsigned Task, std::shared_ptr<LockFileManager> Lock,
+                  std::chrono::steady_clock::time_point Start)
           : NativeObjectStream(std::move(OS)), AddBuffer(std::move(AddBuffer)),
             TempFile(std::move(TempFile)), EntryPath(std::move(EntryPath)),
-            Task(Task) {}
+            Task(Task), Lock(std::move(Lock)), Start(Start) {}
 
       ~CacheStream() {
         // Make sure the stream is closed before committing it.
@@ -103,6 +141,14 @@ Expected<NativeObjectCache> lto::localCache(StringRef CacheDirectoryPath,
                              TempFile.TmpName + " to " + EntryPath + ": " +
                              toString(std::move(E)) + "\n");
 
+        // Record how long the entry took to produce, from the cache miss to
+        // now, so that the pruner evicts the cheapest entries first.
+        auto Cost = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - Start);
+        NumMillisCompiling += Cost.count();
+        recordCacheEntryCost(sys::path::parent_path(EntryPath),
+                             sys::path::filename(EntryPath), Cost);
+
         AddBuffer(Task, std::move(*MBOrErr), EntryPath);
       }
     };
@@ -121,7 +167,7 @@ Expected<NativeObjectCache> lto::localCache(StringRef CacheDirectoryPath,
       // This CacheStream will move the temporary file into the cache when done.
       return llvm::make_unique<CacheStream>(
           llvm::make_unique<raw_fd_ostream>(Temp->FD, /* ShouldClose */ false),
-          AddBuffer, std::move(*Temp), EntryPath.str(), Task);
+          AddBuffer, std::move(*Temp), EntryPath.str(), Task, Lock, Start);
     };
   };
 }
@@ -22,6 +22,7 @@
 #include "llvm/IR/LegacyPassManager.h"
 #include "llvm/IR/Mangler.h"
 #include "llvm/IR/Metadata.h"
+#include "llvm/IR/ModuleSummaryIndexTable.h"
 #include "llvm/LTO/LTOBackend.h"
 #include "llvm/Linker/IRMover.h"
 #include "llvm/Object/IRObjectFile.h"
@@ -29,6 +30,7 @@
 #include "llvm/Support/ManagedStatic.h"
 #include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/Path.h"
+#include "llvm/Support/Program.h"
 #include "llvm/Support/SHA1.h"
 #include "llvm/Support/SourceMgr.h"
 #include "llvm/Support/TargetRegistry.h"
@@ -42,7 +44,9 @@
 #include "llvm/Transforms/IPO/PassManagerBuilder.h"
 #include "llvm/Transforms/Utils/SplitModule.h"
 
+#include <chrono>
 #include <set>
+#include <thread>
 
 using namespace llvm;
 using namespace lto;
@@ -979,6 +983,179 @@ ThinBackend lto::createInProcessThinBackend(unsigned ParallelismLevel) {
   };
 }
 
+namespace {
+class OutOfProcessThinBackend : public ThinBackendProc {
+  unsigned ParallelismLevel;
+  std::string WorkerPath;
+  std::vector<std::string> WorkerArgs;
+  unsigned MemoryLimit;
+  AddStreamFn AddStream;
+
+  struct Job {
+    unsigned Task;
+    std::string ModulePath;
+    SmallString<128> IndexPath, ObjectPath;
+    sys::ProcessInfo PI;
+  };
+  std::vector<Job> Running;
+
+  Optional<Error> Err;
+
+  void addError(Error E) {
+    if (Err)
+      Err = joinErrors(std::move(*Err), std::move(E));
+    else
+      Err = std::move(E);
+  }
+
+  Error finishJob(Job &J, const sys::ProcessInfo &Result,
+                  const std::string &ErrMsg) {
+    if (Result.ReturnCode != 0)
+      return make_error<StringError>(
+          "ThinLTO backend worker for " + J.ModulePath + " failed" +
+              (ErrMsg.empty() ? "" : ": " + ErrMsg),
+          inconvertibleErrorCode());
+
+    ErrorOr<std::unique_ptr<MemoryBuffer>> MBOrErr =
+        MemoryBuffer::getFile(J.ObjectPath);
+    if (!MBOrErr)
+      return errorCodeToError(MBOrErr.getError());
+    *AddStream(J.Task)->OS << (*MBOrErr)->getBuffer();
+    return Error::success();
+  }
+
+  // Collects the workers that have exited. If Block is true, waits until at
+  // least one has.
+  void reapWorkers(bool Block) {
+    while (true) {
+      for (auto I = Running.begin(); I != Running.end();) {
+        std::string ErrMsg;
+        sys::ProcessInfo Result =
+            sys::Wait(I->PI, /*SecondsToWait=*/0,
+                      /*WaitUntilTerminates=*/false, &ErrMsg);
+        if (Result.Pid == 0) {
+          ++I;
+          continue;
+        }
+        if (Error E = finishJob(*I, Result, ErrMsg))
+          addError(std::move(E));
+        sys::fs::remove(I->IndexPath);
+        sys::fs::remove(I->ObjectPath);
+        I = Running.erase(I);
+        Block = false;
+      }
+      if (!Block || Running.empty())
+        return;
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+  }
+
+public:
+  OutOfProcessThinBackend(
+      Config &Conf, ModuleSummaryIndex &CombinedIndex,
+      unsigned ParallelismLevel,
+      const StringMap<GVSummaryMapTy> &ModuleToDefinedGVSummaries,
+      std::string WorkerPath, std::vector<std::string> WorkerArgs,
+      unsigned MemoryLimit, AddStreamFn AddStream)
+      : ThinBackendProc(Conf, CombinedIndex, ModuleToDefinedGVSummaries),
+        ParallelismLevel(std::max(ParallelismLevel, 1u)),
+        WorkerPath(std::move(WorkerPath)), WorkerArgs(std::move(WorkerArgs)),
+        MemoryLimit(MemoryLimit), AddStream(std::move(AddStream)) {}
+
+  ~OutOfProcessThinBackend() override {
+    // Do not leave workers or temporary files behind if the link is aborted.
+    for (Job &J : Running) {
+      sys::Wait(J.PI, /*SecondsToWait=*/0, /*WaitUntilTerminates=*/true);
+      sys::fs::remove(J.IndexPath);
+      sys::fs::remove(J.ObjectPath);
+    }
+  }
+
+  Error start(
+      unsigned Task, BitcodeModule BM,
+      const FunctionImporter::ImportMapTy &ImportList,
+      const FunctionImporter::ExportSetTy &ExportList,
+      const std::map<GlobalValue::GUID, GlobalValue::LinkageTypes> &ResolvedODR,
+      MapVector<StringRef, BitcodeModule> &ModuleMap) override {
+    StringRef ModulePath = BM.getModuleIdentifier();
+    if (!sys::fs::exists(ModulePath))
+      return make_error<StringError>(
+          "out-of-process ThinLTO backend requires " + ModulePath +
+              " to be a file",
+          inconvertibleErrorCode());
+
+    if (Running.size() >= ParallelismLevel)
+      reapWorkers(/*Block=*/true);
+
+    Job J;
+    J.Task = Task;
+    J.ModulePath = ModulePath;
+
+    std::map<std::string, GVSummaryMapTy> ModuleToSummariesForIndex;
+    gatherImportedSummariesForModule(ModulePath, ModuleToDefinedGVSummaries,
+                                     ImportList, ModuleToSummariesForIndex);
+    int FD;
+    if (std::error_code EC = sys::fs::createTemporaryFile(
+            "thinlto-worker", "thinlto.bc", FD, J.IndexPath))
+      return errorCodeToError(EC);
+    {
+      raw_fd_ostream OS(FD, /*shouldClose=*/true);
+      WriteIndexToFile(CombinedIndex, OS, &ModuleToSummariesForIndex);
+    }
+    if (std::error_code EC =
+            sys::fs::createTemporaryFile("thinlto-worker", "o", J.ObjectPath)) {
+      sys::fs::remove(J.IndexPath);
+      return errorCodeToError(EC);
+    }
+
+    std::string IndexArg = ("-thinlto-index=" + J.IndexPath).str();
+    std::vector<const char *> Args;
+    Args.push_back(WorkerPath.c_str());
+    for (const std::string &Arg : WorkerArgs)
+      Args.push_back(Arg.c_str());
+    Args.push_back(IndexArg.c_str());
+    Args.push_back("-o");
+    Args.push_back(J.ObjectPath.c_str());
+    Args.push_back(J.ModulePath.c_str());
+    Args.push_back(nullptr);
+
+    std::string ErrMsg;
+    J.PI = sys::ExecuteNoWait(WorkerPath, Args.data(), /*Env=*/nullptr,
+                              /*Redirects=*/{}, MemoryLimit, &ErrMsg);
+    if (!J.PI.Pid) {
+      sys::fs::remove(J.IndexPath);
+      sys::fs::remove(J.ObjectPath);
+      return make_error<StringError>("could not start ThinLTO backend worker " +
+                                         WorkerPath + ": " + ErrMsg,
+                                     inconvertibleErrorCode());
+    }
+    Running.push_back(std::move(J));
+    return Error::success();
+  }
+
+  Error wait() override {
+    while (!Running.empty())
+      reapWorkers(/*Block=*/true);
+    if (Err)
+      return std::move(*Err);
+    else
+      return Error::success();
+  }
+};
+} // end anonymous namespace
+
+ThinBackend lto::createOutOfProcessThinBackend(
+    unsigned ParallelismLevel, std::string WorkerPath,
+    std::vector<std::string> WorkerArgs, unsigned MemoryLimit) {
+  return [=](Config &Conf, ModuleSummaryIndex &CombinedIndex,
+             const StringMap<GVSummaryMapTy> &ModuleToDefinedGVSummaries,
+             AddStreamFn AddStream, NativeObjectCache Cache) {
+    return llvm::make_unique<OutOfProcessThinBackend>(
+        Conf, CombinedIndex, ParallelismLevel, ModuleToDefinedGVSummaries,
+        WorkerPath, WorkerArgs, MemoryLimit, AddStream);
+  };
+}
+
 // Given the original \p Path to an output file, replace any path
 // prefix matching \p OldPrefix with \p NewPrefix. Also, create the
 // resulting directory if it does not yet exist.
@@ -1072,6 +1249,94 @@ ThinBackend lto::createWriteIndexesThinBackend(std::string OldPrefix,
   };
 }
 
+namespace {
+class WriteSummaryTableThinBackend : public ThinBackendProc {
+  std::string OutputFile;
+  StringMap<std::map<std::string, GVSummaryMapTy>> ModuleToSummaries;
+
+public:
+  WriteSummaryTableThinBackend(
+      Config &Conf, ModuleSummaryIndex &CombinedIndex,
+      const StringMap<GVSummaryMapTy> &ModuleToDefinedGVSummaries,
+      std::string OutputFile)
+      : ThinBackendProc(Conf, CombinedIndex, ModuleToDefinedGVSummaries),
+        OutputFile(std::move(OutputFile)) {}
+
+  Error start(
+      unsigned Task, BitcodeModule BM,
+      const FunctionImporter::ImportMapTy &ImportList,
+      const FunctionImporter::ExportSetTy &ExportList,
+      const std::map<GlobalValue::GUID, GlobalValue::LinkageTypes> &ResolvedODR,
+      MapVector<StringRef, BitcodeModule> &ModuleMap) override {
+    StringRef ModulePath = BM.getModuleIdentifier();
+    gatherImportedSummariesForModule(ModulePath, ModuleToDefinedGVSummaries,
+                                     ImportList, ModuleToSummaries[ModulePath]);
+    return Error::success();
+  }
+
+  Error wait() override {
+    std::error_code EC;
+    raw_fd_ostream OS(OutputFile, EC, sys::fs::OpenFlags::F_None);
+    if (EC)
+      return errorCodeToError(EC);
+    summarytab::write(CombinedIndex, ModuleToSummaries, OS);
+    return Error::success();
+  }
+};
+} // end anonymous namespace
+
+ThinBackend lto::createWriteSummaryTableThinBackend(std::string OutputFile) {
+  return [=](Config &Conf, ModuleSummaryIndex &CombinedIndex,
+             const StringMap<GVSummaryMapTy> &ModuleToDefinedGVSummaries,
+             AddStreamFn AddStream, NativeObjectCache Cache) {
+    return llvm::make_unique<WriteSummaryTableThinBackend>(
+        Conf, CombinedIndex, ModuleToDefinedGVSummaries, OutputFile);
+  };
+}
+
+// Computes the import and export lists like ComputeCrossModuleImport, reusing
+// the import lists saved in StateFile by the previous link for the modules that
+// are not affected by what changed since, and saves the new import lists there.
+// A missing or unreadable state file makes every import list be recomputed.
+static Error computeImportsIncrementally(
+    StringRef StateFile, const ModuleSummaryIndex &CombinedIndex,
+    const StringMap<GVSummaryMapTy> &ModuleToDefinedGVSummaries,
+    StringMap<FunctionImporter::ImportMapTy> &ImportLists,
+    StringMap<FunctionImporter::ExportSetTy> &ExportLists) {
+  Optional<CrossModuleImportState> PrevState;
+  if (ErrorOr<std::unique_ptr<MemoryBuffer>> MBOrErr =
+          MemoryBuffer::getFile(StateFile)) {
+    Expected<CrossModuleImportState> StateOrErr =
+        CrossModuleImportState::read((*MBOrErr)->getMemBufferRef());
+    if (StateOrErr)
+      PrevState = std::move(*StateOrErr);
+    else
+      consumeError(StateOrErr.takeError());
+  }
+
+  CrossModuleImportState NewState;
+  ComputeCrossModuleImportIncrementally(
+      CombinedIndex, ModuleToDefinedGVSummaries, ImportLists, ExportLists,
+      PrevState ? PrevState.getPointer() : nullptr, NewState);
+
+  // Write the new state next to the old one and rename it over, so that an
+  // interrupted link does not leave a truncated state behind.
+  int FD;
+  SmallString<128> TempPath;
+  if (std::error_code EC =
+          sys::fs::createUniqueFile(StateFile + ".tmp%%%%%%", FD, TempPath))
+    return errorCodeToError(EC);
+  {
+    raw_fd_ostream OS(FD, /*shouldClose=*/true);
+    NewState.write(OS);
+  }
+  if (std::error_code EC = sys::fs::rename(TempPath, StateFile)) {
+    sys::fs::remove(TempPath);
+    return errorCodeToError(EC);
+  }
+  return Error::success();
+}
+
 Error LTO::runThinLTO(AddStreamFn AddStream, NativeObjectCache Cache) {
   if (ThinLTO.ModuleMap.empty())
     return Error::success();
@@ -1102,9 +1367,16 @@ Error LTO::runThinLTO(AddStreamFn AddStream, NativeObjectCache Cache) {
       ThinLTO.ModuleMap.size());
   StringMap<std::map<GlobalValue::GUID, GlobalValue::LinkageTypes>> ResolvedODR;
 
-  if (Conf.OptLevel > 0)
-    ComputeCrossModuleImport(ThinLTO.CombinedIndex, ModuleToDefinedGVSummaries,
-                             ImportLists, ExportLists);
+  if (Conf.OptLevel > 0) {
+    if (Conf.ThinLTOImportStateFile.empty())
+      ComputeCrossModuleImport(ThinLTO.CombinedIndex,
+                               ModuleToDefinedGVSummaries, ImportLists,
+                               ExportLists);
+    else if (Error E = computeImportsIncrementally(
+                 Conf.ThinLTOImportStateFile, ThinLTO.CombinedIndex,
+                 ModuleToDefinedGVSummaries, ImportLists, ExportLists))
+      return E;
+  }
 
   // Figure out which symbols need to be internalized. This also needs to happen
   // at -O0 because summary-based DCE is implemented using internalization, and
@@ -22,6 +22,7 @@
 #include "llvm/Bitcode/BitcodeReader.h"
 #include "llvm/Bitcode/BitcodeWriter.h"
 #include "llvm/IR/LegacyPassManager.h"
+#include "llvm/IR/ModuleSummaryIndexTable.h"
 #include "llvm/IR/PassManager.h"
 #include "llvm/IR/Verifier.h"
 #include "llvm/LTO/LTO.h"
@@ -325,7 +326,7 @@ void splitCodeGen(Config &C, TargetMachine *TM, AddStreamFn AddStream,
             // copied into the thread's context.
             std::move(BC), ThreadCount++);
       },
-      false);
+      /*PreserveLocals=*/false, /*BalanceByCost=*/true);
 
   // Because the inner lambda (which runs in a worker thread) captures our local
   // variables, we need to wait for the worker threads to terminate before we
@@ -450,3 +451,97 @@ Error lto::thinBackend(Config &Conf, unsigned Task, AddStreamFn AddStream,
   codegen(Conf, TM.get(), AddStream, Task, Mod);
   return Error::success();
 }
+
+// Returns the ThinLTO module in the bitcode file in MBRef.
+static Expected<BitcodeModule> findThinLTOModule(MemoryBufferRef MBRef) {
+  Expected<std::vector<BitcodeModule>> BMsOrErr = getBitcodeModuleList(MBRef);
+  if (!BMsOrErr)
+    return BMsOrErr.takeError();
+
+  for (BitcodeModule &BM : *BMsOrErr) {
+    Expected<BitcodeLTOInfo> LTOInfo = BM.getLTOInfo();
+    if (!LTOInfo)
+      return LTOInfo.takeError();
+    if (LTOInfo->IsThinLTO)
+      return BM;
+  }
+
+  return make_error<StringError>("could not find module summary in " +
+                                     MBRef.getBufferIdentifier(),
+                                 inconvertibleErrorCode());
+}
+
+Error lto::thinBackendWorker(Config &Conf, StringRef ModulePath,
+                             StringRef IndexPath, AddStreamFn AddStream) {
+  ErrorOr<std::unique_ptr<MemoryBuffer>> IndexMBOrErr =
+      MemoryBuffer::getFile(IndexPath);
+  if (!IndexMBOrErr)
+    return errorCodeToError(IndexMBOrErr.getError());
+  MemoryBufferRef IndexMBRef = **IndexMBOrErr;
+
+  // The index is either an individual index or a summary table, from which
+  // only the part needed for ModulePath is read.
+  std::unique_ptr<ModuleSummaryIndex> Index;
+  if (summarytab::isSummaryTable(IndexMBRef.getBuffer())) {
+    Expected<summarytab::Reader> ReaderOrErr =
+        summarytab::Reader::create(IndexMBRef.getBuffer());
+    if (!ReaderOrErr)
+      return ReaderOrErr.takeError();
+    Index = llvm::make_unique<ModuleSummaryIndex>();
+    if (Error Err = ReaderOrErr->materializeForModule(ModulePath, *Index))
+      return Err;
+  } else {
+    Expected<std::unique_ptr<ModuleSummaryIndex>> IndexOrErr =
+        getModuleSummaryIndex(IndexMBRef);
+    if (!IndexOrErr)
+      return IndexOrErr.takeError();
+    Index = std::move(*IndexOrErr);
+  }
+  ModuleSummaryIndex &CombinedIndex = *Index;
+
+  // The individual index only contains the summaries of the values defined in
+  // ModulePath and of the values it imports, so everything defined elsewhere
+  // is to be imported.
+  FunctionImporter::ImportMapTy ImportList;
+  for (auto &GlobalList : CombinedIndex) {
+    if (GlobalList.second.SummaryList.empty())
+      continue;
+    auto &Summary = GlobalList.second.SummaryList.front();
+    if (Summary->modulePath() != ModulePath)
+      ImportList[Summary->modulePath()][GlobalList.first] = 1;
+  }
+
+  std::vector<std::unique_ptr<MemoryBuffer>> OwnedBuffers;
+  auto LoadModule = [&](StringRef Path) -> Expected<BitcodeModule> {
+    ErrorOr<std::unique_ptr<MemoryBuffer>> MBOrErr =
+        MemoryBuffer::getFile(Path);
+    if (!MBOrErr)
+      return errorCodeToError(MBOrErr.getError());
+    OwnedBuffers.push_back(std::move(*MBOrErr));
+    return findThinLTOModule(*OwnedBuffers.back());
+  };
+
+  MapVector<StringRef, BitcodeModule> ModuleMap;
+  for (auto &I : ImportList) {
+    Expected<BitcodeModule> BMOrErr = LoadModule(I.first());
+    if (!BMOrErr)
+      return BMOrErr.takeError();
+    ModuleMap.insert({I.first(), *BMOrErr});
+  }
+
+  Expected<BitcodeModule> BMOrErr = LoadModule(ModulePath);
+  if (!BMOrErr)
+    return BMOrErr.takeError();
+
+  LTOLLVMContext BackendContext(Conf);
+  Expected<std::unique_ptr<Module>> MOrErr =
+      BMOrErr->parseModule(BackendContext);
+  if (!MOrErr)
+    return MOrErr.takeError();
+
+  StringMap<GVSummaryMapTy> ModuleToDefinedGVSummaries;
+  CombinedIndex.collectDefinedGVSummariesPerModule(ModuleToDefinedGVSummaries);
+  return thinBackend(Conf, /*Task=*/0, AddStream, **MOrErr, CombinedIndex,
+                     ImportList, ModuleToDefinedGVSummaries[ModulePath],
+                     ModuleMap);
+}
@@ -1047,8 +1047,10 @@ void ELFObjectWriter::writeSectionData(const MCAssembler &Asm, MCSection &Sec,
   Asm.writeSectionData(&Section, Layout);
   setStream(OldStream);
 
+  // Large sections are compressed in chunks on all threads; the chunks still
+  // form a single zlib stream.
   SmallVector<char, 128> CompressedContents;
-  if (Error E = zlib::compress(
+  if (Error E = zlib::compressParallel(
           StringRef(UncompressedData.data(), UncompressedData.size()),
           CompressedContents)) {
     consumeError(std::move(E));
@@ -14,7 +14,9 @@
 #include "llvm/BinaryFormat/COFF.h"
 #include "llvm/Support/Endian.h"
 #include "llvm/Support/MathExtras.h"
+#include "llvm/Support/Parallel.h"
 #include "llvm/Support/raw_ostream.h"
+#include <algorithm>
 #include <cassert>
 #include <cstddef>
 #include <cstdint>
@@ -115,6 +117,53 @@ tailcall:
   }
 }
 
+// Sorts the strings in the order of multikeySort(Vec, 0). Large tables are
+// first bucketed by their last two characters, which orders them like the
+// first two levels of multikeySort would, and the buckets are then sorted in
+// parallel. Since the strings are distinct, the order, and thus the table, is
+// the same as that of the serial sort.
+static void sortStrings(MutableArrayRef<StringPair *> Vec) {
+  // Below this size, clearing the bucket counts costs about as much as the
+  // sort itself.
+  if (Vec.size() < (1 << 16)) {
+    multikeySort(Vec, 0);
+    return;
+  }
+
+  // The buckets are numbered in the reverse order of the sort, so that e.g.
+  // the empty string, which is sorted last, is in bucket 0.
+  const size_t NumBuckets = 257 * 257;
+  auto getBucket = [](StringPair *P) {
+    return (charTailAt(P, 0) + 1) * 257 + charTailAt(P, 1) + 1;
+  };
+
+  std::vector<size_t> Offsets(NumBuckets);
+  for (StringPair *P : Vec)
+    ++Offsets[getBucket(P)];
+  size_t Offset = 0;
+  for (size_t I = NumBuckets; I-- != 0;) {
+    size_t Count = Offsets[I];
+    Offsets[I] = Offset;
+    Offset += Count;
+  }
+
+  std::vector<StringPair *> Sorted(Vec.size());
+  std::vector<size_t> Ends(Offsets);
+  for (StringPair *P : Vec)
+    Sorted[Ends[getBucket(P)]++] = P;
+
+  std::vector<MutableArrayRef<StringPair *>> Buckets;
+  for (size_t I = 0; I != NumBuckets; ++I)
+    if (Ends[I] - Offsets[I] > 1)
+      Buckets.push_back(MutableArrayRef<StringPair *>(Sorted).slice(
+          Offsets[I], Ends[I] - Offsets[I]));
+  parallel::for_each(parallel::par, Buckets.begin(), Buckets.end(),
+                     [](MutableArrayRef<StringPair *> Bucket) {
+                       multikeySort(Bucket, 2);
+                     });
+  std::copy(Sorted.begin(), Sorted.end(), Vec.begin());
+}
+
 void StringTableBuilder::finalize() {
   finalizeStringTable(/*Optimize=*/true);
 }
@@ -132,7 +181,7 @@ void StringTableBuilder::finalizeStringTable(bool Optimize) {
     for (StringPair &P : StringIndexMap)
       Strings.push_back(&P);
 
-    multikeySort(Strings, 0);
+    sortStrings(Strings);
     initSize();
 
     StringRef Previous;
@@ -247,20 +247,26 @@ Error CoverageMapping::loadFunctionRecord(
   return Error::success();
 }
 
+Error CoverageMapping::loadFromReader(CoverageMappingReader &CoverageReader,
+                                      IndexedInstrProfReader &ProfileReader) {
+  for (auto RecordOrErr : CoverageReader) {
+    if (Error E = RecordOrErr.takeError())
+      return E;
+    const auto &Record = *RecordOrErr;
+    if (Error E = loadFunctionRecord(Record, ProfileReader))
+      return E;
+  }
+  return Error::success();
+}
+
 Expected<std::unique_ptr<CoverageMapping>> CoverageMapping::load(
     ArrayRef<std::unique_ptr<CoverageMappingReader>> CoverageReaders,
     IndexedInstrProfReader &ProfileReader) {
   auto Coverage = std::unique_ptr<CoverageMapping>(new CoverageMapping());
 
-  for (const auto &CoverageReader : CoverageReaders) {
-    for (auto RecordOrErr : *CoverageReader) {
-      if (Error E = RecordOrErr.takeError())
-        return std::move(E);
-      const auto &Record = *RecordOrErr;
-      if (Error E = Coverage->loadFunctionRecord(Record, ProfileReader))
-        return std::move(E);
-    }
-  }
+  for (const auto &CoverageReader : CoverageReaders)
+    if (Error E = Coverage->loadFromReader(*CoverageReader, ProfileReader))
+      return E;
 
   return std::move(Coverage);
 }
@@ -273,8 +279,9 @@ CoverageMapping::load(ArrayRef<StringRef> ObjectFilenames,
     return std::move(E);
   auto ProfileReader = std::move(ProfileReaderOrErr.get());
 
-  SmallVector<std::unique_ptr<CoverageMappingReader>, 4> Readers;
-  SmallVector<std::unique_ptr<MemoryBuffer>, 4> Buffers;
+  // The function records own their names and filenames, so each object and
+  // its reader can be released as soon as its records have been loaded.
+  auto Coverage = std::unique_ptr<CoverageMapping>(new CoverageMapping());
   for (const auto &File : llvm::enumerate(ObjectFilenames)) {
     auto CovMappingBufOrErr = MemoryBuffer::getFileOrSTDIN(File.value());
     if (std::error_code EC = CovMappingBufOrErr.getError())
@@ -284,10 +291,11 @@ CoverageMapping::load(ArrayRef<StringRef> ObjectFilenames,
         BinaryCoverageReader::create(CovMappingBufOrErr.get(), Arch);
     if (Error E = CoverageReaderOrErr.takeError())
       return std::move(E);
-    Readers.push_back(std::move(CoverageReaderOrErr.get()));
-    Buffers.push_back(std::move(CovMappingBufOrErr.get()));
+    if (Error E = Coverage->loadFromReader(**CoverageReaderOrErr,
+                                           *ProfileReader))
+      return E;
   }
-  return load(Readers, *ProfileReader);
+  return Coverage;
 }
 
 namespace {
@@ -22,6 +22,7 @@
 #include "llvm/Support/Endian.h"
 #include "llvm/Support/Error.h"
 #include "llvm/Support/ErrorOr.h"
+#include "llvm/Support/MathExtras.h"
 #include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/SwapByteOrder.h"
 #include <algorithm>
@@ -548,6 +549,162 @@ data_type InstrProfLookupTrait::ReadData(StringRef K, const unsigned char *D,
   return DataBuffer;
 }
 
+// Return the size of a ValueProfRecord header, including the padding, as
+// getValueProfRecordHeaderSize() does.
+static uint32_t getRecordHeaderSize(uint32_t NumValueSites) {
+  return alignTo(offsetof(ValueProfRecord, SiteCountArray) + NumValueSites,
+                 sizeof(uint64_t));
+}
+
+// Check that the value profile data at D is well formed, as
+// ValueProfData::getValueProfData() does, without copying it, and return its
+// size.
+static Expected<uint32_t>
+checkValueProfData(const unsigned char *D, const unsigned char *const End,
+                   support::endianness Endianness) {
+  using namespace support;
+
+  auto Malformed = [] {
+    return make_error<InstrProfError>(instrprof_error::malformed);
+  };
+  if (D + sizeof(ValueProfData) > End)
+    return Malformed();
+  uint32_t TotalSize = endian::read<uint32_t, unaligned>(D, Endianness);
+  uint32_t NumValueKinds =
+      endian::read<uint32_t, unaligned>(D + sizeof(uint32_t), Endianness);
+  if (TotalSize < sizeof(ValueProfData) || TotalSize % sizeof(uint64_t) ||
+      D + TotalSize > End || NumValueKinds > IPVK_Last + 1)
+    return Malformed();
+
+  const unsigned char *RecordEnd = D + TotalSize;
+  const unsigned char *R = D + sizeof(ValueProfData);
+  for (uint32_t K = 0; K < NumValueKinds; K++) {
+    if (R + offsetof(ValueProfRecord, SiteCountArray) > RecordEnd)
+      return Malformed();
+    uint32_t Kind = endian::read<uint32_t, unaligned>(R, Endianness);
+    uint32_t NumValueSites =
+        endian::read<uint32_t, unaligned>(R + sizeof(uint32_t), Endianness);
+    if (Kind > IPVK_Last ||
+        R + getRecordHeaderSize(NumValueSites) > RecordEnd)
+      return Malformed();
+    const unsigned char *SiteCounts =
+        R + offsetof(ValueProfRecord, SiteCountArray);
+    uint32_t NumValueData = 0;
+    for (uint32_t I = 0; I < NumValueSites; I++)
+      NumValueData += SiteCounts[I];
+    R += getRecordHeaderSize(NumValueSites) +
+         sizeof(InstrProfValueData) * NumValueData;
+    if (R > RecordEnd)
+      return Malformed();
+  }
+  return TotalSize;
+}
+
+Expected<InstrProfRecordRef>
+InstrProfLookupTrait::findRecord(const unsigned char *D, offset_type N,
+                                 uint64_t FuncHash) {
+  using namespace support;
+
+  // The records are laid out as ReadData() expects them, but they are only
+  // skipped over here, checking that they are well formed.
+  if (N % sizeof(uint64_t))
+    return make_error<InstrProfError>(instrprof_error::malformed);
+
+  const unsigned char *End = D + N;
+  while (D < End) {
+    if (D + sizeof(uint64_t) >= End)
+      return make_error<InstrProfError>(instrprof_error::malformed);
+    uint64_t Hash = endian::readNext<uint64_t, little, unaligned>(D);
+
+    uint64_t CountsSize = N / sizeof(uint64_t) - 1;
+    if (GET_VERSION(FormatVersion) != IndexedInstrProf::ProfVersion::Version1) {
+      if (D + sizeof(uint64_t) > End)
+        return make_error<InstrProfError>(instrprof_error::malformed);
+      CountsSize = endian::readNext<uint64_t, little, unaligned>(D);
+    }
+    if (D + CountsSize * sizeof(uint64_t) > End)
+      return make_error<InstrProfError>(instrprof_error::malformed);
+    ArrayRef<support::ulittle64_t> Counts(
+        reinterpret_cast<const support::ulittle64_t *>(D), CountsSize);
+    D += CountsSize * sizeof(uint64_t);
+
+    const unsigned char *ValueData = nullptr;
+    if (GET_VERSION(FormatVersion) > IndexedInstrProf::ProfVersion::Version2) {
+      Expected<uint32_t> SizeOrErr =
+          checkValueProfData(D, End, ValueProfDataEndianness);
+      if (!SizeOrErr)
+        return SizeOrErr.takeError();
+      ValueData = D;
+      D += *SizeOrErr;
+    }
+
+    if (Hash == FuncHash)
+      return InstrProfRecordRef(Hash, Counts, ValueData,
+                                ValueProfDataEndianness);
+  }
+  return make_error<InstrProfError>(instrprof_error::hash_mismatch);
+}
+
+uint32_t InstrProfRecordRef::getNumValueSites(uint32_t ValueKind) const {
+  using namespace support;
+
+  if (!ValueData)
+    return 0;
+  uint32_t NumValueKinds = endian::read<uint32_t, unaligned>(
+      ValueData + sizeof(uint32_t), ValueDataEndianness);
+  const unsigned char *R = ValueData + sizeof(ValueProfData);
+  for (uint32_t K = 0; K < NumValueKinds; K++) {
+    uint32_t Kind = endian::read<uint32_t, unaligned>(R, ValueDataEndianness);
+    uint32_t NumValueSites = endian::read<uint32_t, unaligned>(
+        R + sizeof(uint32_t), ValueDataEndianness);
+    if (Kind == ValueKind)
+      return NumValueSites;
+    const unsigned char *SiteCounts =
+        R + offsetof(ValueProfRecord, SiteCountArray);
+    uint32_t NumValueData = 0;
+    for (uint32_t I = 0; I < NumValueSites; I++)
+      NumValueData += SiteCounts[I];
+    R += getRecordHeaderSize(NumValueSites) +
+         sizeof(InstrProfValueData) * NumValueData;
+  }
+  return 0;
+}
+
+Error InstrProfRecordRef::readValueProfData(InstrProfRecord &Record) const {
+  using namespace support;
+
+  if (!ValueData)
+    return Error::success();
+  uint32_t TotalSize =
+      endian::read<uint32_t, unaligned>(ValueData, ValueDataEndianness);
+  Expected<std::unique_ptr<ValueProfData>> VDataPtrOrErr =
+      ValueProfData::getValueProfData(ValueData, ValueData + TotalSize,
+                                      ValueDataEndianness);
+  if (Error E = VDataPtrOrErr.takeError())
+    return E;
+  VDataPtrOrErr.get()->deserializeTo(Record, nullptr);
+  return Error::success();
+}
+
+Expected<InstrProfRecord> InstrProfRecordRef::getRecord() const {
+  InstrProfRecord Record(std::vector<uint64_t>(Counts.begin(), Counts.end()));
+  if (Error E = readValueProfData(Record))
+    return E;
+  return Record;
+}
+
+template <typename HashTableImpl>
+Expected<InstrProfRecordRef>
+InstrProfReaderIndex<HashTableImpl>::getRecordRef(StringRef FuncName,
+                                                  uint64_t FuncHash) {
+  auto Iter = HashTable->find(FuncName);
+  if (Iter == HashTable->end())
+    return make_error<InstrProfError>(instrprof_error::unknown_function);
+
+  return HashTable->getInfoObj().findRecord(Iter.getDataPtr(),
+                                            Iter.getDataLen(), FuncHash);
+}
+
 template <typename HashTableImpl>
 Error InstrProfReaderIndex<HashTableImpl>::getRecords(
     StringRef FuncName, ArrayRef<NamedInstrProfRecord> &Data) {
@@ -704,31 +861,37 @@ InstrProfSymtab &IndexedInstrProfReader::getSymtab() {
   return *Symtab.get();
 }
 
+Expected<InstrProfRecordRef>
+IndexedInstrProfReader::getInstrProfRecordRef(StringRef FuncName,
+                                              uint64_t FuncHash) {
+  Expected<InstrProfRecordRef> Ref = Index->getRecordRef(FuncName, FuncHash);
+  if (Ref)
+    return Ref;
+  // Of the lookup errors, only a hash mismatch is recorded as the last error.
+  instrprof_error Err = InstrProfError::take(Ref.takeError());
+  if (Err == instrprof_error::hash_mismatch)
+    return error(Err);
+  return make_error<InstrProfError>(Err);
+}
+
 Expected<InstrProfRecord>
 IndexedInstrProfReader::getInstrProfRecord(StringRef FuncName,
                                            uint64_t FuncHash) {
-  ArrayRef<NamedInstrProfRecord> Data;
-  Error Err = Index->getRecords(FuncName, Data);
-  if (Err)
-    return std::move(Err);
-  // Found it. Look for counters with the right hash.
-  for (unsigned I = 0, E = Data.size(); I < E; ++I) {
-    // Check for a match and fill the vector if there is one.
-    if (Data[I].Hash == FuncHash) {
-      return std::move(Data[I]);
-    }
-  }
-  return error(instrprof_error::hash_mismatch);
+  // Only the record with the right hash is decoded.
+  Expected<InstrProfRecordRef> Ref = getInstrProfRecordRef(FuncName, FuncHash);
+  if (!Ref)
+    return Ref.takeError();
+  return Ref->getRecord();
 }
 
 Error IndexedInstrProfReader::getFunctionCounts(StringRef FuncName,
                                                 uint64_t FuncHash,
                                                 std::vector<uint64_t> &Counts) {
-  Expected<InstrProfRecord> Record = getInstrProfRecord(FuncName, FuncHash);
-  if (Error E = Record.takeError())
+  Expected<InstrProfRecordRef> Ref = getInstrProfRecordRef(FuncName, FuncHash);
+  if (Error E = Ref.takeError())
     return error(std::move(E));
 
-  Counts = Record.get().Counts;
+  Counts.assign(Ref->getCounts().begin(), Ref->getCounts().end());
   return success();
 }
 
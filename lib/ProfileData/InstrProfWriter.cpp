@@ -216,6 +216,19 @@ void InstrProfWriter::mergeRecordsFromWriter(InstrProfWriter &&IPW,
   for (auto &I : IPW.FunctionData)
     for (auto &Func : I.getValue())
       addRecord(I.getKey(), Func.first, std::move(Func.second), 1, Warn);
+  for (auto &Shard : IPW.Shards)
+    for (auto &I : Shard)
+      for (auto &Func : I.getValue())
+        addRecord(I.getKey(), Func.first, std::move(Func.second), 1, Warn);
+}
+
+void InstrProfWriter::addShard(InstrProfWriter &&IPW) {
+  if (!IPW.FunctionData.empty())
+    Shards.push_back(std::move(IPW.FunctionData));
+  for (auto &Shard : IPW.Shards)
+    Shards.push_back(std::move(Shard));
+  IPW.FunctionData.clear();
+  IPW.Shards.clear();
 }
 
 bool InstrProfWriter::shouldEncodeData(const ProfilingData &PD) {
@@ -258,6 +271,10 @@ void InstrProfWriter::writeImpl(ProfOStream &OS) {
   for (const auto &I : FunctionData)
     if (shouldEncodeData(I.getValue()))
       Generator.insert(I.getKey(), &I.getValue());
+  for (const auto &Shard : Shards)
+    for (const auto &I : Shard)
+      if (shouldEncodeData(I.getValue()))
+        Generator.insert(I.getKey(), &I.getValue());
   // Write the header.
   IndexedInstrProf::Header Header;
   Header.Magic = IndexedInstrProf::Magic;
@@ -374,16 +391,23 @@ void InstrProfWriter::writeRecordInText(StringRef Name, uint64_t Hash,
 Error InstrProfWriter::writeText(raw_fd_ostream &OS) {
   if (ProfileKind == PF_IRLevel)
     OS << "# IR level Instrumentation Flag\n:ir\n";
+  SmallVector<const StringMap<ProfilingData> *, 1> AllFunctionData;
+  AllFunctionData.push_back(&FunctionData);
+  for (const auto &Shard : Shards)
+    AllFunctionData.push_back(&Shard);
+
   InstrProfSymtab Symtab;
-  for (const auto &I : FunctionData)
-    if (shouldEncodeData(I.getValue()))
-      if (Error E = Symtab.addFuncName(I.getKey()))
-        return E;
+  for (const auto *Data : AllFunctionData)
+    for (const auto &I : *Data)
+      if (shouldEncodeData(I.getValue()))
+        if (Error E = Symtab.addFuncName(I.getKey()))
+          return E;
   Symtab.finalizeSymtab();
 
-  for (const auto &I : FunctionData)
-    if (shouldEncodeData(I.getValue()))
-      for (const auto &Func : I.getValue())
-        writeRecordInText(I.getKey(), Func.first, Func.second, Symtab, OS);
+  for (const auto *Data : AllFunctionData)
+    for (const auto &I : *Data)
+      if (shouldEncodeData(I.getValue()))
+        for (const auto &Func : I.getValue())
+          writeRecordInText(I.getKey(), Func.first, Func.second, Symtab, OS);
   return Error::success();
 }
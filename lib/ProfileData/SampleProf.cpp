@@ -24,6 +24,8 @@
 using namespace llvm;
 using namespace sampleprof;
 
+SampleProfileFormat FunctionSamples::Format;
+
 namespace {
 
 // FIXME: This class is only here to support the transition to llvm::Error. It
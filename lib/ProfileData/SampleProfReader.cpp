@@ -8,15 +8,17 @@
 //===----------------------------------------------------------------------===//
 //
 // This file implements the class that reads LLVM sample profiles. It
-// supports three file formats: text, binary and gcov.
+// supports four file formats: text, binary, compact binary and gcov.
 //
 // The textual representation is useful for debugging and testing purposes. The
-// binary representation is more compact, resulting in smaller file sizes.
+// binary representation is more compact, resulting in smaller file sizes. The
+// compact binary representation is smaller still, and lets the profiles of
+// just the functions of a module be read.
 //
 // The gcov encoding is the one generated by GCC's AutoFDO profile creation
 // tool (https://github.com/google/autofdo)
 //
-// All three encodings can be used interchangeably as an input sample profile.
+// All four encodings can be used interchangeably as an input sample profile.
 //
 //===----------------------------------------------------------------------===//
 
@@ -27,6 +29,7 @@
 #include "llvm/IR/ProfileSummary.h"
 #include "llvm/ProfileData/ProfileCommon.h"
 #include "llvm/ProfileData/SampleProf.h"
+#include "llvm/Support/Endian.h"
 #include "llvm/Support/ErrorOr.h"
 #include "llvm/Support/LEB128.h"
 #include "llvm/Support/LineIterator.h"
@@ -373,29 +376,103 @@ SampleProfileReaderBinary::readProfile(FunctionSamples &FProfile) {
   return sampleprof_error::success;
 }
 
+std::error_code SampleProfileReaderBinary::readFuncProfile() {
+  auto NumHeadSamples = readNumber<uint64_t>();
+  if (std::error_code EC = NumHeadSamples.getError())
+    return EC;
+
+  auto FName(readStringFromTable());
+  if (std::error_code EC = FName.getError())
+    return EC;
+
+  Profiles[*FName] = FunctionSamples();
+  FunctionSamples &FProfile = Profiles[*FName];
+  FProfile.setName(*FName);
+
+  FProfile.addHeadSamples(*NumHeadSamples);
+
+  return readProfile(FProfile);
+}
+
 std::error_code SampleProfileReaderBinary::read() {
   while (!at_eof()) {
-    auto NumHeadSamples = readNumber<uint64_t>();
-    if (std::error_code EC = NumHeadSamples.getError())
+    if (std::error_code EC = readFuncProfile())
       return EC;
+  }
 
-    auto FName(readStringFromTable());
-    if (std::error_code EC = FName.getError())
+  return sampleprof_error::success;
+}
+
+std::error_code SampleProfileReaderCompactBinary::read() {
+  for (const auto &Entry : FuncOffsetTable) {
+    if (!UseAllFuncs && !FuncsToUse.count(Entry.first))
+      continue;
+    Data = ProfilesStart + Entry.second;
+    if (std::error_code EC = readFuncProfile())
       return EC;
+  }
 
-    Profiles[*FName] = FunctionSamples();
-    FunctionSamples &FProfile = Profiles[*FName];
-    FProfile.setName(*FName);
+  return sampleprof_error::success;
+}
 
-    FProfile.addHeadSamples(*NumHeadSamples);
+void SampleProfileReaderCompactBinary::collectFuncsToUse(const Module &M) {
+  UseAllFuncs = false;
+  FuncsToUse.clear();
+  std::string GUIDBuf;
+  for (const auto &F : M) {
+    if (F.isDeclaration())
+      continue;
+    // Strip the suffix as getSamplesFor() does.
+    FuncsToUse.insert(
+        getRepInFormat(F.getName().split('.').first, Format, GUIDBuf));
+  }
+}
+
+std::error_code SampleProfileReaderBinary::verifySPMagic(uint64_t Magic) {
+  if (Magic == SPMagic())
+    return sampleprof_error::success;
+  return sampleprof_error::bad_magic;
+}
 
-    if (std::error_code EC = readProfile(FProfile))
+std::error_code
+SampleProfileReaderCompactBinary::verifySPMagic(uint64_t Magic) {
+  if (Magic == SPMagic(SPF_Compact_Binary))
+    return sampleprof_error::success;
+  return sampleprof_error::bad_magic;
+}
+
+std::error_code SampleProfileReaderBinary::readNameTable() {
+  auto Size = readNumber<uint32_t>();
+  if (std::error_code EC = Size.getError())
+    return EC;
+  NameTable.reserve(*Size);
+  for (uint32_t I = 0; I < *Size; ++I) {
+    auto Name(readString());
+    if (std::error_code EC = Name.getError())
       return EC;
+    NameTable.push_back(*Name);
   }
 
   return sampleprof_error::success;
 }
 
+std::error_code SampleProfileReaderCompactBinary::readNameTable() {
+  auto Size = readNumber<uint32_t>();
+  if (std::error_code EC = Size.getError())
+    return EC;
+  GUIDNames.reserve(*Size);
+  for (uint32_t I = 0; I < *Size; ++I) {
+    auto GUID = readNumber<uint64_t>();
+    if (std::error_code EC = GUID.getError())
+      return EC;
+    GUIDNames.push_back(std::to_string(*GUID));
+  }
+
+  // NameTable refers to the strings in GUIDNames, which no longer move.
+  NameTable.assign(GUIDNames.begin(), GUIDNames.end());
+  return sampleprof_error::success;
+}
+
 std::error_code SampleProfileReaderBinary::readHeader() {
   Data = reinterpret_cast<const uint8_t *>(Buffer->getBufferStart());
   End = Data + Buffer->getBufferSize();
@@ -404,8 +481,8 @@ std::error_code SampleProfileReaderBinary::readHeader() {
   auto Magic = readNumber<uint64_t>();
   if (std::error_code EC = Magic.getError())
     return EC;
-  else if (*Magic != SPMagic())
-    return sampleprof_error::bad_magic;
+  else if (std::error_code EC = verifySPMagic(*Magic))
+    return EC;
 
   // Read the version number.
   auto Version = readNumber<uint64_t>();
@@ -417,18 +494,47 @@ std::error_code SampleProfileReaderBinary::readHeader() {
   if (std::error_code EC = readSummary())
     return EC;
 
-  // Read the name table.
-  auto Size = readNumber<uint32_t>();
+  return readNameTable();
+}
+
+std::error_code SampleProfileReaderCompactBinary::readHeader() {
+  if (std::error_code EC = SampleProfileReaderBinary::readHeader())
+    return EC;
+  ProfilesStart = Data;
+  return readFuncOffsetTable();
+}
+
+std::error_code SampleProfileReaderCompactBinary::readFuncOffsetTable() {
+  // The offset of the table is stored in the last 8 bytes of the file.
+  if (End - ProfilesStart < static_cast<ptrdiff_t>(sizeof(uint64_t)))
+    return sampleprof_error::truncated;
+  const uint8_t *TableEnd = End - sizeof(uint64_t);
+  uint64_t TableOffset = support::endian::read64le(TableEnd);
+  if (TableOffset > static_cast<uint64_t>(TableEnd - ProfilesStart))
+    return sampleprof_error::malformed;
+
+  Data = ProfilesStart + TableOffset;
+  End = TableEnd;
+  auto Size = readNumber<uint64_t>();
   if (std::error_code EC = Size.getError())
     return EC;
-  NameTable.reserve(*Size);
-  for (uint32_t I = 0; I < *Size; ++I) {
-    auto Name(readString());
-    if (std::error_code EC = Name.getError())
+  FuncOffsetTable.reserve(std::min<uint64_t>(*Size, End - Data));
+  for (uint64_t I = 0; I < *Size; ++I) {
+    auto FName(readStringFromTable());
+    if (std::error_code EC = FName.getError())
       return EC;
-    NameTable.push_back(*Name);
+
+    auto Offset = readNumber<uint64_t>();
+    if (std::error_code EC = Offset.getError())
+      return EC;
+    if (*Offset >= TableOffset)
+      return sampleprof_error::malformed;
+
+    FuncOffsetTable.emplace_back(*FName, *Offset);
   }
 
+  // The profiles of the functions end where the table starts.
+  End = ProfilesStart + TableOffset;
   return sampleprof_error::success;
 }
 
@@ -495,6 +601,13 @@ bool SampleProfileReaderBinary::hasFormat(const MemoryBuffer &Buffer) {
   return Magic == SPMagic();
 }
 
+bool SampleProfileReaderCompactBinary::hasFormat(const MemoryBuffer &Buffer) {
+  const uint8_t *Data =
+      reinterpret_cast<const uint8_t *>(Buffer.getBufferStart());
+  uint64_t Magic = decodeULEB128(Data);
+  return Magic == SPMagic(SPF_Compact_Binary);
+}
+
 std::error_code SampleProfileReaderGCC::skipNextWord() {
   uint32_t dummy;
   if (!GcovBuffer.readInt(dummy))
@@ -782,6 +895,8 @@ SampleProfileReader::create(std::unique_ptr<MemoryBuffer> &B, LLVMContext &C) {
   std::unique_ptr<SampleProfileReader> Reader;
   if (SampleProfileReaderBinary::hasFormat(*B))
     Reader.reset(new SampleProfileReaderBinary(std::move(B), C));
+  else if (SampleProfileReaderCompactBinary::hasFormat(*B))
+    Reader.reset(new SampleProfileReaderCompactBinary(std::move(B), C));
   else if (SampleProfileReaderGCC::hasFormat(*B))
     Reader.reset(new SampleProfileReaderGCC(std::move(B), C));
   else if (SampleProfileReaderText::hasFormat(*B))
@@ -789,6 +904,7 @@ SampleProfileReader::create(std::unique_ptr<MemoryBuffer> &B, LLVMContext &C) {
   else
     return sampleprof_error::unrecognized_format;
 
+  FunctionSamples::Format = Reader->getFormat();
   if (std::error_code EC = Reader->readHeader())
     return EC;
 
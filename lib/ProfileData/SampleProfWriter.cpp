@@ -8,10 +8,10 @@
 //===----------------------------------------------------------------------===//
 //
 // This file implements the class that writes LLVM sample profiles. It
-// supports two file formats: text and binary. The textual representation
-// is useful for debugging and testing purposes. The binary representation
-// is more compact, resulting in smaller file sizes. However, they can
-// both be used interchangeably.
+// supports three file formats: text, binary and compact binary. The textual
+// representation is useful for debugging and testing purposes. The binary
+// representations are more compact, resulting in smaller file sizes. However,
+// they can all be used interchangeably.
 //
 // See lib/ProfileData/SampleProfReader.cpp for documentation on each of the
 // supported formats.
@@ -22,6 +22,7 @@
 #include "llvm/ADT/StringRef.h"
 #include "llvm/ProfileData/ProfileCommon.h"
 #include "llvm/ProfileData/SampleProf.h"
+#include "llvm/Support/EndianStream.h"
 #include "llvm/Support/ErrorOr.h"
 #include "llvm/Support/FileSystem.h"
 #include "llvm/Support/LEB128.h"
@@ -144,13 +145,28 @@ void SampleProfileWriterBinary::addNames(const FunctionSamples &S) {
     }
 }
 
-std::error_code SampleProfileWriterBinary::writeHeader(
-    const StringMap<FunctionSamples> &ProfileMap) {
+std::error_code SampleProfileWriterBinary::writeMagicIdent() {
   auto &OS = *OutputStream;
 
   // Write file magic identifier.
   encodeULEB128(SPMagic(), OS);
   encodeULEB128(SPVersion(), OS);
+  return sampleprof_error::success;
+}
+
+std::error_code SampleProfileWriterCompactBinary::writeMagicIdent() {
+  auto &OS = *OutputStream;
+
+  // Write file magic identifier.
+  encodeULEB128(SPMagic(SPF_Compact_Binary), OS);
+  encodeULEB128(SPVersion(), OS);
+  return sampleprof_error::success;
+}
+
+std::error_code SampleProfileWriterBinary::writeHeader(
+    const StringMap<FunctionSamples> &ProfileMap) {
+  if (std::error_code EC = writeMagicIdent())
+    return EC;
 
   computeSummary(ProfileMap);
   if (auto EC = writeSummary())
@@ -166,19 +182,45 @@ std::error_code SampleProfileWriterBinary::writeHeader(
   std::set<StringRef> V;
   for (const auto &I : NameTable)
     V.insert(I.first);
-  int i = 0;
+  NameTable.clear();
+  uint32_t i = 0;
   for (const StringRef &N : V)
-    NameTable[N] = i++;
+    NameTable.insert(std::make_pair(N, i++));
 
-  // Write out the name table.
+  return writeNameTable();
+}
+
+std::error_code SampleProfileWriterBinary::writeNameTable() {
+  auto &OS = *OutputStream;
+
+  // Write out the name table, which is sorted by name.
   encodeULEB128(NameTable.size(), OS);
-  for (auto N : V) {
-    OS << N;
+  for (const auto &N : NameTable) {
+    OS << N.first;
     encodeULEB128(0, OS);
   }
   return sampleprof_error::success;
 }
 
+std::error_code SampleProfileWriterCompactBinary::writeNameTable() {
+  auto &OS = *OutputStream;
+
+  // Write out the MD5 hashes of the names in place of the names.
+  encodeULEB128(NameTable.size(), OS);
+  for (const auto &N : NameTable)
+    encodeULEB128(FunctionSamples::getGUID(N.first), OS);
+  return sampleprof_error::success;
+}
+
+std::error_code SampleProfileWriterCompactBinary::writeHeader(
+    const StringMap<FunctionSamples> &ProfileMap) {
+  if (std::error_code EC = SampleProfileWriterBinary::writeHeader(ProfileMap))
+    return EC;
+  ProfilesStart = OutputStream->tell();
+  FuncOffsetTable.clear();
+  return sampleprof_error::success;
+}
+
 std::error_code SampleProfileWriterBinary::writeSummary() {
   auto &OS = *OutputStream;
   encodeULEB128(Summary->getTotalCount(), OS);
@@ -247,6 +289,39 @@ std::error_code SampleProfileWriterBinary::write(const FunctionSamples &S) {
   return writeBody(S);
 }
 
+/// \brief Write samples of a top-level function to a compact binary file,
+/// recording the offset of the function in the function offset table.
+std::error_code
+SampleProfileWriterCompactBinary::write(const FunctionSamples &S) {
+  FuncOffsetTable.emplace_back(S.getName(),
+                               OutputStream->tell() - ProfilesStart);
+  return SampleProfileWriterBinary::write(S);
+}
+
+std::error_code SampleProfileWriterCompactBinary::write(
+    const StringMap<FunctionSamples> &ProfileMap) {
+  if (std::error_code EC = SampleProfileWriter::write(ProfileMap))
+    return EC;
+  return writeFuncOffsetTable();
+}
+
+/// \brief Write the function offset table, followed by its offset relative to
+/// the start of the function profiles as a fixed-size little-endian number
+/// that a reader finds at the end of the file.
+std::error_code SampleProfileWriterCompactBinary::writeFuncOffsetTable() {
+  auto &OS = *OutputStream;
+  uint64_t TableOffset = OS.tell() - ProfilesStart;
+
+  encodeULEB128(FuncOffsetTable.size(), OS);
+  for (const auto &Entry : FuncOffsetTable) {
+    if (std::error_code EC = writeNameIdx(Entry.first))
+      return EC;
+    encodeULEB128(Entry.second, OS);
+  }
+  support::endian::Writer<support::little>(OS).write<uint64_t>(TableOffset);
+  return sampleprof_error::success;
+}
+
 /// \brief Create a sample profile file writer based on the specified format.
 ///
 /// \param Filename The file to create.
@@ -258,7 +333,7 @@ ErrorOr<std::unique_ptr<SampleProfileWriter>>
 SampleProfileWriter::create(StringRef Filename, SampleProfileFormat Format) {
   std::error_code EC;
   std::unique_ptr<raw_ostream> OS;
-  if (Format == SPF_Binary)
+  if (Format == SPF_Binary || Format == SPF_Compact_Binary)
     OS.reset(new raw_fd_ostream(Filename, EC, sys::fs::F_None));
   else
     OS.reset(new raw_fd_ostream(Filename, EC, sys::fs::F_Text));
@@ -283,6 +358,8 @@ SampleProfileWriter::create(std::unique_ptr<raw_ostream> &OS,
 
   if (Format == SPF_Binary)
     Writer.reset(new SampleProfileWriterBinary(OS));
+  else if (Format == SPF_Compact_Binary)
+    Writer.reset(new SampleProfileWriterCompactBinary(OS));
   else if (Format == SPF_Text)
     Writer.reset(new SampleProfileWriterText(OS));
   else if (Format == SPF_GCC)
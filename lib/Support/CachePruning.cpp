@@ -13,10 +13,13 @@
 
 #include "llvm/Support/CachePruning.h"
 
+#include "llvm/ADT/StringMap.h"
 #include "llvm/Support/Debug.h"
 #include "llvm/Support/Errc.h"
 #include "llvm/Support/Error.h"
 #include "llvm/Support/FileSystem.h"
+#include "llvm/Support/LineIterator.h"
+#include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/Path.h"
 #include "llvm/Support/raw_ostream.h"
 
@@ -27,6 +30,28 @@
 
 using namespace llvm;
 
+namespace {
+/// A cache entry considered for size-based pruning.
+struct CacheEntryInfo {
+  /// Recorded cost to produce the entry in milliseconds, 0 if unknown.
+  uint64_t Cost;
+  uint64_t Size;
+  std::string Path;
+
+  /// Entries are pruned in this order: by increasing cost per byte, then by
+  /// decreasing size.
+  bool operator<(const CacheEntryInfo &Other) const {
+    // Compare Cost / Size against Other.Cost / Other.Size without dividing.
+    uint64_t L = Cost * Other.Size, R = Other.Cost * Size;
+    if (L != R)
+      return L < R;
+    if (Size != Other.Size)
+      return Size > Other.Size;
+    return Path > Other.Path;
+  }
+};
+} // end anonymous namespace
+
 /// Write a new timestamp file with the given path. This is used for the pruning
 /// interval option.
 static void writeTimestampFile(StringRef TimestampFile) {
@@ -34,6 +59,54 @@ static void writeTimestampFile(StringRef TimestampFile) {
   raw_fd_ostream Out(TimestampFile.str(), EC, sys::fs::F_None);
 }
 
+static void getCostFilePath(StringRef Path, SmallVectorImpl<char> &CostFile) {
+  CostFile.assign(Path.begin(), Path.end());
+  sys::path::append(CostFile, "llvmcache.costs");
+}
+
+/// Read the cost records appended by recordCacheEntryCost(). Later records for
+/// an entry override earlier ones.
+static StringMap<uint64_t> readCostFile(StringRef CostFile) {
+  StringMap<uint64_t> Costs;
+  ErrorOr<std::unique_ptr<MemoryBuffer>> BufOrErr =
+      MemoryBuffer::getFile(CostFile);
+  if (!BufOrErr)
+    return Costs;
+  for (line_iterator I(**BufOrErr), E; I != E; ++I) {
+    StringRef Name, CostStr;
+    std::tie(Name, CostStr) = I->split(' ');
+    uint64_t Cost;
+    if (!CostStr.getAsInteger(10, Cost))
+      Costs[Name] = Cost;
+  }
+  return Costs;
+}
+
+/// Rewrite the cost file with the records of the entries still in the cache.
+/// Records appended by other processes while we prune may be lost, which only
+/// makes those entries look cheap to the next prune.
+static void writeCostFile(StringRef CostFile, const StringMap<uint64_t> &Costs,
+                          const std::set<CacheEntryInfo> &Remaining) {
+  Expected<sys::fs::TempFile> Temp =
+      sys::fs::TempFile::create(CostFile + "-%%%%%%");
+  if (!Temp) {
+    consumeError(Temp.takeError());
+    return;
+  }
+  {
+    raw_fd_ostream OS(Temp->FD, /*shouldClose=*/false);
+    for (const CacheEntryInfo &Entry : Remaining) {
+      StringRef Name = sys::path::filename(Entry.Path);
+      if (Costs.count(Name))
+        OS << Name << ' ' << Entry.Cost << '\n';
+    }
+  }
+  if (Error E = Temp->keep(CostFile)) {
+    DEBUG(dbgs() << "Failed to update " << CostFile << ": "
+                 << toString(std::move(E)) << "\n");
+  }
+}
+
 static Expected<std::chrono::seconds> parseDuration(StringRef Duration) {
   if (Duration.empty())
     return make_error<StringError>("Duration must not be empty",
@@ -185,10 +258,14 @@ bool llvm::pruneCache(StringRef Path, CachePruningPolicy Policy) {
     writeTimestampFile(TimestampFile);
   }
 
-  // Keep track of space. Needs to be kept ordered by size for determinism.
-  std::set<std::pair<uint64_t, std::string>> FileSizes;
+  // Keep track of space. Needs to be kept ordered for determinism.
+  std::set<CacheEntryInfo> Files;
   uint64_t TotalSize = 0;
 
+  SmallString<128> CostFile;
+  getCostFilePath(Path, CostFile);
+  StringMap<uint64_t> Costs = readCostFile(CostFile);
+
   // Walk the entire directory cache, looking for unused files.
   std::error_code EC;
   SmallString<128> CachePathNative;
@@ -200,7 +277,12 @@ bool llvm::pruneCache(StringRef Path, CachePruningPolicy Policy) {
     // includes the timestamp file as well as any files created by the user.
     // This acts as a safeguard against data loss if the user specifies the
     // wrong directory as their cache directory.
-    if (!sys::path::filename(File->path()).startswith("llvmcache-"))
+    StringRef Filename = sys::path::filename(File->path());
+    if (!Filename.startswith("llvmcache-"))
+      continue;
+
+    // Leave the lock files of entries being produced alone.
+    if (Filename.endswith(".lock") || Filename.contains(".lock-"))
       continue;
 
     // Look at this file. If we can't stat it, there's nothing interesting
@@ -223,22 +305,23 @@ bool llvm::pruneCache(StringRef Path, CachePruningPolicy Policy) {
 
     // Leave it here for now, but add it to the list of size-based pruning.
     TotalSize += StatusOrErr->getSize();
-    FileSizes.insert({StatusOrErr->getSize(), std::string(File->path())});
+    Files.insert({Costs.lookup(Filename), StatusOrErr->getSize(),
+                  std::string(File->path())});
   }
 
-  auto FileAndSize = FileSizes.rbegin();
-  size_t NumFiles = FileSizes.size();
+  auto FileInfo = Files.begin();
+  size_t NumFiles = Files.size();
 
   auto RemoveCacheFile = [&]() {
     // Remove the file.
-    sys::fs::remove(FileAndSize->second);
+    sys::fs::remove(FileInfo->Path);
     // Update size
-    TotalSize -= FileAndSize->first;
+    TotalSize -= FileInfo->Size;
     NumFiles--;
-    DEBUG(dbgs() << " - Remove " << FileAndSize->second << " (size "
-                 << FileAndSize->first << "), new occupancy is " << TotalSize
-                 << "%\n");
-    ++FileAndSize;
+    DEBUG(dbgs() << " - Remove " << FileInfo->Path << " (size "
+                 << FileInfo->Size << ", cost " << FileInfo->Cost
+                 << "ms), new occupancy is " << TotalSize << "%\n");
+    ++FileInfo;
   };
 
   // Prune for number of files.
@@ -267,9 +350,30 @@ bool llvm::pruneCache(StringRef Path, CachePruningPolicy Policy) {
                  << "% target is: " << Policy.MaxSizePercentageOfAvailableSpace
                  << "%, " << Policy.MaxSizeBytes << " bytes\n");
 
-    // Remove the oldest accessed files first, till we get below the threshold.
-    while (TotalSize > TotalSizeTarget && FileAndSize != FileSizes.rend())
+    // Remove the cheapest files first, till we get below the threshold.
+    while (TotalSize > TotalSizeTarget && FileInfo != Files.end())
       RemoveCacheFile();
   }
+
+  // Drop the cost records of the entries that are gone.
+  if (!Costs.empty()) {
+    Files.erase(Files.begin(), FileInfo);
+    writeCostFile(CostFile, Costs, Files);
+  }
   return true;
 }
+
+void llvm::recordCacheEntryCost(StringRef Path, StringRef EntryName,
+                                std::chrono::milliseconds Cost) {
+  SmallString<128> CostFile;
+  getCostFilePath(Path, CostFile);
+  // The record is written with a single append, so records from concurrent
+  // writers do not interleave.
+  std::error_code EC;
+  raw_fd_ostream OS(CostFile, EC, sys::fs::F_Append);
+  if (EC) {
+    DEBUG(dbgs() << "Can't open " << CostFile << ": " << EC.message() << "\n");
+    return;
+  }
+  OS << EntryName << ' ' << Cost.count() << '\n';
+}
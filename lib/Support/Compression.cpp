@@ -16,8 +16,13 @@
 #include "llvm/ADT/StringRef.h"
 #include "llvm/Config/config.h"
 #include "llvm/Support/Compiler.h"
+#include "llvm/Support/Endian.h"
 #include "llvm/Support/Error.h"
 #include "llvm/Support/ErrorHandling.h"
+#include "llvm/Support/Parallel.h"
+#include <algorithm>
+#include <cstring>
+#include <vector>
 #if LLVM_ENABLE_ZLIB == 1 && HAVE_ZLIB_H
 #include <zlib.h>
 #endif
@@ -49,6 +54,8 @@ static StringRef convertZlibCodeToString(int Code) {
     return "zlib error: Z_STREAM_ERROR";
   case Z_DATA_ERROR:
     return "zlib error: Z_DATA_ERROR";
+  case Z_VERSION_ERROR:
+    return "zlib error: Z_VERSION_ERROR";
   case Z_OK:
   default:
     llvm_unreachable("unknown or unexpected zlib status code");
@@ -94,6 +101,172 @@ Error zlib::uncompress(StringRef InputBuffer,
   return E;
 }
 
+/// Returns the zlib header deflate() writes for the compression level
+/// \p CLevel: a 32K window and the level hint of the zlib implementation.
+static uint16_t getZlibHeader(int CLevel) {
+  unsigned LevelFlags = 2;
+  if (CLevel != Z_DEFAULT_COMPRESSION)
+    LevelFlags = CLevel < 2 ? 0 : CLevel < 6 ? 1 : CLevel == 6 ? 2 : 3;
+  uint16_t Header = (0x78 << 8) | (LevelFlags << 6);
+  return Header + 31 - Header % 31;
+}
+
+/// Deflates \p Input into \p Output as raw deflate data, which is finished if
+/// \p Last and ends with a sync flush otherwise.
+static int deflateChunk(StringRef Input, int CLevel, bool Last,
+                        SmallVectorImpl<char> &Output) {
+  z_stream Stream = {};
+  int Res = ::deflateInit2(&Stream, CLevel, Z_DEFLATED, -MAX_WBITS, 8,
+                           Z_DEFAULT_STRATEGY);
+  if (Res != Z_OK)
+    return Res;
+  // Leave room for the empty stored block of the sync flush.
+  Output.resize(::deflateBound(&Stream, Input.size()) + 8);
+  Stream.next_in = (Bytef *)const_cast<char *>(Input.data());
+  Stream.avail_in = Input.size();
+  Stream.next_out = (Bytef *)Output.data();
+  Stream.avail_out = Output.size();
+  Res = ::deflate(&Stream, Last ? Z_FINISH : Z_SYNC_FLUSH);
+  bool Done = Last ? Res == Z_STREAM_END
+                   : Res == Z_OK && Stream.avail_out != 0;
+  if (!Done && (Res == Z_OK || Res == Z_STREAM_END))
+    Res = Z_BUF_ERROR;
+  __msan_unpoison(Output.data(), Stream.total_out);
+  Output.resize(Stream.total_out);
+  ::deflateEnd(&Stream);
+  return Done ? Z_OK : Res;
+}
+
+Error zlib::compressParallel(StringRef InputBuffer,
+                             SmallVectorImpl<char> &CompressedBuffer,
+                             CompressionLevel Level, size_t ChunkSize) {
+  assert(ChunkSize > 0 && ChunkSize <= UINT32_MAX && "Invalid chunk size!");
+  if (InputBuffer.size() <= ChunkSize)
+    return compress(InputBuffer, CompressedBuffer, Level);
+
+  int CLevel = encodeZlibCompressionLevel(Level);
+  size_t NumChunks = (InputBuffer.size() + ChunkSize - 1) / ChunkSize;
+  std::vector<SmallVector<char, 0>> Chunks(NumChunks);
+  std::vector<uLong> Checksums(NumChunks);
+  std::vector<int> Results(NumChunks);
+  parallel::for_each_n(parallel::par, size_t(0), NumChunks, [&](size_t I) {
+    StringRef Chunk = InputBuffer.substr(I * ChunkSize, ChunkSize);
+    Results[I] = deflateChunk(Chunk, CLevel, I == NumChunks - 1, Chunks[I]);
+    Checksums[I] = ::adler32(::adler32(0, Z_NULL, 0),
+                             (const Bytef *)Chunk.data(), Chunk.size());
+  });
+  for (int Res : Results)
+    if (Res != Z_OK)
+      return createError(convertZlibCodeToString(Res));
+
+  // Wrap the chunks like deflate() wraps its raw deflate data: the zlib header
+  // in front and the Adler-32 checksum of the whole input at the end.
+  uLong Checksum = Checksums[0];
+  for (size_t I = 1; I != NumChunks; ++I)
+    Checksum = ::adler32_combine(
+        Checksum, Checksums[I],
+        InputBuffer.substr(I * ChunkSize, ChunkSize).size());
+  uint16_t Header = getZlibHeader(CLevel);
+  CompressedBuffer.clear();
+  CompressedBuffer.push_back(Header >> 8);
+  CompressedBuffer.push_back(Header & 0xff);
+  for (const SmallVector<char, 0> &Chunk : Chunks)
+    CompressedBuffer.append(Chunk.begin(), Chunk.end());
+  for (int Shift = 24; Shift >= 0; Shift -= 8)
+    CompressedBuffer.push_back((Checksum >> Shift) & 0xff);
+  return Error::success();
+}
+
+/// Inflates the raw deflate data \p Input into \p Output and returns whether
+/// it is a chunk written by compressParallel(): the last one, which finishes
+/// the stream, if \p Last, otherwise one that ends with a sync flush.
+static bool inflateChunk(StringRef Input, bool Last,
+                         SmallVectorImpl<char> &Output) {
+  z_stream Stream = {};
+  if (::inflateInit2(&Stream, -MAX_WBITS) != Z_OK)
+    return false;
+  Stream.next_in = (Bytef *)const_cast<char *>(Input.data());
+  Stream.avail_in = Input.size();
+  int Res;
+  do {
+    if (Stream.total_out == Output.size())
+      Output.resize(std::max<size_t>(4 * Input.size(), 2 * Output.size()));
+    Stream.next_out = (Bytef *)Output.data() + Stream.total_out;
+    Stream.avail_out = Output.size() - Stream.total_out;
+    Res = ::inflate(&Stream, Z_NO_FLUSH);
+  } while (Res == Z_OK && (Stream.avail_in != 0 || Stream.avail_out == 0));
+
+  // After the empty stored block of a sync flush, inflate() waits for the
+  // header of the next block at a byte boundary; data_type then has the flag
+  // for block boundaries (128) set, and neither the flag for the last block
+  // (64) nor any unused bits.
+  bool Done = Stream.avail_in == 0 &&
+              (Last ? Res == Z_STREAM_END
+                    : (Res == Z_OK || Res == Z_BUF_ERROR) &&
+                          (Stream.data_type & 0xff) == 128);
+  __msan_unpoison(Output.data(), Stream.total_out);
+  Output.resize(Stream.total_out);
+  ::inflateEnd(&Stream);
+  return Done;
+}
+
+Error zlib::uncompressParallel(StringRef InputBuffer, char *UncompressedBuffer,
+                               size_t &UncompressedSize) {
+  // The chunks written by compressParallel() end with the bytes of an empty
+  // stored block, 00 00 ff ff. These bytes can also occur inside compressed
+  // data, so the stream is split at them speculatively: if a chunk does not
+  // end at a sync flush or the checksum does not match, the stream is
+  // uncompressed serially instead.
+  const size_t HeaderSize = 2, TrailerSize = 4;
+  if (InputBuffer.size() < HeaderSize + TrailerSize ||
+      (InputBuffer[0] & 0x0f) != Z_DEFLATED || (InputBuffer[1] & 0x20) ||
+      support::endian::read16be(InputBuffer.data()) % 31 != 0)
+    return uncompress(InputBuffer, UncompressedBuffer, UncompressedSize);
+
+  StringRef Data = InputBuffer.drop_front(HeaderSize).drop_back(TrailerSize);
+  const StringRef SyncFlush("\0\0\xff\xff", 4);
+  std::vector<StringRef> Chunks;
+  for (size_t Pos; (Pos = Data.find(SyncFlush)) != StringRef::npos;) {
+    Chunks.push_back(Data.take_front(Pos + SyncFlush.size()));
+    Data = Data.drop_front(Pos + SyncFlush.size());
+  }
+  if (Chunks.empty())
+    return uncompress(InputBuffer, UncompressedBuffer, UncompressedSize);
+  Chunks.push_back(Data);
+
+  size_t NumChunks = Chunks.size();
+  std::vector<SmallVector<char, 0>> Outputs(NumChunks);
+  std::vector<uLong> Checksums(NumChunks);
+  std::vector<char> Inflated(NumChunks);
+  parallel::for_each_n(parallel::par, size_t(0), NumChunks, [&](size_t I) {
+    Inflated[I] = inflateChunk(Chunks[I], I == NumChunks - 1, Outputs[I]);
+    Checksums[I] = ::adler32(::adler32(0, Z_NULL, 0),
+                             (const Bytef *)Outputs[I].data(),
+                             Outputs[I].size());
+  });
+
+  std::vector<size_t> Offsets(NumChunks);
+  size_t Size = 0;
+  uLong Checksum = ::adler32(0, Z_NULL, 0);
+  for (size_t I = 0; I != NumChunks; ++I) {
+    if (!Inflated[I])
+      return uncompress(InputBuffer, UncompressedBuffer, UncompressedSize);
+    Offsets[I] = Size;
+    Size += Outputs[I].size();
+    Checksum = ::adler32_combine(Checksum, Checksums[I], Outputs[I].size());
+  }
+  if (Size > UncompressedSize ||
+      Checksum != support::endian::read32be(InputBuffer.end() - TrailerSize))
+    return uncompress(InputBuffer, UncompressedBuffer, UncompressedSize);
+
+  parallel::for_each_n(parallel::par, size_t(0), NumChunks, [&](size_t I) {
+    memcpy(UncompressedBuffer + Offsets[I], Outputs[I].data(),
+           Outputs[I].size());
+  });
+  UncompressedSize = Size;
+  return Error::success();
+}
+
 uint32_t zlib::crc32(StringRef Buffer) {
   return ::crc32(0, (const Bytef *)Buffer.data(), Buffer.size());
 }
@@ -114,6 +287,15 @@ Error zlib::uncompress(StringRef InputBuffer,
                        size_t UncompressedSize) {
   llvm_unreachable("zlib::uncompress is unavailable");
 }
+Error zlib::compressParallel(StringRef InputBuffer,
+                             SmallVectorImpl<char> &CompressedBuffer,
+                             CompressionLevel Level, size_t ChunkSize) {
+  llvm_unreachable("zlib::compressParallel is unavailable");
+}
+Error zlib::uncompressParallel(StringRef InputBuffer, char *UncompressedBuffer,
+                               size_t &UncompressedSize) {
+  llvm_unreachable("zlib::uncompressParallel is unavailable");
+}
 uint32_t zlib::crc32(StringRef Buffer) {
   llvm_unreachable("zlib::crc32 is unavailable");
 }
@@ -8,12 +8,16 @@
 //===----------------------------------------------------------------------===//
 
 #include "llvm/Support/Parallel.h"
+#include "llvm/ADT/STLExtras.h"
 #include "llvm/Config/llvm-config.h"
+#include "llvm/Support/Compiler.h"
 #include "llvm/Support/Threading.h"
 
 #include <atomic>
-#include <stack>
+#include <deque>
+#include <memory>
 #include <thread>
+#include <vector>
 
 using namespace llvm;
 
@@ -25,6 +29,21 @@ public:
   virtual ~Executor() = default;
   virtual void add(std::function<void()> func) = 0;
 
+  /// Run one queued task on the calling thread if it belongs to the executor
+  /// and there is work available. Returns false if nothing was run.
+  virtual bool runPendingTask() { return false; }
+
+  /// Returns true if the calling thread is one of the executor's workers.
+  virtual bool isWorkerThread() const { return false; }
+
+#if LLVM_ENABLE_THREADS
+  /// Block the calling worker until a task is queued or \p L is done.
+  virtual void waitForTask(const parallel::detail::Latch &L) {}
+
+  /// Wake the workers blocked in waitForTask() after a latch reached zero.
+  virtual void notifyLatchDone() {}
+#endif
+
   static Executor *getDefaultExecutor();
 };
 
@@ -68,18 +87,27 @@ Executor *Executor::getDefaultExecutor() {
 
 #else
 /// \brief An implementation of an Executor that runs closures on a thread pool
-///   in filo order.
+///   using per-thread work-stealing deques.
+///
+/// Each worker owns a deque. Tasks spawned by a worker are pushed onto and
+/// popped from the back of its own deque (filo, which keeps the working set of
+/// recursive algorithms such as parallel_quick_sort hot in cache), while idle
+/// workers steal from the front of other workers' deques. Tasks added from
+/// outside the pool are distributed round-robin.
 class ThreadPoolExecutor : public Executor {
 public:
   explicit ThreadPoolExecutor(unsigned ThreadCount = hardware_concurrency())
       : Done(ThreadCount) {
+    Queues.reserve(ThreadCount);
+    for (unsigned I = 0; I < ThreadCount; ++I)
+      Queues.push_back(llvm::make_unique<WorkQueue>());
     // Spawn all but one of the threads in another thread as spawning threads
     // can take a while.
     std::thread([&, ThreadCount] {
-      for (size_t i = 1; i < ThreadCount; ++i) {
-        std::thread([=] { work(); }).detach();
+      for (unsigned I = 1; I < ThreadCount; ++I) {
+        std::thread([=] { work(I); }).detach();
       }
-      work();
+      work(0);
     }).detach();
   }
 
@@ -92,37 +120,121 @@ public:
   }
 
   void add(std::function<void()> F) override {
-    std::unique_lock<std::mutex> Lock(Mutex);
-    WorkStack.push(F);
-    Lock.unlock();
+    unsigned Index = ThreadIndex >= 0
+                         ? ThreadIndex
+                         : NextQueue.fetch_add(1, std::memory_order_relaxed) %
+                               Queues.size();
+    {
+      std::lock_guard<std::mutex> Lock(Queues[Index]->Mutex);
+      Queues[Index]->Tasks.push_back(std::move(F));
+    }
+    {
+      // Pending is incremented under Mutex so that a worker that has just
+      // found every deque empty cannot miss this wakeup.
+      std::lock_guard<std::mutex> Lock(Mutex);
+      ++Pending;
+    }
     Cond.notify_one();
   }
 
+  bool isWorkerThread() const override { return ThreadIndex >= 0; }
+
+  bool runPendingTask() override {
+    if (ThreadIndex < 0)
+      return false;
+    std::function<void()> Task;
+    if (!takeTask(ThreadIndex, Task))
+      return false;
+    Task();
+    return true;
+  }
+
+  void waitForTask(const parallel::detail::Latch &L) override {
+    std::unique_lock<std::mutex> Lock(Mutex);
+    Cond.wait(Lock, [&] { return Stop || Pending != 0 || L.isDone(); });
+  }
+
+  void notifyLatchDone() override {
+    {
+      // As in add(), take Mutex so that a worker that has just found the latch
+      // still pending cannot miss this wakeup.
+      std::lock_guard<std::mutex> Lock(Mutex);
+    }
+    Cond.notify_all();
+  }
+
 private:
-  void work() {
+  struct WorkQueue {
+    std::mutex Mutex;
+    std::deque<std::function<void()>> Tasks;
+  };
+
+  /// Pop a task from the back of worker \p Index's own deque, or failing that
+  /// steal one from the front of another worker's deque.
+  bool takeTask(unsigned Index, std::function<void()> &Task) {
+    if (Pending.load(std::memory_order_acquire) == 0)
+      return false;
+    {
+      WorkQueue &Own = *Queues[Index];
+      std::lock_guard<std::mutex> Lock(Own.Mutex);
+      if (!Own.Tasks.empty()) {
+        Task = std::move(Own.Tasks.back());
+        Own.Tasks.pop_back();
+        --Pending;
+        return true;
+      }
+    }
+    for (unsigned I = 1, E = Queues.size(); I < E; ++I) {
+      WorkQueue &Victim = *Queues[(Index + I) % E];
+      std::lock_guard<std::mutex> Lock(Victim.Mutex);
+      if (!Victim.Tasks.empty()) {
+        Task = std::move(Victim.Tasks.front());
+        Victim.Tasks.pop_front();
+        --Pending;
+        return true;
+      }
+    }
+    return false;
+  }
+
+  void work(unsigned Index) {
+    ThreadIndex = Index;
     while (true) {
+      std::function<void()> Task;
+      if (takeTask(Index, Task)) {
+        Task();
+        continue;
+      }
       std::unique_lock<std::mutex> Lock(Mutex);
-      Cond.wait(Lock, [&] { return Stop || !WorkStack.empty(); });
+      Cond.wait(Lock, [&] { return Stop || Pending != 0; });
       if (Stop)
         break;
-      auto Task = WorkStack.top();
-      WorkStack.pop();
-      Lock.unlock();
-      Task();
     }
     Done.dec();
   }
 
+  /// Index of the worker running on the current thread, or -1 for threads
+  /// that do not belong to the pool.
+  static LLVM_THREAD_LOCAL int ThreadIndex;
+
   std::atomic<bool> Stop{false};
-  std::stack<std::function<void()>> WorkStack;
+  std::atomic<size_t> Pending{0};
+  std::atomic<unsigned> NextQueue{0};
+  std::vector<std::unique_ptr<WorkQueue>> Queues;
   std::mutex Mutex;
   std::condition_variable Cond;
   parallel::detail::Latch Done;
 };
 
+LLVM_THREAD_LOCAL int ThreadPoolExecutor::ThreadIndex = -1;
+
 Executor *Executor::getDefaultExecutor() {
-  static ThreadPoolExecutor exec;
-  return &exec;
+  // The pool lives until the process exits and is deliberately leaked. Its
+  // destructor waits for the workers to finish, which never happens in a
+  // child forked after the pool started (e.g. by a death test), since only
+  // the forking thread exists there.
+  static ThreadPoolExecutor *Exec = new ThreadPoolExecutor();
+  return Exec;
 }
 #endif
 }
@@ -130,9 +242,28 @@ Executor *Executor::getDefaultExecutor() {
 #if LLVM_ENABLE_THREADS
 void parallel::detail::TaskGroup::spawn(std::function<void()> F) {
   L.inc();
-  Executor::getDefaultExecutor()->add([&, F] {
+  Executor *Exec = Executor::getDefaultExecutor();
+  Exec->add([&, F, Exec] {
     F();
-    L.dec();
+    // The group may be destroyed as soon as its latch is done, so only the
+    // executor is used afterwards.
+    if (L.dec())
+      Exec->notifyLatchDone();
   });
 }
+
+void parallel::detail::TaskGroup::sync() const {
+  // A pool thread waiting on a nested group helps run queued tasks instead of
+  // blocking, so nested parallel algorithms neither idle a core nor deadlock
+  // once every worker is waiting. When there is nothing to run it sleeps until
+  // a task is queued or the group is done.
+  Executor *Exec = Executor::getDefaultExecutor();
+  if (!Exec->isWorkerThread()) {
+    L.sync();
+    return;
+  }
+  while (!L.isDone())
+    if (!Exec->runPendingTask())
+      Exec->waitForTask(L);
+}
 #endif
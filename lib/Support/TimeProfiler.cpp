@@ -0,0 +1,225 @@
+//===-- TimeProfiler.cpp - Hierarchical Time Profiler ---------------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+/// \file Hierarchical time profiler implementation.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/Support/TimeProfiler.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/Format.h"
+#include "llvm/Support/raw_ostream.h"
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <string>
+#include <vector>
+
+using namespace llvm;
+
+namespace llvm {
+
+LLVM_THREAD_LOCAL TimeTraceProfiler *TimeTraceProfilerInstance = nullptr;
+
+using ClockType = std::chrono::steady_clock;
+using TimePointType = std::chrono::time_point<ClockType>;
+using DurationType = std::chrono::duration<ClockType::rep, ClockType::period>;
+
+namespace {
+
+struct Entry {
+  TimePointType Start;
+  DurationType Duration;
+  std::string Name;
+  std::string Detail;
+
+  Entry(TimePointType Start, StringRef Name, StringRef Detail)
+      : Start(Start), Duration(0), Name(Name), Detail(Detail) {}
+};
+
+struct TotalEntry {
+  unsigned Count = 0;
+  DurationType Duration = DurationType(0);
+};
+
+} // end anonymous namespace
+
+struct TimeTraceProfiler {
+  /// The events that have begun but not ended yet, innermost last.
+  std::vector<Entry> Stack;
+  /// The events that have ended and were long enough to be kept.
+  std::vector<Entry> Entries;
+  /// The accumulated time of the outermost occurrences of each event name.
+  StringMap<TotalEntry> Totals;
+  TimePointType StartTime;
+  std::string ProcName;
+  DurationType Granularity;
+
+  TimeTraceProfiler(unsigned TimeTraceGranularity, StringRef ProcName)
+      : StartTime(ClockType::now()), ProcName(ProcName),
+        Granularity(std::chrono::duration_cast<DurationType>(
+            std::chrono::microseconds(TimeTraceGranularity))) {}
+
+  void begin(StringRef Name, StringRef Detail) {
+    Stack.emplace_back(ClockType::now(), Name, Detail);
+  }
+
+  void end() {
+    assert(!Stack.empty() && "Must call begin() first");
+    Entry &E = Stack.back();
+    E.Duration = ClockType::now() - E.Start;
+
+    // Only count the time of the outermost occurrence of a name, so that
+    // recursive events, like nested pass managers, are not counted twice.
+    if (std::none_of(Stack.begin(), Stack.end() - 1, [&](const Entry &Outer) {
+          return Outer.Name == E.Name;
+        })) {
+      TotalEntry &Total = Totals[E.Name];
+      ++Total.Count;
+      Total.Duration += E.Duration;
+    }
+
+    if (E.Duration >= Granularity)
+      Entries.push_back(std::move(E));
+    Stack.pop_back();
+  }
+
+  void write(raw_ostream &OS);
+};
+
+} // end namespace llvm
+
+/// Writes \p S as a JSON string.
+static void writeJSONString(raw_ostream &OS, StringRef S) {
+  OS << '"';
+  for (unsigned char C : S) {
+    switch (C) {
+    case '"':
+      OS << "\\\"";
+      break;
+    case '\\':
+      OS << "\\\\";
+      break;
+    case '\n':
+      OS << "\\n";
+      break;
+    case '\t':
+      OS << "\\t";
+      break;
+    default:
+      if (C < 0x20)
+        OS << format("\\u%04x", C);
+      else
+        OS << C;
+      break;
+    }
+  }
+  OS << '"';
+}
+
+static uint64_t toMicroseconds(DurationType D) {
+  return std::chrono::duration_cast<std::chrono::microseconds>(D).count();
+}
+
+static void writeEvent(raw_ostream &OS, uint64_t Start, uint64_t Duration,
+                       StringRef Name, StringRef Detail) {
+  OS << "{\"pid\":1,\"tid\":0,\"ph\":\"X\",\"ts\":" << Start
+     << ",\"dur\":" << Duration << ",\"name\":";
+  writeJSONString(OS, Name);
+  OS << ",\"args\":{\"detail\":";
+  writeJSONString(OS, Detail);
+  OS << "}},\n";
+}
+
+void TimeTraceProfiler::write(raw_ostream &OS) {
+  assert(Stack.empty() && "All events must have ended before writing");
+  OS << "{\"traceEvents\":[\n";
+
+  for (const Entry &E : Entries)
+    writeEvent(OS, toMicroseconds(E.Start - StartTime),
+               toMicroseconds(E.Duration), E.Name, E.Detail);
+
+  // Emit the totals on their own tracks, longest first, so that the trace
+  // viewer shows where the time went at a glance.
+  std::vector<std::pair<StringRef, TotalEntry>> SortedTotals;
+  for (const auto &Total : Totals)
+    SortedTotals.emplace_back(Total.getKey(), Total.getValue());
+  std::sort(SortedTotals.begin(), SortedTotals.end(),
+            [](const std::pair<StringRef, TotalEntry> &LHS,
+               const std::pair<StringRef, TotalEntry> &RHS) {
+              if (LHS.second.Duration != RHS.second.Duration)
+                return LHS.second.Duration > RHS.second.Duration;
+              return LHS.first < RHS.first;
+            });
+  unsigned Tid = 1;
+  for (const auto &Total : SortedTotals) {
+    uint64_t Duration = toMicroseconds(Total.second.Duration);
+    OS << "{\"pid\":1,\"tid\":" << Tid++ << ",\"ph\":\"X\",\"ts\":0,\"dur\":"
+       << Duration << ",\"name\":";
+    writeJSONString(OS, "Total " + Total.first.str());
+    OS << ",\"args\":{\"count\":" << Total.second.Count
+       << ",\"avg us\":" << Duration / Total.second.Count << "}},\n";
+  }
+
+  // The metadata event that names the process ends the array, so that no
+  // trailing comma is needed.
+  OS << "{\"pid\":1,\"tid\":0,\"ph\":\"M\",\"ts\":0,\"name\":\"process_name\","
+        "\"args\":{\"name\":";
+  writeJSONString(OS, ProcName);
+  OS << "}}\n]}\n";
+}
+
+void llvm::timeTraceProfilerInitialize(unsigned TimeTraceGranularity,
+                                       StringRef ProcName) {
+  assert(TimeTraceProfilerInstance == nullptr &&
+         "Profiler should not be initialized");
+  TimeTraceProfilerInstance =
+      new TimeTraceProfiler(TimeTraceGranularity, ProcName);
+}
+
+void llvm::timeTraceProfilerCleanup() {
+  delete TimeTraceProfilerInstance;
+  TimeTraceProfilerInstance = nullptr;
+}
+
+void llvm::timeTraceProfilerWrite(raw_ostream &OS) {
+  assert(TimeTraceProfilerInstance != nullptr &&
+         "Profiler object can't be null");
+  TimeTraceProfilerInstance->write(OS);
+}
+
+Error llvm::timeTraceProfilerWrite(StringRef PreferredFileName,
+                                   StringRef FallbackFileName) {
+  SmallString<128> Path(PreferredFileName);
+  if (Path.empty()) {
+    Path = FallbackFileName.empty() || FallbackFileName == "-"
+               ? StringRef("out")
+               : FallbackFileName;
+    Path += ".time-trace";
+  }
+
+  std::error_code EC;
+  raw_fd_ostream OS(Path, EC, sys::fs::F_Text);
+  if (EC)
+    return make_error<StringError>("Could not open " + Path.str(), EC);
+  timeTraceProfilerWrite(OS);
+  return Error::success();
+}
+
+void llvm::timeTraceProfilerBegin(StringRef Name, StringRef Detail) {
+  if (TimeTraceProfilerInstance != nullptr)
+    TimeTraceProfilerInstance->begin(Name, Detail);
+}
+
+void llvm::timeTraceProfilerEnd() {
+  if (TimeTraceProfilerInstance != nullptr)
+    TimeTraceProfilerInstance->end();
+}
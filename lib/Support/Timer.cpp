@@ -20,6 +20,7 @@
 #include "llvm/Support/ManagedStatic.h"
 #include "llvm/Support/Mutex.h"
 #include "llvm/Support/Process.h"
+#include "llvm/Support/TimeProfiler.h"
 #include "llvm/Support/YAMLTraits.h"
 #include "llvm/Support/raw_ostream.h"
 using namespace llvm;
@@ -212,7 +213,16 @@ NamedRegionTimer::NamedRegionTimer(StringRef Name, StringRef Description,
                                    StringRef GroupDescription, bool Enabled)
   : TimeRegion(!Enabled ? nullptr
                  : &NamedGroupedTimers->get(Name, Description, GroupName,
-                                            GroupDescription)) {}
+                                            GroupDescription)),
+    InTimeTrace(timeTraceProfilerEnabled()) {
+  if (InTimeTrace)
+    timeTraceProfilerBegin(Description, GroupDescription);
+}
+
+NamedRegionTimer::~NamedRegionTimer() {
+  if (InTimeTrace)
+    timeTraceProfilerEnd();
+}
 
 //===----------------------------------------------------------------------===//
 //   TimerGroup Implementation
@@ -39,6 +39,8 @@
 #include "llvm/Support/Casting.h"
 #include "llvm/Support/CommandLine.h"
 #include "llvm/Support/Debug.h"
+#include "llvm/Support/Endian.h"
+#include "llvm/Support/EndianStream.h"
 #include "llvm/Support/Error.h"
 #include "llvm/Support/ErrorHandling.h"
 #include "llvm/Support/FileSystem.h"
@@ -48,6 +50,7 @@
 #include "llvm/Transforms/Utils/Cloning.h"
 #include "llvm/Transforms/Utils/FunctionImportUtils.h"
 #include "llvm/Transforms/Utils/ValueMapper.h"
+#include <algorithm>
 #include <cassert>
 #include <memory>
 #include <set>
@@ -64,6 +67,8 @@ STATISTIC(NumImportedFunctions, "Number of functions imported");
 STATISTIC(NumImportedModules, "Number of modules imported from");
 STATISTIC(NumDeadSymbols, "Number of dead stripped symbols in index");
 STATISTIC(NumLiveSymbols, "Number of live symbols in index");
+STATISTIC(NumImportListsReused,
+          "Number of import lists reused from a previous link");
 
 /// Limit on instruction count of imported functions.
 static cl::opt<unsigned> ImportInstrLimit(
@@ -237,21 +242,27 @@ updateValueInfoForIndirectCalls(const ModuleSummaryIndex &Index, ValueInfo VI) {
 
 /// Compute the list of functions to import for a given caller. Mark these
 /// imported functions and the symbols they reference in their source module as
-/// exported from their source module.
+/// exported from their source module. If \p Examined is not null, record the
+/// GUIDs of the callees whose summaries were looked at.
 static void computeImportForFunction(
     const FunctionSummary &Summary, const ModuleSummaryIndex &Index,
     const unsigned Threshold, const GVSummaryMapTy &DefinedGVSummaries,
     SmallVectorImpl<EdgeInfo> &Worklist,
     FunctionImporter::ImportMapTy &ImportList,
-    StringMap<FunctionImporter::ExportSetTy> *ExportLists = nullptr) {
+    StringMap<FunctionImporter::ExportSetTy> *ExportLists = nullptr,
+    DenseSet<GlobalValue::GUID> *Examined = nullptr) {
   for (auto &Edge : Summary.calls()) {
     ValueInfo VI = Edge.first;
     DEBUG(dbgs() << " edge -> " << VI.getGUID() << " Threshold:" << Threshold
                  << "\n");
+    if (Examined)
+      Examined->insert(VI.getGUID());
 
     VI = updateValueInfoForIndirectCalls(Index, VI);
     if (!VI)
       continue;
+    if (Examined)
+      Examined->insert(VI.getGUID());
 
     if (DefinedGVSummaries.count(VI.getGUID())) {
       DEBUG(dbgs() << "ignored! Target already in destination module.\n");
@@ -343,7 +354,8 @@ static void computeImportForFunction(
 static void ComputeImportForModule(
     const GVSummaryMapTy &DefinedGVSummaries, const ModuleSummaryIndex &Index,
     FunctionImporter::ImportMapTy &ImportList,
-    StringMap<FunctionImporter::ExportSetTy> *ExportLists = nullptr) {
+    StringMap<FunctionImporter::ExportSetTy> *ExportLists = nullptr,
+    DenseSet<GlobalValue::GUID> *Examined = nullptr) {
   // Worklist contains the list of function imported in this module, for which
   // we will analyse the callees and may import further down the callgraph.
   SmallVector<EdgeInfo, 128> Worklist;
@@ -363,7 +375,7 @@ static void ComputeImportForModule(
     DEBUG(dbgs() << "Initialize import for " << GVSummary.first << "\n");
     computeImportForFunction(*FuncSummary, Index, ImportInstrLimit,
                              DefinedGVSummaries, Worklist, ImportList,
-                             ExportLists);
+                             ExportLists, Examined);
   }
 
   // Process the newly imported functions and add callees to the worklist.
@@ -381,7 +393,27 @@ static void ComputeImportForModule(
       continue;
 
     computeImportForFunction(*Summary, Index, Threshold, DefinedGVSummaries,
-                             Worklist, ImportList, ExportLists);
+                             Worklist, ImportList, ExportLists, Examined);
+  }
+}
+
+/// When computing imports we add all GUIDs referenced by anything imported
+/// from a module to its ExportList. Prune each ExportList of any not defined
+/// in that module. This is more efficient than checking while computing
+/// imports because some of the summary lists may be long due to linkonce
+/// (comdat) copies.
+static void
+pruneExportLists(const StringMap<GVSummaryMapTy> &ModuleToDefinedGVSummaries,
+                 StringMap<FunctionImporter::ExportSetTy> &ExportLists) {
+  for (auto &ELI : ExportLists) {
+    const auto &DefinedGVSummaries =
+        ModuleToDefinedGVSummaries.lookup(ELI.first());
+    for (auto EI = ELI.second.begin(); EI != ELI.second.end();) {
+      if (!DefinedGVSummaries.count(*EI))
+        EI = ELI.second.erase(EI);
+      else
+        ++EI;
+    }
   }
 }
 
@@ -400,21 +432,7 @@ void llvm::ComputeCrossModuleImport(
                            &ExportLists);
   }
 
-  // When computing imports we added all GUIDs referenced by anything
-  // imported from the module to its ExportList. Now we prune each ExportList
-  // of any not defined in that module. This is more efficient than checking
-  // while computing imports because some of the summary lists may be long
-  // due to linkonce (comdat) copies.
-  for (auto &ELI : ExportLists) {
-    const auto &DefinedGVSummaries =
-        ModuleToDefinedGVSummaries.lookup(ELI.first());
-    for (auto EI = ELI.second.begin(); EI != ELI.second.end();) {
-      if (!DefinedGVSummaries.count(*EI))
-        EI = ELI.second.erase(EI);
-      else
-        ++EI;
-    }
-  }
+  pruneExportLists(ModuleToDefinedGVSummaries, ExportLists);
 
 #ifndef NDEBUG
   DEBUG(dbgs() << "Import/Export lists for " << ImportLists.size()
@@ -434,6 +452,270 @@ void llvm::ComputeCrossModuleImport(
 #endif
 }
 
+// Returns the values of the options that affect import decisions, so that
+// import lists computed with other values are not reused.
+static std::string getImportOptionsKey() {
+  std::string Key;
+  raw_string_ostream OS(Key);
+  OS << unsigned(ImportInstrLimit) << ' ' << double(ImportInstrFactor) << ' '
+     << double(ImportHotInstrFactor) << ' ' << double(ImportHotMultiplier)
+     << ' ' << double(ImportCriticalMultiplier) << ' '
+     << double(ImportColdMultiplier);
+  return OS.str();
+}
+
+unsigned llvm::ComputeCrossModuleImportIncrementally(
+    const ModuleSummaryIndex &Index,
+    const StringMap<GVSummaryMapTy> &ModuleToDefinedGVSummaries,
+    StringMap<FunctionImporter::ImportMapTy> &ImportLists,
+    StringMap<FunctionImporter::ExportSetTy> &ExportLists,
+    const CrossModuleImportState *PrevState, CrossModuleImportState &NewState) {
+  NewState.OptionsKey = getImportOptionsKey();
+  if (PrevState && PrevState->OptionsKey != NewState.OptionsKey)
+    PrevState = nullptr;
+
+  auto getPrevModuleState = [&](StringRef ModulePath)
+      -> const CrossModuleImportState::ModuleState * {
+    if (!PrevState)
+      return nullptr;
+    auto It = PrevState->Modules.find(ModulePath);
+    return It == PrevState->Modules.end() ? nullptr : &It->second;
+  };
+  // A module without a hash is never considered unchanged.
+  auto isUnchanged = [](const CrossModuleImportState::ModuleState *Prev,
+                        const CrossModuleImportState::ModuleState &MS) {
+    return Prev && Prev->Hash == MS.Hash && MS.Hash != ModuleHash{{0}};
+  };
+
+  // Record what each module defines, and collect the values that modules
+  // whose contents changed define now or defined in the previous link. The
+  // imports of the other modules can only be affected by those values, if
+  // they examined them. Values whose original name maps to a local through
+  // the SamplePGO original-name table are not tracked; a reused import of such
+  // a value stays valid, but may differ from what a full computation picks.
+  DenseSet<GlobalValue::GUID> ChangedValues;
+  std::vector<std::pair<uint64_t, uint64_t>> UnchangedModuleIds;
+  for (auto &DefinedGVSummaries : ModuleToDefinedGVSummaries) {
+    StringRef ModulePath = DefinedGVSummaries.first();
+    auto &MS = NewState.Modules[ModulePath];
+    auto PathIt = Index.modulePaths().find(ModulePath);
+    MS.Hash = ModuleHash{{0}};
+    MS.ModuleId = 0;
+    if (PathIt != Index.modulePaths().end()) {
+      MS.ModuleId = PathIt->second.first;
+      MS.Hash = PathIt->second.second;
+    }
+    for (auto &GVSummary : DefinedGVSummaries.second) {
+      MS.Defined.push_back(GVSummary.first);
+      if (!Index.isGlobalValueLive(GVSummary.second))
+        MS.Dead.push_back(GVSummary.first);
+    }
+    std::sort(MS.Defined.begin(), MS.Defined.end());
+    std::sort(MS.Dead.begin(), MS.Dead.end());
+
+    auto *Prev = getPrevModuleState(ModulePath);
+    if (isUnchanged(Prev, MS)) {
+      UnchangedModuleIds.push_back({MS.ModuleId, Prev->ModuleId});
+      continue;
+    }
+    ChangedValues.insert(MS.Defined.begin(), MS.Defined.end());
+    if (Prev)
+      ChangedValues.insert(Prev->Defined.begin(), Prev->Defined.end());
+  }
+  if (PrevState)
+    for (auto &Prev : PrevState->Modules)
+      if (!ModuleToDefinedGVSummaries.count(Prev.first()))
+        ChangedValues.insert(Prev.second.Defined.begin(),
+                             Prev.second.Defined.end());
+
+  // The summary lists are in link order, and callees are selected from them
+  // in order. If the unchanged modules were reordered, any value defined in
+  // several modules may now resolve differently.
+  std::sort(UnchangedModuleIds.begin(), UnchangedModuleIds.end());
+  if (!std::is_sorted(UnchangedModuleIds.begin(), UnchangedModuleIds.end(),
+                      [](const std::pair<uint64_t, uint64_t> &A,
+                         const std::pair<uint64_t, uint64_t> &B) {
+                        return A.second < B.second;
+                      }))
+    for (auto &GlobalList : Index)
+      if (GlobalList.second.SummaryList.size() > 1)
+        ChangedValues.insert(GlobalList.first);
+
+  unsigned NumRecomputed = 0;
+  for (auto &DefinedGVSummaries : ModuleToDefinedGVSummaries) {
+    StringRef ModulePath = DefinedGVSummaries.first();
+    auto &MS = NewState.Modules[ModulePath];
+    auto &ImportList = ImportLists[ModulePath];
+
+    auto *Prev = getPrevModuleState(ModulePath);
+    if (isUnchanged(Prev, MS) && Prev->Dead == MS.Dead &&
+        llvm::none_of(Prev->Examined, [&](GlobalValue::GUID GUID) {
+          return ChangedValues.count(GUID);
+        })) {
+      DEBUG(dbgs() << "Reusing import for Module '" << ModulePath << "'\n");
+      ++NumImportListsReused;
+      ImportList = Prev->ImportList;
+      MS.Examined = Prev->Examined;
+      MS.ImportList = Prev->ImportList;
+      continue;
+    }
+
+    DEBUG(dbgs() << "Computing import for Module '" << ModulePath << "'\n");
+    ++NumRecomputed;
+    DenseSet<GlobalValue::GUID> Examined;
+    ComputeImportForModule(DefinedGVSummaries.second, Index, ImportList,
+                           /*ExportLists=*/nullptr, &Examined);
+    MS.Examined.assign(Examined.begin(), Examined.end());
+    std::sort(MS.Examined.begin(), MS.Examined.end());
+    MS.ImportList = ImportList;
+  }
+
+  // Derive the export lists from the import lists, the same way
+  // computeImportForFunction does.
+  for (auto &ModuleImports : ImportLists) {
+    for (auto &Src : ModuleImports.second) {
+      auto &ExportList = ExportLists[Src.first()];
+      for (auto &Import : Src.second) {
+        ExportList.insert(Import.first);
+        auto *Summary = Index.findSummaryInModule(Import.first, Src.first());
+        if (!Summary)
+          continue;
+        auto *FS = cast<FunctionSummary>(Summary->getBaseObject());
+        for (auto &Edge : FS->calls())
+          ExportList.insert(Edge.first.getGUID());
+        for (auto &Ref : FS->refs())
+          ExportList.insert(Ref.getGUID());
+      }
+    }
+  }
+  pruneExportLists(ModuleToDefinedGVSummaries, ExportLists);
+  return NumRecomputed;
+}
+
+static const char ImportStateMagic[] = "LLVMImportState";
+static const uint32_t ImportStateVersion = 1;
+
+void CrossModuleImportState::write(raw_ostream &OS) const {
+  support::endian::Writer<support::little> W(OS);
+  auto writeString = [&](StringRef Str) {
+    W.write<uint32_t>(Str.size());
+    OS << Str;
+  };
+  auto writeGUIDs = [&](ArrayRef<GlobalValue::GUID> GUIDs) {
+    W.write<uint32_t>(GUIDs.size());
+    for (GlobalValue::GUID GUID : GUIDs)
+      W.write<uint64_t>(GUID);
+  };
+
+  OS << ImportStateMagic;
+  W.write<uint32_t>(ImportStateVersion);
+  writeString(OptionsKey);
+  W.write<uint32_t>(Modules.size());
+  for (auto &M : Modules) {
+    writeString(M.first());
+    for (uint32_t Word : M.second.Hash)
+      W.write<uint32_t>(Word);
+    W.write<uint64_t>(M.second.ModuleId);
+    writeGUIDs(M.second.Defined);
+    writeGUIDs(M.second.Dead);
+    writeGUIDs(M.second.Examined);
+    W.write<uint32_t>(M.second.ImportList.size());
+    for (auto &Src : M.second.ImportList) {
+      writeString(Src.first());
+      W.write<uint32_t>(Src.second.size());
+      for (auto &Import : Src.second) {
+        W.write<uint64_t>(Import.first);
+        W.write<uint32_t>(Import.second);
+      }
+    }
+  }
+}
+
+namespace {
+/// Reads the fields written by CrossModuleImportState::write, remembering
+/// whether it ran past the end of the buffer.
+class ImportStateReader {
+  StringRef Data;
+  bool Malformed = false;
+
+public:
+  ImportStateReader(StringRef Data) : Data(Data) {}
+
+  bool isMalformed() const { return Malformed; }
+
+  StringRef readBytes(size_t Size) {
+    if (Data.size() < Size) {
+      Malformed = true;
+      Data = StringRef();
+      return StringRef();
+    }
+    StringRef Bytes = Data.take_front(Size);
+    Data = Data.drop_front(Size);
+    return Bytes;
+  }
+
+  template <typename T> T read() {
+    StringRef Bytes = readBytes(sizeof(T));
+    if (Malformed)
+      return 0;
+    return support::endian::read<T, support::little, support::unaligned>(
+        Bytes.data());
+  }
+
+  StringRef readString() { return readBytes(read<uint32_t>()); }
+
+  void readGUIDs(std::vector<GlobalValue::GUID> &GUIDs) {
+    uint32_t Size = read<uint32_t>();
+    if (Data.size() / sizeof(uint64_t) < Size) {
+      Malformed = true;
+      return;
+    }
+    GUIDs.reserve(Size);
+    for (uint32_t I = 0; I != Size; ++I)
+      GUIDs.push_back(read<uint64_t>());
+  }
+};
+} // end anonymous namespace
+
+Expected<CrossModuleImportState>
+CrossModuleImportState::read(MemoryBufferRef Buffer) {
+  auto malformed = [&]() {
+    return make_error<StringError>("malformed import state " +
+                                       Buffer.getBufferIdentifier(),
+                                   inconvertibleErrorCode());
+  };
+
+  ImportStateReader R(Buffer.getBuffer());
+  if (R.readBytes(sizeof(ImportStateMagic) - 1) != ImportStateMagic ||
+      R.read<uint32_t>() != ImportStateVersion)
+    return malformed();
+
+  CrossModuleImportState State;
+  State.OptionsKey = R.readString();
+  uint32_t NumModules = R.read<uint32_t>();
+  for (uint32_t I = 0; I != NumModules && !R.isMalformed(); ++I) {
+    auto &MS = State.Modules[R.readString()];
+    for (uint32_t &Word : MS.Hash)
+      Word = R.read<uint32_t>();
+    MS.ModuleId = R.read<uint64_t>();
+    R.readGUIDs(MS.Defined);
+    R.readGUIDs(MS.Dead);
+    R.readGUIDs(MS.Examined);
+    uint32_t NumSrcs = R.read<uint32_t>();
+    for (uint32_t J = 0; J != NumSrcs && !R.isMalformed(); ++J) {
+      auto &Imports = MS.ImportList[R.readString()];
+      uint32_t NumImports = R.read<uint32_t>();
+      for (uint32_t K = 0; K != NumImports && !R.isMalformed(); ++K) {
+        GlobalValue::GUID GUID = R.read<uint64_t>();
+        Imports[GUID] = R.read<uint32_t>();
+      }
+    }
+  }
+  if (R.isMalformed())
+    return malformed();
+  return State;
+}
+
 #ifndef NDEBUG
 static void dumpImportListForModule(StringRef ModulePath,
                                     FunctionImporter::ImportMapTy &ImportList) {
@@ -640,9 +640,11 @@ SampleProfileLoader::findCalleeFunctionSamples(const Instruction &Inst) const {
   }
 
   StringRef CalleeName;
+  std::string GUIDBuf;
   if (const CallInst *CI = dyn_cast<CallInst>(&Inst))
     if (Function *Callee = CI->getCalledFunction())
-      CalleeName = Callee->getName();
+      CalleeName =
+          getRepInFormat(Callee->getName(), Reader->getFormat(), GUIDBuf);
 
   const FunctionSamples *FS = findFunctionSamples(Inst);
   if (FS == nullptr)
@@ -816,7 +818,9 @@ bool SampleProfileLoader::inlineHotFunctions(
           // clone the caller first, and inline the cloned caller if it is
           // recursive. As llvm does not inline recursive calls, we will
           // simply ignore it instead of handling it explicitly.
-          if (CalleeFunctionName == F.getName())
+          std::string GUIDBuf;
+          if (CalleeFunctionName ==
+              getRepInFormat(F.getName(), Reader->getFormat(), GUIDBuf))
             continue;
 
           const char *Reason = "Callee function not available";
@@ -1188,7 +1192,7 @@ static SmallVector<InstrProfValueData, 2> SortCallTargets(
     const SampleRecord::CallTargetMap &M) {
   SmallVector<InstrProfValueData, 2> R;
   for (auto I = M.begin(); I != M.end(); ++I)
-    R.push_back({Function::getGUID(I->getKey()), I->getValue()});
+    R.push_back({FunctionSamples::getGUID(I->getKey()), I->getValue()});
   std::sort(R.begin(), R.end(),
             [](const InstrProfValueData &L, const InstrProfValueData &R) {
               if (L.Count == R.Count)
@@ -1525,6 +1529,7 @@ bool SampleProfileLoader::doInitialization(Module &M) {
     return false;
   }
   Reader = std::move(ReaderOrErr.get());
+  Reader->collectFuncsToUse(M);
   ProfileIsValid = (Reader->read() == sampleprof_error::success);
   return true;
 }
@@ -1545,17 +1550,20 @@ bool SampleProfileLoader::runOnModule(Module &M, ModuleAnalysisManager *AM) {
   for (const auto &I : Reader->getProfiles())
     TotalCollectedSamples += I.second.getTotalSamples();
 
-  // Populate the symbol map.
+  // Populate the symbol map. It is keyed by the names as they appear in the
+  // profile, which are MD5 hashes in the compact binary format.
+  std::string GUIDBuf;
   for (const auto &N_F : M.getValueSymbolTable()) {
     std::string OrigName = N_F.getKey();
     Function *F = dyn_cast<Function>(N_F.getValue());
     if (F == nullptr)
       continue;
-    SymbolMap[OrigName] = F;
+    SymbolMap[getRepInFormat(OrigName, Reader->getFormat(), GUIDBuf)] = F;
     auto pos = OrigName.find('.');
     if (pos != std::string::npos) {
       std::string NewName = OrigName.substr(0, pos);
-      auto r = SymbolMap.insert(std::make_pair(NewName, F));
+      auto r = SymbolMap.insert(std::make_pair(
+          getRepInFormat(NewName, Reader->getFormat(), GUIDBuf), F));
       // Failiing to insert means there is already an entry in SymbolMap,
       // thus there are multiple functions that are mapped to the same
       // stripped name. In this case of name conflicting, set the value
@@ -916,9 +916,13 @@ private:
   // Total size of the profile count for this function.
   uint32_t ProfileCountSize = 0;
 
-  // ProfileRecord for this function.
+  // ProfileRecord for this function. Its value profile data is only decoded
+  // from ProfileRecordRef when there are value sites to annotate.
   InstrProfRecord ProfileRecord;
 
+  // The profile record of this function in the profile data.
+  InstrProfRecordRef ProfileRecordRef;
+
   // Function hotness info derived from profile.
   FuncFreqAttr FreqAttr;
 
@@ -1009,8 +1013,8 @@ void PGOUseFunc::setEdgeCount(DirectEdges &Edges, uint64_t Value) {
 // Return true if the profile are successfully read, and false on errors.
 bool PGOUseFunc::readCounters(IndexedInstrProfReader *PGOReader) {
   auto &Ctx = M->getContext();
-  Expected<InstrProfRecord> Result =
-      PGOReader->getInstrProfRecord(FuncInfo.FuncName, FuncInfo.FunctionHash);
+  Expected<InstrProfRecordRef> Result = PGOReader->getInstrProfRecordRef(
+      FuncInfo.FuncName, FuncInfo.FunctionHash);
   if (Error E = Result.takeError()) {
     handleAllErrors(std::move(E), [&](const InstrProfError &IPE) {
       auto Err = IPE.get();
@@ -1037,7 +1041,10 @@ bool PGOUseFunc::readCounters(IndexedInstrProfReader *PGOReader) {
     });
     return false;
   }
-  ProfileRecord = std::move(Result.get());
+  ProfileRecordRef = Result.get();
+  ArrayRef<support::ulittle64_t> Counts = ProfileRecordRef.getCounts();
+  ProfileRecord = InstrProfRecord(std::vector<uint64_t>(Counts.begin(),
+                                                        Counts.end()));
   std::vector<uint64_t> &CountFromProfile = ProfileRecord.Counts;
 
   NumOfPGOFunc++;
@@ -1313,6 +1320,24 @@ void PGOUseFunc::annotateValueSites() {
   // Create the PGOFuncName meta data.
   createPGOFuncNameMetadata(F, FuncInfo.FuncName);
 
+  // Decoding the value profile data is only worth it if some value sites are
+  // annotated.
+  bool HasValueSites = false;
+  for (uint32_t Kind = IPVK_First; Kind <= IPVK_Last; ++Kind)
+    HasValueSites |= !FuncInfo.ValueSites[Kind].empty() &&
+                     ProfileRecordRef.getNumValueSites(Kind) ==
+                         FuncInfo.ValueSites[Kind].size();
+  if (HasValueSites) {
+    if (Error E = ProfileRecordRef.readValueProfData(ProfileRecord)) {
+      handleAllErrors(std::move(E), [&](const InstrProfError &IPE) {
+        M->getContext().diagnose(DiagnosticInfoPGOProfile(
+            M->getName().data(), IPE.message() + " " + F.getName().str(),
+            DS_Warning));
+      });
+      return;
+    }
+  }
+
   for (uint32_t Kind = IPVK_First; Kind <= IPVK_Last; ++Kind)
     annotateValueSites(Kind);
 }
@@ -1321,7 +1346,7 @@ void PGOUseFunc::annotateValueSites() {
 void PGOUseFunc::annotateValueSites(uint32_t Kind) {
   unsigned ValueSiteIndex = 0;
   auto &ValueSites = FuncInfo.ValueSites[Kind];
-  unsigned NumValueSites = ProfileRecord.getNumValueSites(Kind);
+  unsigned NumValueSites = ProfileRecordRef.getNumValueSites(Kind);
   if (NumValueSites != ValueSites.size()) {
     auto &Ctx = M->getContext();
     Ctx.diagnose(DiagnosticInfoPGOProfile(
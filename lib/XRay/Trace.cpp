@@ -55,88 +55,113 @@ Error readBinaryFormatHeader(StringRef Data, XRayFileHeader &FileHeader) {
   return Error::success();
 }
 
-Error loadNaiveFormatLog(StringRef Data, XRayFileHeader &FileHeader,
-                         std::vector<XRayRecord> &Records) {
-  if (Data.size() < 32)
-    return make_error<StringError>(
-        "Not enough bytes for an XRay log.",
-        std::make_error_code(std::errc::invalid_argument));
+/// Reads a log in the naive (basic mode) format, where each record after the
+/// header is 32 bytes, in the following format:
+///
+///   (2)   uint16 : record type
+///   (1)   uint8  : cpu id
+///   (1)   uint8  : type
+///   (4)   sint32 : function id
+///   (8)   uint64 : tsc
+///   (4)   uint32 : thread id
+///   (12)  -      : padding
+///
+/// Function records may be followed by arg payload records carrying the
+/// arguments of the function record right before them.
+class NaiveTraceReader : public TraceReader {
+  StringRef Remaining;
+
+public:
+  Error init(StringRef Data) {
+    if (Data.size() < 32)
+      return make_error<StringError>(
+          "Not enough bytes for an XRay log.",
+          std::make_error_code(std::errc::invalid_argument));
 
-  if (Data.size() - 32 == 0 || Data.size() % 32 != 0)
-    return make_error<StringError>(
-        "Invalid-sized XRay data.",
-        std::make_error_code(std::errc::invalid_argument));
+    if (Data.size() - 32 == 0 || Data.size() % 32 != 0)
+      return make_error<StringError>(
+          "Invalid-sized XRay data.",
+          std::make_error_code(std::errc::invalid_argument));
 
-  if (auto E = readBinaryFormatHeader(Data, FileHeader))
-    return E;
+    if (auto E = readBinaryFormatHeader(Data, FileHeader))
+      return E;
+    Remaining = Data.drop_front(32);
+    return Error::success();
+  }
 
-  // Each record after the header will be 32 bytes, in the following format:
-  //
-  //   (2)   uint16 : record type
-  //   (1)   uint8  : cpu id
-  //   (1)   uint8  : type
-  //   (4)   sint32 : function id
-  //   (8)   uint64 : tsc
-  //   (4)   uint32 : thread id
-  //   (12)  -      : padding
-  for (auto S = Data.drop_front(32); !S.empty(); S = S.drop_front(32)) {
-    DataExtractor RecordExtractor(S, true, 8);
-    uint32_t OffsetPtr = 0;
-    switch (auto RecordType = RecordExtractor.getU16(&OffsetPtr)) {
-    case 0: { // Normal records.
-      Records.emplace_back();
-      auto &Record = Records.back();
-      Record.RecordType = RecordType;
-      Record.CPU = RecordExtractor.getU8(&OffsetPtr);
-      auto Type = RecordExtractor.getU8(&OffsetPtr);
-      switch (Type) {
-      case 0:
-        Record.Type = RecordTypes::ENTER;
-        break;
-      case 1:
-        Record.Type = RecordTypes::EXIT;
-        break;
-      case 2:
-        Record.Type = RecordTypes::TAIL_EXIT;
-        break;
-      case 3:
-        Record.Type = RecordTypes::ENTER_ARG;
-        break;
-      default:
-        return make_error<StringError>(
-            Twine("Unknown record type '") + Twine(int{Type}) + "'",
-            std::make_error_code(std::errc::executable_format_error));
-      }
-      Record.FuncId = RecordExtractor.getSigned(&OffsetPtr, sizeof(int32_t));
-      Record.TSC = RecordExtractor.getU64(&OffsetPtr);
-      Record.TId = RecordExtractor.getU32(&OffsetPtr);
-      break;
-    }
-    case 1: { // Arg payload record.
-      auto &Record = Records.back();
-      // Advance two bytes to avoid padding.
-      OffsetPtr += 2;
-      int32_t FuncId = RecordExtractor.getSigned(&OffsetPtr, sizeof(int32_t));
-      auto TId = RecordExtractor.getU32(&OffsetPtr);
-      if (Record.FuncId != FuncId || Record.TId != TId)
-        return make_error<StringError>(
-            Twine("Corrupted log, found payload following non-matching "
-                  "function + thread record. Record for ") +
-                Twine(Record.FuncId) + " != " + Twine(FuncId),
-            std::make_error_code(std::errc::executable_format_error));
-      // Advance another four bytes to avoid padding.
-      OffsetPtr += 4;
-      auto Arg = RecordExtractor.getU64(&OffsetPtr);
-      Record.CallArgs.push_back(Arg);
+  Expected<bool> readNextRecord(XRayRecord &Record) override;
+};
+
+Expected<bool> NaiveTraceReader::readNextRecord(XRayRecord &Record) {
+  if (Remaining.empty())
+    return false;
+
+  DataExtractor RecordExtractor(Remaining, true, 8);
+  uint32_t OffsetPtr = 0;
+  auto RecordType = RecordExtractor.getU16(&OffsetPtr);
+  switch (RecordType) {
+  case 0: // Normal records.
+    break;
+  case 1: // Arg payload record.
+    return make_error<StringError>(
+        "Corrupted log, found payload without a preceding function record.",
+        std::make_error_code(std::errc::executable_format_error));
+  default:
+    return make_error<StringError>(
+        Twine("Unknown record type == ") + Twine(RecordType),
+        std::make_error_code(std::errc::executable_format_error));
+  }
+
+  Record.RecordType = RecordType;
+  Record.CPU = RecordExtractor.getU8(&OffsetPtr);
+  auto Type = RecordExtractor.getU8(&OffsetPtr);
+  switch (Type) {
+  case 0:
+    Record.Type = RecordTypes::ENTER;
+    break;
+  case 1:
+    Record.Type = RecordTypes::EXIT;
+    break;
+  case 2:
+    Record.Type = RecordTypes::TAIL_EXIT;
+    break;
+  case 3:
+    Record.Type = RecordTypes::ENTER_ARG;
+    break;
+  default:
+    return make_error<StringError>(
+        Twine("Unknown record type '") + Twine(int{Type}) + "'",
+        std::make_error_code(std::errc::executable_format_error));
+  }
+  Record.FuncId = RecordExtractor.getSigned(&OffsetPtr, sizeof(int32_t));
+  Record.TSC = RecordExtractor.getU64(&OffsetPtr);
+  Record.TId = RecordExtractor.getU32(&OffsetPtr);
+  Record.CallArgs.clear();
+  Remaining = Remaining.drop_front(32);
+
+  // Fold the arg payload records that follow into this record before handing
+  // it out.
+  for (; !Remaining.empty(); Remaining = Remaining.drop_front(32)) {
+    DataExtractor PayloadExtractor(Remaining, true, 8);
+    OffsetPtr = 0;
+    if (PayloadExtractor.getU16(&OffsetPtr) != 1)
       break;
-    }
-    default:
+    // Advance two bytes to avoid padding.
+    OffsetPtr += 2;
+    int32_t FuncId = PayloadExtractor.getSigned(&OffsetPtr, sizeof(int32_t));
+    auto TId = PayloadExtractor.getU32(&OffsetPtr);
+    if (Record.FuncId != FuncId || Record.TId != TId)
       return make_error<StringError>(
-          Twine("Unknown record type == ") + Twine(RecordType),
+          Twine("Corrupted log, found payload following non-matching "
+                "function + thread record. Record for ") +
+              Twine(Record.FuncId) + " != " + Twine(FuncId),
           std::make_error_code(std::errc::executable_format_error));
-    }
+    // Advance another four bytes to avoid padding.
+    OffsetPtr += 4;
+    auto Arg = PayloadExtractor.getU64(&OffsetPtr);
+    Record.CallArgs.push_back(Arg);
   }
-  return Error::success();
+  return true;
 }
 
 /// When reading from a Flight Data Recorder mode log, metadata records are
@@ -302,16 +327,15 @@ Error processBufferExtents(FDRState &State, uint8_t RecordFirstByte,
 /// State transition when a CallArgumentRecord is encountered.
 Error processFDRCallArgumentRecord(FDRState &State, uint8_t RecordFirstByte,
                                    DataExtractor &RecordExtractor,
-                                   std::vector<XRayRecord> &Records) {
+                                   XRayRecord *Enter) {
   uint32_t OffsetPtr = 1; // Read starting after the first byte.
-  auto &Enter = Records.back();
 
-  if (Enter.Type != RecordTypes::ENTER)
+  if (!Enter || Enter->Type != RecordTypes::ENTER)
     return make_error<StringError>(
         "CallArgument needs to be right after a function entry",
         std::make_error_code(std::errc::executable_format_error));
-  Enter.Type = RecordTypes::ENTER_ARG;
-  Enter.CallArgs.emplace_back(RecordExtractor.getU64(&OffsetPtr));
+  Enter->Type = RecordTypes::ENTER_ARG;
+  Enter->CallArgs.emplace_back(RecordExtractor.getU64(&OffsetPtr));
   return Error::success();
 }
 
@@ -324,10 +348,12 @@ Error processFDRCallArgumentRecord(FDRState &State, uint8_t RecordFirstByte,
 /// Beginning with Version 2 of the FDR log, we do not depend on the size of the
 /// buffer, but rather use the extents to determine how far to read in the log
 /// for this particular buffer.
+///
+/// CallArgument records are attached to \p LastRecord, the function record
+/// read right before them, if any.
 Error processFDRMetadataRecord(FDRState &State, uint8_t RecordFirstByte,
                                DataExtractor &RecordExtractor,
-                               size_t &RecordSize,
-                               std::vector<XRayRecord> &Records,
+                               size_t &RecordSize, XRayRecord *LastRecord,
                                uint16_t Version) {
   // The remaining 7 bits are the RecordKind enum.
   uint8_t RecordKind = RecordFirstByte >> 1;
@@ -368,7 +394,7 @@ Error processFDRMetadataRecord(FDRState &State, uint8_t RecordFirstByte,
     break;
   case 6: // CallArgument
     if (auto E = processFDRCallArgumentRecord(State, RecordFirstByte,
-                                              RecordExtractor, Records))
+                                              RecordExtractor, LastRecord))
       return E;
     break;
   case 7: // BufferExtents
@@ -385,16 +411,15 @@ Error processFDRMetadataRecord(FDRState &State, uint8_t RecordFirstByte,
   return Error::success();
 }
 
-/// Reads a function record from an FDR format log, appending a new XRayRecord
-/// to the vector being populated and updating the State with a new value
-/// reference value to interpret TSC deltas.
+/// Reads a function record from an FDR format log into \p Record, updating the
+/// State with a new value reference value to interpret TSC deltas.
 ///
 /// The XRayRecord constructed includes information from the function record
 /// processed here as well as Thread ID and CPU ID formerly extracted into
 /// State.
 Error processFDRFunctionRecord(FDRState &State, uint8_t RecordFirstByte,
                                DataExtractor &RecordExtractor,
-                               std::vector<XRayRecord> &Records) {
+                               XRayRecord &Record) {
   switch (State.Expects) {
   case FDRState::Token::NEW_BUFFER_RECORD_OR_EOF:
     return make_error<StringError>(
@@ -409,9 +434,8 @@ Error processFDRFunctionRecord(FDRState &State, uint8_t RecordFirstByte,
         "Malformed log. Received Function Record before first CPU record.",
         std::make_error_code(std::errc::executable_format_error));
   default:
-    Records.emplace_back();
-    auto &Record = Records.back();
     Record.RecordType = 0; // Record is type NORMAL.
+    Record.CallArgs.clear();
     // Strip off record type bit and use the next three bits.
     uint8_t RecordType = (RecordFirstByte >> 1) & 0x07;
     switch (RecordType) {
@@ -490,8 +514,21 @@ Error processFDRFunctionRecord(FDRState &State, uint8_t RecordFirstByte,
 ///                in the buffer. This is measured from the start of the buffer
 ///                and must always be at least 48 (bytes).
 /// EOB: *deprecated*
-Error loadFDRLog(StringRef Data, XRayFileHeader &FileHeader,
-                 std::vector<XRayRecord> &Records) {
+class FDRTraceReader : public TraceReader {
+  StringRef Remaining;
+  uint64_t BufferSize = 0;
+  FDRState State;
+
+  Error readRecord(XRayRecord &Record, XRayRecord *LastRecord,
+                   bool &IsFunctionRecord);
+  bool atCallArgumentRecord() const;
+
+public:
+  Error init(StringRef Data);
+  Expected<bool> readNextRecord(XRayRecord &Record) override;
+};
+
+Error FDRTraceReader::init(StringRef Data) {
   if (Data.size() < 32)
     return make_error<StringError>(
         "Not enough bytes for an XRay log.",
@@ -508,7 +545,6 @@ Error loadFDRLog(StringRef Data, XRayFileHeader &FileHeader,
   if (auto E = readBinaryFormatHeader(Data, FileHeader))
     return E;
 
-  uint64_t BufferSize = 0;
   {
     StringRef ExtraDataRef(FileHeader.FreeFormData, 16);
     DataExtractor ExtraDataExtractor(ExtraDataRef, true, 8);
@@ -529,73 +565,112 @@ Error loadFDRLog(StringRef Data, XRayFileHeader &FileHeader,
         Twine("Unsupported version '") + Twine(FileHeader.Version) + "'",
         std::make_error_code(std::errc::executable_format_error));
   }
-  FDRState State{0, 0, 0, InitialExpectation, BufferSize, 0};
+  State = {0, 0, 0, InitialExpectation, BufferSize, 0};
+  Remaining = Data.drop_front(32);
+  return Error::success();
+}
 
-  // RecordSize will tell the loop how far to seek ahead based on the record
-  // type that we have just read.
+/// Consumes the record at the front of the remaining data and advances the
+/// state machine. A function record is decoded into \p Record, in which case
+/// \p IsFunctionRecord is set.
+Error FDRTraceReader::readRecord(XRayRecord &Record, XRayRecord *LastRecord,
+                                 bool &IsFunctionRecord) {
+  IsFunctionRecord = false;
+  // RecordSize will tell us how far to seek ahead based on the record type that
+  // we have just read.
   size_t RecordSize = 0;
-  for (auto S = Data.drop_front(32); !S.empty(); S = S.drop_front(RecordSize)) {
-    DataExtractor RecordExtractor(S, true, 8);
-    uint32_t OffsetPtr = 0;
-    if (State.Expects == FDRState::Token::SCAN_TO_END_OF_THREAD_BUF) {
-      RecordSize = State.CurrentBufferSize - State.CurrentBufferConsumed;
-      if (S.size() < RecordSize) {
-        return make_error<StringError>(
-            Twine("Incomplete thread buffer. Expected at least ") +
-                Twine(RecordSize) + " bytes but found " + Twine(S.size()),
-            make_error_code(std::errc::invalid_argument));
-      }
-      State.CurrentBufferConsumed = 0;
-      State.Expects = FDRState::Token::NEW_BUFFER_RECORD_OR_EOF;
-      continue;
-    }
-    uint8_t BitField = RecordExtractor.getU8(&OffsetPtr);
-    bool isMetadataRecord = BitField & 0x01uL;
-    bool isBufferExtents =
-        (BitField >> 1) == 7; // BufferExtents record kind == 7
-    if (isMetadataRecord) {
-      RecordSize = 16;
-      if (auto E =
-              processFDRMetadataRecord(State, BitField, RecordExtractor,
-                                       RecordSize, Records, FileHeader.Version))
-        return E;
-    } else { // Process Function Record
-      RecordSize = 8;
-      if (auto E = processFDRFunctionRecord(State, BitField, RecordExtractor,
-                                            Records))
-        return E;
+  if (State.Expects == FDRState::Token::SCAN_TO_END_OF_THREAD_BUF) {
+    RecordSize = State.CurrentBufferSize - State.CurrentBufferConsumed;
+    if (Remaining.size() < RecordSize) {
+      return make_error<StringError>(
+          Twine("Incomplete thread buffer. Expected at least ") +
+              Twine(RecordSize) + " bytes but found " +
+              Twine(Remaining.size()),
+          make_error_code(std::errc::invalid_argument));
     }
+    State.CurrentBufferConsumed = 0;
+    State.Expects = FDRState::Token::NEW_BUFFER_RECORD_OR_EOF;
+    Remaining = Remaining.drop_front(RecordSize);
+    return Error::success();
+  }
 
-    // The BufferExtents record is technically not part of the buffer, so we
-    // don't count the size of that record against the buffer's actual size.
-    if (!isBufferExtents)
-      State.CurrentBufferConsumed += RecordSize;
-    assert(State.CurrentBufferConsumed <= State.CurrentBufferSize);
-    if (FileHeader.Version == 2 &&
-        State.CurrentBufferSize == State.CurrentBufferConsumed) {
-      // In Version 2 of the log, we don't need to scan to the end of the thread
-      // buffer if we've already consumed all the bytes we need to.
-      State.Expects = FDRState::Token::BUFFER_EXTENTS;
-      State.CurrentBufferSize = BufferSize;
-      State.CurrentBufferConsumed = 0;
-    }
+  DataExtractor RecordExtractor(Remaining, true, 8);
+  uint32_t OffsetPtr = 0;
+  uint8_t BitField = RecordExtractor.getU8(&OffsetPtr);
+  bool isMetadataRecord = BitField & 0x01uL;
+  bool isBufferExtents =
+      (BitField >> 1) == 7; // BufferExtents record kind == 7
+  if (isMetadataRecord) {
+    RecordSize = 16;
+    if (auto E = processFDRMetadataRecord(State, BitField, RecordExtractor,
+                                          RecordSize, LastRecord,
+                                          FileHeader.Version))
+      return E;
+  } else { // Process Function Record
+    RecordSize = 8;
+    if (auto E = processFDRFunctionRecord(State, BitField, RecordExtractor,
+                                          Record))
+      return E;
+    IsFunctionRecord = true;
   }
+  Remaining = Remaining.drop_front(RecordSize);
+
+  // The BufferExtents record is technically not part of the buffer, so we
+  // don't count the size of that record against the buffer's actual size.
+  if (!isBufferExtents)
+    State.CurrentBufferConsumed += RecordSize;
+  assert(State.CurrentBufferConsumed <= State.CurrentBufferSize);
+  if (FileHeader.Version == 2 &&
+      State.CurrentBufferSize == State.CurrentBufferConsumed) {
+    // In Version 2 of the log, we don't need to scan to the end of the thread
+    // buffer if we've already consumed all the bytes we need to.
+    State.Expects = FDRState::Token::BUFFER_EXTENTS;
+    State.CurrentBufferSize = BufferSize;
+    State.CurrentBufferConsumed = 0;
+  }
+  return Error::success();
+}
 
-  // Having iterated over everything we've been given, we've either consumed
-  // everything and ended up in the end state, or were told to skip the rest.
-  bool Finished = State.Expects == FDRState::Token::SCAN_TO_END_OF_THREAD_BUF &&
-                  State.CurrentBufferSize == State.CurrentBufferConsumed;
-  if ((State.Expects != FDRState::Token::NEW_BUFFER_RECORD_OR_EOF &&
-       State.Expects != FDRState::Token::BUFFER_EXTENTS) &&
-      !Finished)
-    return make_error<StringError>(
-        Twine("Encountered EOF with unexpected state expectation ") +
-            fdrStateToTwine(State.Expects) +
-            ". Remaining expected bytes in thread buffer total " +
-            Twine(State.CurrentBufferSize - State.CurrentBufferConsumed),
-        std::make_error_code(std::errc::executable_format_error));
+/// Returns whether the next record to read is a CallArgument metadata record.
+bool FDRTraceReader::atCallArgumentRecord() const {
+  if (Remaining.empty() ||
+      State.Expects == FDRState::Token::SCAN_TO_END_OF_THREAD_BUF)
+    return false;
+  uint8_t BitField = Remaining.front();
+  return (BitField & 0x01uL) && (BitField >> 1) == 6;
+}
 
-  return Error::success();
+Expected<bool> FDRTraceReader::readNextRecord(XRayRecord &Record) {
+  bool IsFunctionRecord = false;
+  while (!IsFunctionRecord) {
+    if (Remaining.empty()) {
+      // Having iterated over everything we've been given, we've either
+      // consumed everything and ended up in the end state, or were told to
+      // skip the rest.
+      bool Finished =
+          State.Expects == FDRState::Token::SCAN_TO_END_OF_THREAD_BUF &&
+          State.CurrentBufferSize == State.CurrentBufferConsumed;
+      if ((State.Expects != FDRState::Token::NEW_BUFFER_RECORD_OR_EOF &&
+           State.Expects != FDRState::Token::BUFFER_EXTENTS) &&
+          !Finished)
+        return make_error<StringError>(
+            Twine("Encountered EOF with unexpected state expectation ") +
+                fdrStateToTwine(State.Expects) +
+                ". Remaining expected bytes in thread buffer total " +
+                Twine(State.CurrentBufferSize - State.CurrentBufferConsumed),
+            std::make_error_code(std::errc::executable_format_error));
+      return false;
+    }
+    if (auto E = readRecord(Record, /*LastRecord=*/nullptr, IsFunctionRecord))
+      return E;
+  }
+
+  // Call arguments follow the function entry they belong to; fold them into
+  // the record before handing it out.
+  while (atCallArgumentRecord())
+    if (auto E = readRecord(Record, &Record, IsFunctionRecord))
+      return E;
+  return true;
 }
 
 Error loadYAMLLog(StringRef Data, XRayFileHeader &FileHeader,
@@ -625,9 +700,41 @@ Error loadYAMLLog(StringRef Data, XRayFileHeader &FileHeader,
                  });
   return Error::success();
 }
+/// YAML traces can't be decoded incrementally, so this reader parses the whole
+/// trace up-front and hands out the records from memory.
+class YAMLTraceReader : public TraceReader {
+  std::vector<XRayRecord> Records;
+  size_t NextRecord = 0;
+
+public:
+  Error init(StringRef Data) { return loadYAMLLog(Data, FileHeader, Records); }
+
+  Expected<bool> readNextRecord(XRayRecord &Record) override {
+    if (NextRecord == Records.size())
+      return false;
+    Record = std::move(Records[NextRecord++]);
+    return true;
+  }
+};
 } // namespace
 
-Expected<Trace> llvm::xray::loadTraceFile(StringRef Filename, bool Sort) {
+TraceReader::~TraceReader() = default;
+
+void TraceReader::record_iterator::advance() {
+  assert(Reader && E && "Can't increment iterator with no Error attached");
+  ErrorAsOutParameter ErrAsOutParam(E);
+  auto MoreOrErr = Reader->readNextRecord(Record);
+  if (!MoreOrErr) {
+    *E = MoreOrErr.takeError();
+    Reader = nullptr;
+    return;
+  }
+  if (!*MoreOrErr)
+    Reader = nullptr;
+}
+
+Expected<std::unique_ptr<TraceReader>>
+TraceReader::create(StringRef Filename) {
   int Fd;
   if (auto EC = sys::fs::openFileForRead(Filename, Fd)) {
     return make_error<StringError>(
@@ -647,13 +754,13 @@ Expected<Trace> llvm::xray::loadTraceFile(StringRef Filename, bool Sort) {
 
   // Map the opened file into memory and use a StringRef to access it later.
   std::error_code EC;
-  sys::fs::mapped_file_region MappedFile(
+  auto MappedFile = llvm::make_unique<sys::fs::mapped_file_region>(
       Fd, sys::fs::mapped_file_region::mapmode::readonly, FileSize, 0, EC);
   if (EC) {
     return make_error<StringError>(
         Twine("Cannot read log from '") + Filename + "'", EC);
   }
-  auto Data = StringRef(MappedFile.data(), MappedFile.size());
+  auto Data = StringRef(MappedFile->data(), MappedFile->size());
 
   // Attempt to detect the file type using file magic. We have a slight bias
   // towards the binary format, and we do this by making sure that the first 4
@@ -669,7 +776,7 @@ Expected<Trace> llvm::xray::loadTraceFile(StringRef Filename, bool Sort) {
   //
   // Only if we can't load either the binary or the YAML format will we yield an
   // error.
-  StringRef Magic(MappedFile.data(), 4);
+  StringRef Magic(MappedFile->data(), 4);
   DataExtractor HeaderExtractor(Magic, true, 8);
   uint32_t OffsetPtr = 0;
   uint16_t Version = HeaderExtractor.getU16(&OffsetPtr);
@@ -677,12 +784,14 @@ Expected<Trace> llvm::xray::loadTraceFile(StringRef Filename, bool Sort) {
 
   enum BinaryFormatType { NAIVE_FORMAT = 0, FLIGHT_DATA_RECORDER_FORMAT = 1 };
 
-  Trace T;
+  std::unique_ptr<TraceReader> Reader;
   switch (Type) {
   case NAIVE_FORMAT:
     if (Version == 1 || Version == 2) {
-      if (auto E = loadNaiveFormatLog(Data, T.FileHeader, T.Records))
+      auto NaiveReader = llvm::make_unique<NaiveTraceReader>();
+      if (auto E = NaiveReader->init(Data))
         return std::move(E);
+      Reader = std::move(NaiveReader);
     } else {
       return make_error<StringError>(
           Twine("Unsupported version for Basic/Naive Mode logging: ") +
@@ -692,8 +801,10 @@ Expected<Trace> llvm::xray::loadTraceFile(StringRef Filename, bool Sort) {
     break;
   case FLIGHT_DATA_RECORDER_FORMAT:
     if (Version == 1 || Version == 2) {
-      if (auto E = loadFDRLog(Data, T.FileHeader, T.Records))
+      auto FDRReader = llvm::make_unique<FDRTraceReader>();
+      if (auto E = FDRReader->init(Data))
         return std::move(E);
+      Reader = std::move(FDRReader);
     } else {
       return make_error<StringError>(
           Twine("Unsupported version for FDR Mode logging: ") + Twine(Version),
@@ -701,8 +812,32 @@ Expected<Trace> llvm::xray::loadTraceFile(StringRef Filename, bool Sort) {
     }
     break;
   default:
-    if (auto E = loadYAMLLog(Data, T.FileHeader, T.Records))
+    auto YAMLReader = llvm::make_unique<YAMLTraceReader>();
+    if (auto E = YAMLReader->init(Data))
       return std::move(E);
+    Reader = std::move(YAMLReader);
+  }
+
+  Reader->MappedFile = std::move(MappedFile);
+  return Reader;
+}
+
+Expected<Trace> llvm::xray::loadTraceFile(StringRef Filename, bool Sort) {
+  auto ReaderOrErr = TraceReader::create(Filename);
+  if (!ReaderOrErr)
+    return ReaderOrErr.takeError();
+  auto &Reader = **ReaderOrErr;
+
+  Trace T;
+  T.FileHeader = Reader.getFileHeader();
+  XRayRecord Record;
+  while (true) {
+    auto MoreOrErr = Reader.readNextRecord(Record);
+    if (!MoreOrErr)
+      return MoreOrErr.takeError();
+    if (!*MoreOrErr)
+      break;
+    T.Records.push_back(std::move(Record));
   }
 
   if (Sort)
@@ -0,0 +1,32 @@
+; Check that loading module-level metadata on demand outside of importing
+; still round-trips every node reachable from the module.
+; RUN: llvm-as -bitcode-mdindex-threshold=0 < %s -o %t.bc
+; RUN: llvm-dis -ondemand-module-mds-loading < %t.bc | FileCheck %s
+; RUN: llvm-dis < %t.bc | FileCheck %s
+; RUN: llvm-bcanalyzer -time-load %t.bc | FileCheck %s --check-prefix=TIME
+
+; CHECK: @g = global i32 0, !attached !0
+@g = global i32 0, !attached !0
+
+; CHECK: define void @f() !attached !2
+define void @f() !attached !2 {
+  ; CHECK: ret void, !inst !3
+  ret void, !inst !3
+}
+
+; CHECK: !named = !{!0, !1}
+!named = !{!0, !1}
+
+; CHECK: !0 = !{!"global"}
+; CHECK-NEXT: !1 = distinct !{!1, !0}
+; CHECK-NEXT: !2 = !{!"function", !1}
+; CHECK-NEXT: !3 = !{!"instruction", i32 42}
+!0 = !{!"global"}
+!1 = distinct !{!1, !0}
+!2 = !{!"function", !1}
+!3 = !{!"instruction", i32 42}
+
+; TIME: Lazy module load:
+; TIME: Module metadata:
+; TIME: Function bodies:
+; TIME: Total:
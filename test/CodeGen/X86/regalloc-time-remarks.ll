@@ -0,0 +1,61 @@
+; RUN: llc < %s -mtriple=x86_64-unknown-unknown -pass-remarks-analysis=regalloc \
+; RUN:     -o /dev/null 2>&1 | FileCheck %s -check-prefix=REMARK
+; RUN: llc < %s -mtriple=x86_64-unknown-unknown -o /dev/null 2>&1 \
+; RUN:     | FileCheck %s -allow-empty -check-prefix=NO_REMARK
+; RUN: llc < %s -mtriple=x86_64-unknown-unknown -o /dev/null \
+; RUN:     -pass-remarks-output=%t.yaml
+; RUN: FileCheck %s -check-prefix=YAML < %t.yaml
+
+; The greedy allocator reports the time spent in each of its phases when
+; analysis remarks are requested. The times vary from run to run, so only the
+; shape of the remark is checked.
+
+; REMARK: remark: <unknown>:0:0: register allocation spent {{[0-9]+}}us in {{[0-9]+}} evictions, {{[0-9]+}}us in {{[0-9]+}} local splits, {{[0-9]+}}us in {{[0-9]+}} global splits, {{[0-9]+}}us in {{[0-9]+}} spills and {{[0-9]+}}us computing spill weights
+
+; NO_REMARK-NOT: remark
+
+; YAML:      --- !Analysis
+; YAML-NEXT: Pass:            regalloc
+; YAML-NEXT: Name:            RegAllocTime
+; YAML-NEXT: Function:        pressure
+; YAML-NEXT: Args:
+; YAML-NEXT:   - String:          'register allocation spent '
+; YAML-NEXT:   - EvictTime:       '{{[0-9]+}}'
+; YAML-NEXT:   - String:          'us in '
+; YAML-NEXT:   - NumEvict:        '{{[0-9]+}}'
+; YAML:        - LocalSplitTime:  '{{[0-9]+}}'
+; YAML:        - NumLocalSplit:   '{{[0-9]+}}'
+; YAML:        - GlobalSplitTime: '{{[0-9]+}}'
+; YAML:        - NumGlobalSplit:  '{{[0-9]+}}'
+; YAML:        - SpillTime:       '{{[0-9]+}}'
+; YAML:        - NumSpill:        '{{[0-9]+}}'
+; YAML:        - SpillWeightTime: '{{[0-9]+}}'
+; YAML-NEXT:   - String:          us computing spill weights
+; YAML-NEXT: ...
+
+declare void @use(i64, i64, i64, i64, i64, i64, i64, i64)
+
+define void @pressure(i64* %p) {
+entry:
+  %a0 = getelementptr i64, i64* %p, i64 0
+  %a1 = getelementptr i64, i64* %p, i64 1
+  %a2 = getelementptr i64, i64* %p, i64 2
+  %a3 = getelementptr i64, i64* %p, i64 3
+  %a4 = getelementptr i64, i64* %p, i64 4
+  %a5 = getelementptr i64, i64* %p, i64 5
+  %a6 = getelementptr i64, i64* %p, i64 6
+  %a7 = getelementptr i64, i64* %p, i64 7
+  %v0 = load i64, i64* %a0
+  %v1 = load i64, i64* %a1
+  %v2 = load i64, i64* %a2
+  %v3 = load i64, i64* %a3
+  %v4 = load i64, i64* %a4
+  %v5 = load i64, i64* %a5
+  %v6 = load i64, i64* %a6
+  %v7 = load i64, i64* %a7
+  call void @use(i64 %v0, i64 %v1, i64 %v2, i64 %v3,
+                 i64 %v4, i64 %v5, i64 %v6, i64 %v7)
+  call void @use(i64 %v7, i64 %v6, i64 %v5, i64 %v4,
+                 i64 %v3, i64 %v2, i64 %v1, i64 %v0)
+  ret void
+}
@@ -0,0 +1,17 @@
+; RUN: llc -mtriple=x86_64-unknown-linux-gnu -time-trace \
+; RUN:   -time-trace-granularity=0 -time-trace-file=%t.json %s -o /dev/null
+; RUN: FileCheck --input-file=%t.json %s
+
+; The time trace covers the passes as well as the phases of instruction
+; selection and of the asm printer that are timed by -time-passes.
+
+; CHECK: "traceEvents":[
+; CHECK-DAG: "name":"X86 DAG->DAG Instruction Selection","args":{"detail":"foo"}
+; CHECK-DAG: "name":"Instruction Selection","args":{"detail":"Instruction Selection and Scheduling"}
+; CHECK-DAG: "name":"Total X86 Assembly Printer"
+; CHECK: "name":"process_name"
+
+define i32 @foo(i32 %x) {
+  %a = add i32 %x, 1
+  ret i32 %a
+}
@@ -0,0 +1,26 @@
+// Check that sections larger than the chunk size of the parallel compression
+// are compressed into a single zlib stream that readers can uncompress.
+// RUN: llvm-mc -filetype=obj -compress-debug-sections=zlib -triple x86_64-pc-linux-gnu < %s -o %t
+// RUN: llvm-readobj -sections %t | FileCheck --check-prefix=FLAGS %s
+// RUN: llvm-dwarfdump -debug-str %t | FileCheck --check-prefix=STR %s
+// RUN: llvm-mc -filetype=obj -compress-debug-sections=zlib-gnu -triple x86_64-pc-linux-gnu < %s -o %t
+// RUN: llvm-dwarfdump -debug-str %t | FileCheck --check-prefix=STR %s
+
+// REQUIRES: zlib
+
+// FLAGS:      Name: .debug_str
+// FLAGS-NEXT: Type: SHT_PROGBITS
+// FLAGS-NEXT: Flags [
+// FLAGS-NEXT:   SHF_COMPRESSED
+// FLAGS-NEXT:   SHF_MERGE
+// FLAGS-NEXT:   SHF_STRINGS
+// FLAGS-NEXT: ]
+
+// STR: 0x00000000: "begin"
+// STR: 0x00300008: "end"
+
+	.section	.debug_str,"MS",@progbits,1
+	.asciz	"begin"
+	.fill	3145729, 1, 0x61
+	.byte	0
+	.asciz	"end"
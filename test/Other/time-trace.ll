@@ -0,0 +1,21 @@
+; RUN: opt -time-trace -time-trace-granularity=0 -time-trace-file=%t.json \
+; RUN:   -instcombine -disable-output %s
+; RUN: FileCheck --input-file=%t.json %s
+; RUN: opt -time-trace -time-trace-granularity=0 -time-trace-file=%t.new.json \
+; RUN:   -passes=instcombine -disable-output %s
+; RUN: FileCheck --check-prefix=NEWPM --input-file=%t.new.json %s
+
+; CHECK: "traceEvents":[
+; CHECK-DAG: "name":"Combine redundant instructions","args":{"detail":"foo"}
+; CHECK-DAG: "name":"Total Combine redundant instructions","args":{"count":1,
+; CHECK: "name":"process_name"
+
+; NEWPM: "traceEvents":[
+; NEWPM-DAG: "name":"InstCombinePass","args":{"detail":"foo"}
+; NEWPM-DAG: "name":"Total InstCombinePass","args":{"count":1,
+; NEWPM: "name":"process_name"
+
+define i32 @foo(i32 %x) {
+  %a = add i32 %x, 0
+  ret i32 %a
+}
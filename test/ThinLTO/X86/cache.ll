@@ -40,8 +40,9 @@
 ; RUN:  -r=%t2.bc,_main,plx \
 ; RUN:  -r=%t2.bc,_globalfunc,lx \
 ; RUN:  -r=%t.bc,_globalfunc,plx
-; RUN: ls %t.cache | count 2
+; RUN: ls %t.cache | count 3
 ; RUN: ls %t.cache/llvmcache-* | count 2
+; RUN: ls %t.cache/llvmcache.costs
 
 ; Verify that caches with a timestamp older than the pruning interval
 ; will be pruned
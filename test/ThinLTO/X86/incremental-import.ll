@@ -0,0 +1,59 @@
+; REQUIRES: asserts
+; Check that the import lists saved by a previous link are only recomputed for
+; the modules affected by what changed since.
+
+; RUN: opt -thinlto-bc %s -o %t1.bc
+; RUN: opt -thinlto-bc %p/Inputs/incremental-import1.ll -o %t2.bc
+; RUN: opt -thinlto-bc %p/Inputs/incremental-import3.ll -o %t3.bc
+; RUN: rm -f %t.state
+
+; Nothing to reuse in the first link.
+; RUN: llvm-lto2 run %t1.bc %t2.bc %t3.bc -o %t.o -thinlto-threads=1 \
+; RUN:     -thinlto-import-state=%t.state -debug-only=function-import \
+; RUN:     -r=%t1.bc,main,px -r=%t1.bc,foo, -r=%t2.bc,foo,px -r=%t3.bc,baz,px \
+; RUN:     2> %t.log1
+; RUN: FileCheck %s --check-prefix=FIRST < %t.log1
+; RUN: not grep "Reusing import" %t.log1
+; FIRST-DAG: Computing import for Module '{{.*}}1.bc'
+; FIRST-DAG: Computing import for Module '{{.*}}2.bc'
+; FIRST-DAG: Computing import for Module '{{.*}}3.bc'
+
+; Nothing changed, so every import list is reused.
+; RUN: llvm-lto2 run %t1.bc %t2.bc %t3.bc -o %t.o -thinlto-threads=1 \
+; RUN:     -thinlto-import-state=%t.state -debug-only=function-import \
+; RUN:     -r=%t1.bc,main,px -r=%t1.bc,foo, -r=%t2.bc,foo,px -r=%t3.bc,baz,px \
+; RUN:     2> %t.log2
+; RUN: FileCheck %s --check-prefix=SECOND < %t.log2
+; RUN: not grep "Computing import" %t.log2
+; SECOND-DAG: Reusing import for Module '{{.*}}1.bc'
+; SECOND-DAG: Reusing import for Module '{{.*}}2.bc'
+; SECOND-DAG: Reusing import for Module '{{.*}}3.bc'
+
+; Changing the module defining foo affects the module importing it, but not
+; the unrelated third module.
+; RUN: opt -thinlto-bc %p/Inputs/incremental-import2.ll -o %t2.bc
+; RUN: llvm-lto2 run %t1.bc %t2.bc %t3.bc -o %t.o -thinlto-threads=1 \
+; RUN:     -thinlto-import-state=%t.state -debug-only=function-import \
+; RUN:     -r=%t1.bc,main,px -r=%t1.bc,foo, -r=%t2.bc,foo,px -r=%t3.bc,baz,px \
+; RUN:     2> %t.log3
+; RUN: FileCheck %s --check-prefix=THIRD < %t.log3
+; THIRD-DAG: Computing import for Module '{{.*}}1.bc'
+; THIRD-DAG: Computing import for Module '{{.*}}2.bc'
+; THIRD-DAG: Reusing import for Module '{{.*}}3.bc'
+
+; The objects are the same as those of a link that computes everything.
+; RUN: llvm-lto2 run %t1.bc %t2.bc %t3.bc -o %t.full -thinlto-threads=1 \
+; RUN:     -r=%t1.bc,main,px -r=%t1.bc,foo, -r=%t2.bc,foo,px -r=%t3.bc,baz,px
+; RUN: cmp %t.o.1 %t.full.1
+; RUN: cmp %t.o.2 %t.full.2
+; RUN: cmp %t.o.3 %t.full.3
+
+target datalayout = "e-m:e-i64:64-f80:128-n8:16:32:64-S128"
+target triple = "x86_64-unknown-linux-gnu"
+
+declare i32 @foo(i32)
+
+define i32 @main(i32 %x) {
+  %r = call i32 @foo(i32 %x)
+  ret i32 %r
+}
@@ -0,0 +1,42 @@
+; Check that running the ThinLTO backends in worker processes produces the
+; same objects as running them in-process.
+
+; RUN: opt -thinlto-bc %s -o %t1.bc
+; RUN: opt -thinlto-bc %p/Inputs/out-of-process.ll -o %t2.bc
+
+; RUN: llvm-lto2 run %t1.bc %t2.bc -o %t.in -thinlto-threads=2 \
+; RUN:     -r=%t1.bc,g, \
+; RUN:     -r=%t1.bc,analias, \
+; RUN:     -r=%t1.bc,f,px \
+; RUN:     -r=%t2.bc,g,px \
+; RUN:     -r=%t2.bc,analias,px \
+; RUN:     -r=%t2.bc,aliasee,px
+; RUN: llvm-lto2 run %t1.bc %t2.bc -o %t.out -thinlto-threads=2 \
+; RUN:     -thinlto-out-of-process -thinlto-worker-memory-limit=4096 \
+; RUN:     -r=%t1.bc,g, \
+; RUN:     -r=%t1.bc,analias, \
+; RUN:     -r=%t1.bc,f,px \
+; RUN:     -r=%t2.bc,g,px \
+; RUN:     -r=%t2.bc,analias,px \
+; RUN:     -r=%t2.bc,aliasee,px
+; RUN: cmp %t.in.1 %t.out.1
+; RUN: cmp %t.in.2 %t.out.2
+; RUN: llvm-nm %t.out.1 | FileCheck %s --check-prefix=NM1
+; RUN: llvm-nm %t.out.2 | FileCheck %s --check-prefix=NM2
+
+; NM1: T f
+; NM2: T aliasee
+; NM2: T g
+
+target triple = "x86_64-unknown-linux-gnu"
+target datalayout = "e-m:e-i64:64-f80:128-n8:16:32:64-S128"
+
+declare i32 @g(...)
+declare void @analias(...)
+
+define void @f() {
+entry:
+  call i32 (...) @g()
+  call void (...) @analias()
+  ret void
+}
@@ -0,0 +1,51 @@
+; Check that backends reading their index from a summary table produce the
+; same objects as the in-process backends.
+
+; RUN: opt -thinlto-bc %s -o %t1.bc
+; RUN: opt -thinlto-bc %p/Inputs/summary-table.ll -o %t2.bc
+
+; RUN: llvm-lto2 run %t1.bc %t2.bc -o %t.in \
+; RUN:     -r=%t1.bc,g, \
+; RUN:     -r=%t1.bc,analias, \
+; RUN:     -r=%t1.bc,f,px \
+; RUN:     -r=%t2.bc,g,px \
+; RUN:     -r=%t2.bc,analias,px \
+; RUN:     -r=%t2.bc,aliasee,px
+; RUN: rm -f %t.out.1 %t.out.2
+; RUN: llvm-lto2 run %t1.bc %t2.bc -o %t.out -thinlto-summary-table=%t.table \
+; RUN:     -r=%t1.bc,g, \
+; RUN:     -r=%t1.bc,analias, \
+; RUN:     -r=%t1.bc,f,px \
+; RUN:     -r=%t2.bc,g,px \
+; RUN:     -r=%t2.bc,analias,px \
+; RUN:     -r=%t2.bc,aliasee,px
+; RUN: not ls %t.out.1
+; RUN: not ls %t.out.2
+; RUN: llvm-lto2 thinlto-backend -thinlto-index=%t.table -o %t.out.1 %t1.bc
+; RUN: llvm-lto2 thinlto-backend -thinlto-index=%t.table -o %t.out.2 %t2.bc
+; RUN: cmp %t.in.1 %t.out.1
+; RUN: cmp %t.in.2 %t.out.2
+; RUN: llvm-nm %t.out.1 | FileCheck %s --check-prefix=NM1
+; RUN: llvm-nm %t.out.2 | FileCheck %s --check-prefix=NM2
+
+; A module that is not in the table is diagnosed.
+; RUN: not llvm-lto2 thinlto-backend -thinlto-index=%t.table -o %t.out.3 \
+; RUN:     %t.in.1 2>&1 | FileCheck %s --check-prefix=ERR
+; ERR: not found in summary table
+
+; NM1: T f
+; NM2: T aliasee
+; NM2: T g
+
+target triple = "x86_64-unknown-linux-gnu"
+target datalayout = "e-m:e-i64:64-f80:128-n8:16:32:64-S128"
+
+declare i32 @g(...)
+declare void @analias(...)
+
+define void @f() {
+entry:
+  call i32 (...) @g()
+  call void (...) @analias()
+  ret void
+}
@@ -1,4 +1,6 @@
 ; RUN: opt < %s -sample-profile -sample-profile-file=%S/Inputs/indirect-call.prof -S | FileCheck %s
+; RUN: llvm-profdata merge --sample --compbinary %S/Inputs/indirect-call.prof -o %t.compbinary
+; RUN: opt < %s -sample-profile -sample-profile-file=%t.compbinary -S | FileCheck %s
 
 ; CHECK-LABEL: @test
 define void @test(void ()*) !dbg !3 {
@@ -1,5 +1,7 @@
 ; RUN: opt < %s -sample-profile -sample-profile-file=%S/Inputs/inline.prof -sample-profile-inline-hot-threshold=1 -S | FileCheck %s
 ; RUN: opt < %s -passes=sample-profile -sample-profile-file=%S/Inputs/inline.prof -sample-profile-inline-hot-threshold=1 -S | FileCheck %s
+; RUN: llvm-profdata merge --sample --compbinary %S/Inputs/inline.prof -o %t.compbinary
+; RUN: opt < %s -sample-profile -sample-profile-file=%t.compbinary -sample-profile-inline-hot-threshold=1 -S | FileCheck %s
 
 ; Original C++ test case
 ;
@@ -22,7 +22,8 @@
 ; RUN:     --plugin-opt=cache-dir=%t.cache \
 ; RUN:     -o %t3.o %t2.o %t.o
 
-; RUN: ls %t.cache | count 2
+; Two cached objects plus the entry cost log.
+; RUN: ls %t.cache | count 3
 
 
 ; Create two files that would be removed by cache pruning due to age.
@@ -35,8 +36,9 @@
 ; RUN:     --plugin-opt=cache-policy=prune_after=1h:prune_interval=0s \
 ; RUN:     -o %t3.o %t2.o %t.o
 
-; Two cached objects, plus a timestamp file and "foo", minus the file we removed.
-; RUN: ls %t.cache | count 4
+; Two cached objects, plus a timestamp file, the cost log and "foo", minus the
+; file we removed.
+; RUN: ls %t.cache | count 6
 
 
 ; Create a file of size 64KB.
@@ -57,7 +59,7 @@
 ; RUN:     --plugin-opt=cache-dir=%t.cache \
 ; RUN:     --plugin-opt=cache-policy=cache_size_bytes=32k:prune_interval=0s \
 ; RUN:     -o %t3.o %t2.o %t.o
-; RUN: ls %t.cache | count 4
+; RUN: ls %t.cache | count 5
 
 
 target datalayout = "e-m:e-i64:64-f80:128-n8:16:32:64-S128"
@@ -25,3 +25,4 @@ int main(int argc, const char *argv[]) {
   return 0;
 }
 // RUN: llvm-cov export %S/Inputs/showExpansions.covmapping -instr-profile %S/Inputs/showExpansions.profdata 2>&1 | FileCheck %S/Inputs/showExpansions.json
+// RUN: llvm-cov export %S/Inputs/showExpansions.covmapping -instr-profile %S/Inputs/showExpansions.profdata -num-threads=2 2>&1 | FileCheck %S/Inputs/showExpansions.json
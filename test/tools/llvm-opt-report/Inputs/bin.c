@@ -0,0 +1,5 @@
+int foo() { return 1; }
+
+int bar() {
+  return foo();
+}
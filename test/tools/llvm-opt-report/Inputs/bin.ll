@@ -0,0 +1,27 @@
+; Compiled from bin.c, which calls foo from bar.
+
+define i32 @foo() !dbg !6 {
+entry:
+  ret i32 1, !dbg !8
+}
+
+define i32 @bar() !dbg !9 {
+entry:
+  %call = call i32 @foo(), !dbg !10
+  ret i32 %call, !dbg !11
+}
+
+!llvm.dbg.cu = !{!0}
+!llvm.module.flags = !{!3, !4}
+
+!0 = distinct !DICompileUnit(language: DW_LANG_C99, file: !1, isOptimized: true, runtimeVersion: 0, emissionKind: LineTablesOnly, enums: !2)
+!1 = !DIFile(filename: "Inputs/bin.c", directory: "")
+!2 = !{}
+!3 = !{i32 2, !"Dwarf Version", i32 4}
+!4 = !{i32 2, !"Debug Info Version", i32 3}
+!5 = !DISubroutineType(types: !2)
+!6 = distinct !DISubprogram(name: "foo", scope: !1, file: !1, line: 1, type: !5, isLocal: false, isDefinition: true, scopeLine: 1, isOptimized: true, unit: !0, variables: !2)
+!8 = !DILocation(line: 1, column: 13, scope: !6)
+!9 = distinct !DISubprogram(name: "bar", scope: !1, file: !1, line: 3, type: !5, isLocal: false, isDefinition: true, scopeLine: 3, isOptimized: true, unit: !0, variables: !2)
+!10 = !DILocation(line: 4, column: 10, scope: !9)
+!11 = !DILocation(line: 4, column: 3, scope: !9)
@@ -0,0 +1,46 @@
+; RUN: llvm-split -balance-by-cost -o %t %s
+; RUN: llvm-dis -o - %t0 | FileCheck --check-prefix=CHECK0 %s
+; RUN: llvm-dis -o - %t1 | FileCheck --check-prefix=CHECK1 %s
+
+; @big costs as much as everything else together, so it gets a partition of
+; its own and the small functions and globals are packed into the other one.
+
+; CHECK0: declare i32 @small1
+; CHECK0: declare i32 @small2
+; CHECK0: declare i32 @small3
+; CHECK0: define i32 @big
+
+; CHECK1: @g = global i32 0
+; CHECK1: define i32 @small1
+; CHECK1: define i32 @small2
+; CHECK1: define i32 @small3
+; CHECK1: declare i32 @big
+
+@g = global i32 0
+
+define i32 @small1() {
+  %v = load i32, i32* @g
+  ret i32 %v
+}
+
+define i32 @small2() {
+  %v = call i32 @small1()
+  ret i32 %v
+}
+
+define i32 @small3() {
+  %v = call i32 @small2()
+  ret i32 %v
+}
+
+define i32 @big(i32 %x) {
+  %a = add i32 %x, 1
+  %b = mul i32 %a, %x
+  %c = sub i32 %b, %a
+  %d = xor i32 %c, %b
+  %e = shl i32 %d, 3
+  %f = or i32 %e, %c
+  %g = call i32 @small3()
+  %h = add i32 %f, %g
+  ret i32 %h
+}
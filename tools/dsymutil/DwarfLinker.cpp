@@ -13,6 +13,7 @@
 #include "NonRelocatableStringpool.h"
 #include "dsymutil.h"
 #include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/BitVector.h"
 #include "llvm/ADT/DenseMap.h"
 #include "llvm/ADT/DenseMapInfo.h"
 #include "llvm/ADT/DenseSet.h"
@@ -73,6 +74,7 @@
 #include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/Path.h"
 #include "llvm/Support/TargetRegistry.h"
+#include "llvm/Support/ThreadPool.h"
 #include "llvm/Support/ToolOutputFile.h"
 #include "llvm/Support/raw_ostream.h"
 #include "llvm/Target/TargetMachine.h"
@@ -81,12 +83,14 @@
 #include <cassert>
 #include <cinttypes>
 #include <climits>
+#include <condition_variable>
 #include <cstdint>
 #include <cstdlib>
 #include <cstring>
 #include <limits>
 #include <map>
 #include <memory>
+#include <mutex>
 #include <string>
 #include <system_error>
 #include <tuple>
@@ -1197,7 +1201,7 @@ namespace {
 class DwarfLinker {
 public:
   DwarfLinker(raw_fd_ostream &OutFile, const LinkOptions &Options)
-      : OutFile(OutFile), Options(Options), BinHolder(Options.Verbose) {}
+      : OutFile(OutFile), Options(Options) {}
 
   /// Link the contents of the DebugMap.
   bool link(const DebugMap &);
@@ -1206,6 +1210,8 @@ public:
                      const DWARFDie *DIE = nullptr) const;
 
 private:
+  struct LinkContext;
+
   /// Called at the start of a debug object link.
   void startDebugObject(DWARFContext &, DebugMapObject &);
 
@@ -1279,6 +1285,61 @@ private:
                           bool isLittleEndian);
   };
 
+  /// A clang module referenced by a debug map object. The module is loaded
+  /// and analyzed along with the object, and cloned just before it.
+  struct ModuleUnit {
+    std::unique_ptr<BinaryHolder> ObjHolder;
+    std::unique_ptr<DWARFContext> DwarfContext;
+    std::unique_ptr<CompileUnit> Unit;
+    std::string Filename;
+
+    /// The number of modules of the same object that were cloned before this
+    /// one in the output, and whose definitions it can refer to.
+    unsigned NumPrecedingModules;
+  };
+
+  /// The state of the link of a debug map object. Objects go through the
+  /// loadDebugObject(), analyzeDebugObject(), keepDebugObjectDIEs() and
+  /// cloneDebugObject() stages in turn; the last two have to process the
+  /// objects in the debug map order, but the first ones can run ahead on
+  /// other threads.
+  struct LinkContext {
+    DebugMapObject &DMO;
+    BinaryHolder BinHolder;
+    RelocationManager RelocMgr;
+    std::unique_ptr<DWARFContext> DwarfContext;
+
+    /// The units of the object, which are not clang module references.
+    std::vector<std::unique_ptr<CompileUnit>> CompileUnits;
+
+    /// The clang modules first referenced by the object, in the order in
+    /// which they must be cloned.
+    std::vector<ModuleUnit> ModuleUnits;
+
+    /// The diagnostics reported while loading and analyzing the object on
+    /// another thread, printed when the object is cloned.
+    std::string Diagnostics;
+
+    LinkContext(DwarfLinker &Linker, DebugMapObject &DMO, bool Verbose)
+        : DMO(DMO), BinHolder(Verbose), RelocMgr(Linker) {}
+  };
+
+  /// Load the object file of \p Ctx, find its valid relocations and read
+  /// in its debug info.
+  void loadDebugObject(LinkContext &Ctx, const DebugMap &Map);
+
+  /// Create the units of \p Ctx, load the clang modules they refer to and
+  /// build the DIE parent links and the ODR contexts of all of them.
+  void analyzeDebugObject(LinkContext &Ctx, DebugMap &ModuleMap);
+
+  /// Clone the clang modules referenced by \p Ctx and mark the DIEs of its
+  /// units that need to be present in the linked output.
+  void keepDebugObjectDIEs(LinkContext &Ctx);
+
+  /// Clone the DIEs of \p Ctx that were kept and emit them along with the
+  /// line tables, ranges and frame info of the object.
+  void cloneDebugObject(LinkContext &Ctx);
+
   /// \defgroup FindRootDIEs Find DIEs corresponding to debug map entries.
   ///
   /// @{
@@ -1298,14 +1359,19 @@ private:
   /// hash.
   bool registerModuleReference(const DWARFDie &CUDie,
                                const DWARFUnit &Unit, DebugMap &ModuleMap,
-                               unsigned Indent = 0);
+                               LinkContext &Ctx, unsigned Indent = 0);
 
   /// Recursively add the debug info in this clang module .pcm
   /// file (and all the modules imported by it in a bottom-up fashion)
-  /// to Units.
+  /// to the modules to clone along with \p Ctx.
   Error loadClangModule(StringRef Filename, StringRef ModulePath,
                         StringRef ModuleName, uint64_t DwoId,
-                        DebugMap &ModuleMap, unsigned Indent = 0);
+                        DebugMap &ModuleMap, LinkContext &Ctx,
+                        unsigned Indent = 0);
+
+  /// Clone the clang module \p Module. Its forward declarations of types
+  /// defined in the modules cloned before \p ModulesEndOffset are pruned.
+  void cloneModuleUnit(ModuleUnit &Module, uint64_t ModulesEndOffset);
 
   /// Flags passed to DwarfLinker::lookForDIEsToKeep
   enum TravesalFlags {
@@ -1530,7 +1596,6 @@ private:
 
   raw_fd_ostream &OutFile;
   LinkOptions Options;
-  BinaryHolder BinHolder;
   std::unique_ptr<DwarfStreamer> Streamer;
   uint64_t OutputDebugInfoSize;
 
@@ -1539,12 +1604,9 @@ private:
 
   unsigned MaxDwarfVersion = 0;
 
-  /// The units of the current debug map object.
+  /// The units of the debug map object being cloned.
   std::vector<std::unique_ptr<CompileUnit>> Units;
 
-  /// The debug map object currently under consideration.
-  DebugMapObject *CurrentDebugObject;
-
   /// The Dwarf string pool.
   NonRelocatableStringpool StringPool;
 
@@ -1840,6 +1902,19 @@ bool DwarfLinker::DIECloner::getDIENames(const DWARFDie &Die,
   return Info.Name || Info.MangledName;
 }
 
+/// The debug map object the current thread is working on, which is the
+/// context of the warnings it reports.
+static LLVM_THREAD_LOCAL const DebugMapObject *CurrentDebugObject = nullptr;
+
+/// If set, the stream the diagnostics of the current thread are buffered in,
+/// so that they are printed in the debug map order.
+static LLVM_THREAD_LOCAL raw_ostream *DiagnosticsStream = nullptr;
+
+/// The stream the diagnostics of the current thread go to.
+static raw_ostream &diagnostics() {
+  return DiagnosticsStream ? *DiagnosticsStream : errs();
+}
+
 /// Report a warning to the user, optionaly including
 /// information about a specific \p DIE related to the warning.
 void DwarfLinker::reportWarning(const Twine &Warning,
@@ -1847,7 +1922,8 @@ void DwarfLinker::reportWarning(const Twine &Warning,
   StringRef Context = "<debug map>";
   if (CurrentDebugObject)
     Context = CurrentDebugObject->getObjectFilename();
-  warn(Warning, Context);
+  diagnostics() << "while processing " << Context << ":\n"
+                << "warning: " << Warning << "\n";
 
   if (!Options.Verbose || !DIE)
     return;
@@ -1856,8 +1932,8 @@ void DwarfLinker::reportWarning(const Twine &Warning,
   DumpOpts.RecurseDepth = 0;
   DumpOpts.Verbose = Options.Verbose;
 
-  errs() << "    in DIE:\n";
-  DIE->dump(errs(), 6 /* Indent */, DumpOpts);
+  diagnostics() << "    in DIE:\n";
+  DIE->dump(diagnostics(), 6 /* Indent */, DumpOpts);
 }
 
 bool DwarfLinker::createStreamer(const Triple &TheTriple,
@@ -1869,12 +1945,23 @@ bool DwarfLinker::createStreamer(const Triple &TheTriple,
   return Streamer->init(TheTriple);
 }
 
+/// \returns whether \p DIE, a child of the unit DIE of \p CU, is the
+/// DW_TAG_module of a clang module imported by \p CU rather than the one
+/// \p CU defines.
+static bool isImportedModule(const DWARFDie &DIE, const CompileUnit &CU) {
+  return DIE.getTag() == dwarf::DW_TAG_module &&
+         dwarf::toString(DIE.find(dwarf::DW_AT_name), "") !=
+             CU.getClangModuleName();
+}
+
 /// Recursive helper to build the global DeclContext information and
 /// gather the child->parent relationships in the original compile unit.
 ///
 /// \return true when this DIE and all of its children are only
 /// forward declarations to types defined in external clang modules
 /// (i.e., forward declarations that are children of a DW_TAG_module).
+/// Whether these declarations can actually be pruned depends on their
+/// definitions having been cloned, which is checked by updatePruning().
 static bool analyzeContextInfo(const DWARFDie &DIE,
                                unsigned ParentIdx, CompileUnit &CU,
                                DeclContext *CurrentDeclContext,
@@ -1896,11 +1983,8 @@ static bool analyzeContextInfo(const DWARFDie &DIE,
   //   definitions match)."
   //
   // We treat non-C++ modules like namespaces for this reason.
-  if (DIE.getTag() == dwarf::DW_TAG_module && ParentIdx == 0 &&
-      dwarf::toString(DIE.find(dwarf::DW_AT_name), "") !=
-          CU.getClangModuleName()) {
+  if (ParentIdx == 0 && isImportedModule(DIE, CU))
     InImportedModule = true;
-  }
 
   Info.ParentIdx = ParentIdx;
   bool InClangModule = CU.isClangModule() || InImportedModule;
@@ -1930,12 +2014,38 @@ static bool analyzeContextInfo(const DWARFDie &DIE,
       (DIE.getTag() == dwarf::DW_TAG_module) ||
       dwarf::toUnsigned(DIE.find(dwarf::DW_AT_declaration), 0);
 
+  return Info.Prune;
+}
+
+/// Recursive helper for updatePruning().
+static bool updatePruning(const DWARFDie &DIE, CompileUnit &CU,
+                          uint64_t ModulesEndOffset) {
+  CompileUnit::DIEInfo &Info = CU.getInfo(CU.getOrigUnit().getDIEIndex(DIE));
+  if (DIE.hasChildren())
+    for (auto Child : DIE.children())
+      Info.Prune &= updatePruning(Child, CU, ModulesEndOffset);
+
   // Don't prune it if there is no definition for the DIE.
-  Info.Prune &= Info.Ctxt && Info.Ctxt->getCanonicalDIEOffset();
+  uint32_t Offset = Info.Ctxt ? Info.Ctxt->getCanonicalDIEOffset() : 0;
+  Info.Prune &= Offset && Offset < ModulesEndOffset;
 
   return Info.Prune;
 }
 
+/// Only prune the forward declarations found by analyzeContextInfo() in the
+/// modules imported by \p CU if their definition was cloned before
+/// \p ModulesEndOffset in the output. The definitions are cloned after the
+/// analysis, which can run on another thread, so this has to be done right
+/// before the DIEs to keep are chosen.
+static void updatePruning(CompileUnit &CU, uint64_t ModulesEndOffset) {
+  auto CUDie = CU.getOrigUnit().getUnitDIE();
+  if (!CUDie.hasChildren())
+    return;
+  for (auto Child : CUDie.children())
+    if (isImportedModule(Child, CU))
+      updatePruning(Child, CU, ModulesEndOffset);
+}
+
 static bool dieNeedsChildrenToBeMeaningful(uint32_t Tag) {
   switch (Tag) {
   default:
@@ -3375,7 +3485,7 @@ static uint64_t getDwoId(const DWARFDie &CUDie,
 
 bool DwarfLinker::registerModuleReference(
     const DWARFDie &CUDie, const DWARFUnit &Unit,
-    DebugMap &ModuleMap, unsigned Indent) {
+    DebugMap &ModuleMap, LinkContext &Ctx, unsigned Indent) {
   std::string PCMfile =
       dwarf::toString(CUDie.find({dwarf::DW_AT_dwo_name,
                                   dwarf::DW_AT_GNU_dwo_name}), "");
@@ -3416,7 +3526,7 @@ bool DwarfLinker::registerModuleReference(
   // shouldn't run into an infinite loop, so mark it as processed now.
   ClangModules.insert({PCMfile, DwoId});
   if (Error E = loadClangModule(PCMfile, PCMpath, Name, DwoId, ModuleMap,
-                                Indent + 2)) {
+                                Ctx, Indent + 2)) {
     consumeError(std::move(E));
     return false;
   }
@@ -3440,16 +3550,17 @@ DwarfLinker::loadObject(BinaryHolder &BinaryHolder, DebugMapObject &Obj,
 
 Error DwarfLinker::loadClangModule(StringRef Filename, StringRef ModulePath,
                                    StringRef ModuleName, uint64_t DwoId,
-                                   DebugMap &ModuleMap, unsigned Indent) {
+                                   DebugMap &ModuleMap, LinkContext &Ctx,
+                                   unsigned Indent) {
   SmallString<80> Path(Options.PrependPath);
   if (sys::path::is_relative(Filename))
     sys::path::append(Path, ModulePath, Filename);
   else
     sys::path::append(Path, Filename);
-  BinaryHolder ObjHolder(Options.Verbose);
+  auto ObjHolder = llvm::make_unique<BinaryHolder>(Options.Verbose);
   auto &Obj = ModuleMap.addDebugMapObject(
       Path, sys::TimePoint<std::chrono::seconds>(), MachO::N_OSO);
-  auto ErrOrObj = loadObject(ObjHolder, Obj, ModuleMap);
+  auto ErrOrObj = loadObject(*ObjHolder, Obj, ModuleMap);
   if (!ErrOrObj) {
     // Try and emit more helpful warnings by applying some heuristics.
     StringRef ObjFile = CurrentDebugObject->getObjectFilename();
@@ -3462,9 +3573,10 @@ Error DwarfLinker::loadClangModule(StringRef Filename, StringRef ModulePath,
         // cache has expired and was pruned by clang.  A more adventurous
         // dsymutil would invoke clang to rebuild the module now.
         if (!ModuleCacheHintDisplayed) {
-          errs() << "note: The clang module cache may have expired since this "
-                    "object file was built. Rebuilding the object file will "
-                    "rebuild the module cache.\n";
+          diagnostics()
+              << "note: The clang module cache may have expired since this "
+                 "object file was built. Rebuilding the object file will "
+                 "rebuild the module cache.\n";
           ModuleCacheHintDisplayed = true;
         }
       } else if (isArchive) {
@@ -3473,11 +3585,12 @@ Error DwarfLinker::loadClangModule(StringRef Filename, StringRef ModulePath,
         // was built on a different machine. We don't want to discourage module
         // debugging for convenience libraries within a project though.
         if (!ArchiveHintDisplayed) {
-          errs() << "note: Linking a static library that was built with "
-                    "-gmodules, but the module cache was not found.  "
-                    "Redistributable static libraries should never be built "
-                    "with module debugging enabled.  The debug experience will "
-                    "be degraded due to incomplete debug information.\n";
+          diagnostics()
+              << "note: Linking a static library that was built with "
+                 "-gmodules, but the module cache was not found.  "
+                 "Redistributable static libraries should never be built "
+                 "with module debugging enabled.  The debug experience will "
+                 "be degraded due to incomplete debug information.\n";
           ArchiveHintDisplayed = true;
         }
       }
@@ -3486,22 +3599,22 @@ Error DwarfLinker::loadClangModule(StringRef Filename, StringRef ModulePath,
   }
 
   std::unique_ptr<CompileUnit> Unit;
+  unsigned NumPrecedingModules = 0;
 
   // Setup access to the debug info.
   auto DwarfContext = DWARFContext::create(*ErrOrObj);
-  RelocationManager RelocMgr(*this);
   for (const auto &CU : DwarfContext->compile_units()) {
     maybeUpdateMaxDwarfVersion(CU->getVersion());
 
     // Recursively get all modules imported by this one.
     auto CUDie = CU->getUnitDIE(false);
-    if (!registerModuleReference(CUDie, *CU, ModuleMap, Indent)) {
+    if (!registerModuleReference(CUDie, *CU, ModuleMap, Ctx, Indent)) {
       if (Unit) {
         std::string Err =
             (Filename +
              ": Clang modules are expected to have exactly 1 compile unit.\n")
                 .str();
-        errs() << Err;
+        diagnostics() << Err;
         return make_error<StringError>(Err, inconvertibleErrorCode());
       }
       // FIXME: Until PR27449 (https://llvm.org/bugs/show_bug.cgi?id=27449) is
@@ -3523,22 +3636,34 @@ Error DwarfLinker::loadClangModule(StringRef Filename, StringRef ModulePath,
       Unit->setHasInterestingContent();
       analyzeContextInfo(CUDie, 0, *Unit, &ODRContexts.getRoot(), StringPool,
                          ODRContexts);
-      // Keep everything.
-      Unit->markEverythingAsKept();
+      // The modules loaded so far are cloned before this one.
+      NumPrecedingModules = Ctx.ModuleUnits.size();
     }
   }
   if (!Unit->getOrigUnit().getUnitDIE().hasChildren())
     return Error::success();
-  if (Options.Verbose) {
-    outs().indent(Indent);
-    outs() << "cloning .debug_info from " << Filename << "\n";
-  }
 
+  // The module is cloned along with the object that first referenced it, once
+  // the objects before it have been cloned.
+  Ctx.ModuleUnits.push_back({std::move(ObjHolder), std::move(DwarfContext),
+                             std::move(Unit), Filename, NumPrecedingModules});
+  return Error::success();
+}
+
+void DwarfLinker::cloneModuleUnit(ModuleUnit &Module,
+                                  uint64_t ModulesEndOffset) {
+  if (Options.Verbose)
+    outs() << "cloning .debug_info from " << Module.Filename << "\n";
+
+  // Keep everything.
+  updatePruning(*Module.Unit, ModulesEndOffset);
+  Module.Unit->markEverythingAsKept();
+
+  RelocationManager RelocMgr(*this);
   std::vector<std::unique_ptr<CompileUnit>> CompileUnits;
-  CompileUnits.push_back(std::move(Unit));
+  CompileUnits.push_back(std::move(Module.Unit));
   DIECloner(*this, RelocMgr, DIEAlloc, CompileUnits, Options)
-      .cloneAllCompileUnits(*DwarfContext);
-  return Error::success();
+      .cloneAllCompileUnits(*Module.DwarfContext);
 }
 
 void DwarfLinker::DIECloner::cloneAllCompileUnits(DWARFContext &DwarfContext) {
@@ -3581,6 +3706,138 @@ void DwarfLinker::DIECloner::cloneAllCompileUnits(DWARFContext &DwarfContext) {
   }
 }
 
+void DwarfLinker::loadDebugObject(LinkContext &Ctx, const DebugMap &Map) {
+  if (Options.Verbose)
+    outs() << "DEBUG MAP OBJECT: " << Ctx.DMO.getObjectFilename() << "\n";
+
+  // N_AST objects (swiftmodule files) are copied when the object is cloned.
+  if (Ctx.DMO.getType() == MachO::N_AST)
+    return;
+
+  auto ErrOrObj = loadObject(Ctx.BinHolder, Ctx.DMO, Map);
+  if (!ErrOrObj)
+    return;
+
+  // Look for relocations that correspond to debug map entries.
+  if (!Ctx.RelocMgr.findValidRelocsInDebugInfo(*ErrOrObj, Ctx.DMO)) {
+    if (Options.Verbose)
+      outs() << "No valid relocations found. Skipping.\n";
+    return;
+  }
+
+  // Setup access to the debug info, and read in the DIEs of all the units.
+  Ctx.DwarfContext = DWARFContext::create(*ErrOrObj);
+  for (const auto &CU : Ctx.DwarfContext->compile_units())
+    CU->getUnitDIE(false);
+}
+
+void DwarfLinker::analyzeDebugObject(LinkContext &Ctx, DebugMap &ModuleMap) {
+  if (!Ctx.DwarfContext)
+    return;
+
+  // In a first phase, just read in the debug info and load all clang modules.
+  for (const auto &CU : Ctx.DwarfContext->compile_units()) {
+    auto CUDie = CU->getUnitDIE(false);
+    if (Options.Verbose) {
+      outs() << "Input compilation unit:";
+      DIDumpOptions DumpOpts;
+      DumpOpts.RecurseDepth = 0;
+      DumpOpts.Verbose = Options.Verbose;
+      CUDie.dump(outs(), 0, DumpOpts);
+    }
+
+    if (!registerModuleReference(CUDie, *CU, ModuleMap, Ctx)) {
+      Ctx.CompileUnits.push_back(llvm::make_unique<CompileUnit>(
+          *CU, UnitID++, !Options.NoODR, ""));
+      maybeUpdateMaxDwarfVersion(CU->getVersion());
+    }
+  }
+
+  // Now build the DIE parent links that we will use during the next phase.
+  for (auto &CurrentUnit : Ctx.CompileUnits)
+    analyzeContextInfo(CurrentUnit->getOrigUnit().getUnitDIE(), 0, *CurrentUnit,
+                       &ODRContexts.getRoot(), StringPool, ODRContexts);
+}
+
+void DwarfLinker::keepDebugObjectDIEs(LinkContext &Ctx) {
+  if (!Ctx.DwarfContext)
+    return;
+
+  startDebugObject(*Ctx.DwarfContext, Ctx.DMO);
+
+  // Clone the clang modules first referenced by this object. A module can
+  // only refer to the definitions of the modules cloned before it was
+  // analyzed.
+  uint64_t ObjectStartOffset = OutputDebugInfoSize;
+  std::vector<uint64_t> ModuleEndOffsets;
+  for (ModuleUnit &Module : Ctx.ModuleUnits) {
+    unsigned NumPreceding = Module.NumPrecedingModules;
+    cloneModuleUnit(Module, NumPreceding ? ModuleEndOffsets[NumPreceding - 1]
+                                         : ObjectStartOffset);
+    ModuleEndOffsets.push_back(OutputDebugInfoSize);
+  }
+
+  Units = std::move(Ctx.CompileUnits);
+  for (auto &CurrentUnit : Units)
+    updatePruning(*CurrentUnit, OutputDebugInfoSize);
+
+  // Then mark all the DIEs that need to be present in the linked
+  // output and collect some information about them. Note that this
+  // loop can not be merged with the analysis because cross-cu
+  // references require the ParentIdx to be setup for every CU in
+  // the object file before calling this.
+  for (auto &CurrentUnit : Units)
+    lookForDIEsToKeep(Ctx.RelocMgr, CurrentUnit->getOrigUnit().getUnitDIE(),
+                      Ctx.DMO, *CurrentUnit, 0);
+}
+
+void DwarfLinker::cloneDebugObject(LinkContext &Ctx) {
+  // N_AST objects (swiftmodule files) should get dumped directly into the
+  // appropriate DWARF section.
+  if (Ctx.DMO.getType() == MachO::N_AST) {
+    StringRef File = Ctx.DMO.getObjectFilename();
+    auto ErrorOrMem = MemoryBuffer::getFile(File);
+    if (!ErrorOrMem) {
+      errs() << "Warning: Could not open " << File << "\n";
+      return;
+    }
+    sys::fs::file_status Stat;
+    if (auto errc = sys::fs::status(File, Stat)) {
+      errs() << "Warning: " << errc.message() << "\n";
+      return;
+    }
+    if (!Options.NoTimestamp && Stat.getLastModificationTime() !=
+                                    sys::TimePoint<>(Ctx.DMO.getTimestamp())) {
+      errs() << "Warning: Timestamp mismatch for " << File << ": "
+             << Stat.getLastModificationTime() << " and "
+             << sys::TimePoint<>(Ctx.DMO.getTimestamp()) << "\n";
+      return;
+    }
+
+    // Copy the module into the .swift_ast section.
+    if (!Options.NoOutput)
+      Streamer->emitSwiftAST((*ErrorOrMem)->getBuffer());
+    return;
+  }
+
+  if (!Ctx.DwarfContext)
+    return;
+
+  // The calls to applyValidRelocs inside cloneDIE will walk the
+  // reloc array again (in the same way findValidRelocsInDebugInfo()
+  // did). We need to reset the NextValidReloc index to the beginning.
+  Ctx.RelocMgr.resetValidRelocs();
+  if (Ctx.RelocMgr.hasValidRelocs())
+    DIECloner(*this, Ctx.RelocMgr, DIEAlloc, Units, Options)
+        .cloneAllCompileUnits(*Ctx.DwarfContext);
+  if (!Options.NoOutput && !Units.empty())
+    patchFrameInfoForObject(Ctx.DMO, *Ctx.DwarfContext,
+                            Units[0]->getOrigUnit().getAddressByteSize());
+
+  // Clean-up before starting working on the next object.
+  endDebugObject();
+}
+
 bool DwarfLinker::link(const DebugMap &Map) {
   if (!createStreamer(Map.getTriple(), OutFile))
     return false;
@@ -3591,102 +3848,102 @@ bool DwarfLinker::link(const DebugMap &Map) {
   UnitID = 0;
   DebugMap ModuleMap(Map.getTriple(), Map.getBinaryPath());
 
-  for (const auto &Obj : Map.objects()) {
-    CurrentDebugObject = Obj.get();
+  std::vector<std::unique_ptr<LinkContext>> ObjectContexts;
+  for (const auto &Obj : Map.objects())
+    ObjectContexts.push_back(
+        llvm::make_unique<LinkContext>(*this, *Obj, Options.Verbose));
+  unsigned NumObjects = ObjectContexts.size();
 
-    if (Options.Verbose)
-      outs() << "DEBUG MAP OBJECT: " << Obj->getObjectFilename() << "\n";
-
-    // N_AST objects (swiftmodule files) should get dumped directly into the
-    // appropriate DWARF section.
-    if (Obj->getType() == MachO::N_AST) {
-      StringRef File = Obj->getObjectFilename();
-      auto ErrorOrMem = MemoryBuffer::getFile(File);
-      if (!ErrorOrMem) {
-        errs() << "Warning: Could not open " << File << "\n";
-        continue;
-      }
-      sys::fs::file_status Stat;
-      if (auto errc = sys::fs::status(File, Stat)) {
-        errs() << "Warning: " << errc.message() << "\n";
-        continue;
-      }
-      if (!Options.NoTimestamp && Stat.getLastModificationTime() !=
-                                      sys::TimePoint<>(Obj->getTimestamp())) {
-        errs() << "Warning: Timestamp mismatch for " << File << ": "
-               << Stat.getLastModificationTime() << " and "
-               << sys::TimePoint<>(Obj->getTimestamp()) << "\n";
-        continue;
-      }
+#if LLVM_ENABLE_THREADS
+  unsigned NumThreads = Options.Verbose ? 1 : Options.Threads;
+#else
+  unsigned NumThreads = 1;
+#endif
 
-      // Copy the module into the .swift_ast section.
-      if (!Options.NoOutput)
-        Streamer->emitSwiftAST((*ErrorOrMem)->getBuffer());
-      continue;
+  if (NumThreads <= 1 || NumObjects <= 1) {
+    for (auto &Ctx : ObjectContexts) {
+      CurrentDebugObject = &Ctx->DMO;
+      loadDebugObject(*Ctx, Map);
+      analyzeDebugObject(*Ctx, ModuleMap);
+      keepDebugObjectDIEs(*Ctx);
+      cloneDebugObject(*Ctx);
+      Ctx.reset();
     }
+  } else {
+    // The choice of the DIEs to keep and their cloning decide which
+    // definitions are canonical and assign the output offsets, so they
+    // process the objects in order, on this thread as they can recurse
+    // deeply. The objects are loaded ahead of them by a pool of threads, and
+    // analyzed in order by one thread of the pool while the object before is
+    // cloned. The analysis of an object updates the ODR contexts that the
+    // choice of the DIEs to keep looks at, so it waits for the DIEs of the
+    // previous object to be kept. This gives the same output as a serial link.
+    std::mutex ProgressMutex;
+    std::condition_variable ProgressCondition;
+    BitVector Loaded(NumObjects);
+    unsigned NumAnalyzed = 0;
+    unsigned NumKept = 0;
+
+    auto WaitFor = [&](function_ref<bool()> Condition) {
+      std::unique_lock<std::mutex> Lock(ProgressMutex);
+      ProgressCondition.wait(Lock, Condition);
+    };
+    auto Notify = [&](function_ref<void()> Update) {
+      std::lock_guard<std::mutex> Lock(ProgressMutex);
+      Update();
+      ProgressCondition.notify_all();
+    };
 
-    auto ErrOrObj = loadObject(BinHolder, *Obj, Map);
-    if (!ErrOrObj)
-      continue;
-
-    // Look for relocations that correspond to debug map entries.
-    RelocationManager RelocMgr(*this);
-    if (!RelocMgr.findValidRelocsInDebugInfo(*ErrOrObj, *Obj)) {
-      if (Options.Verbose)
-        outs() << "No valid relocations found. Skipping.\n";
-      continue;
-    }
+    // Warnings reported on the pool threads are buffered in the contexts of
+    // the objects they are about.
+    auto RunBuffered = [&](LinkContext &Ctx, function_ref<void()> Stage) {
+      raw_string_ostream OS(Ctx.Diagnostics);
+      CurrentDebugObject = &Ctx.DMO;
+      DiagnosticsStream = &OS;
+      Stage();
+      DiagnosticsStream = nullptr;
+      CurrentDebugObject = nullptr;
+    };
 
-    // Setup access to the debug info.
-    auto DwarfContext = DWARFContext::create(*ErrOrObj);
-    startDebugObject(*DwarfContext, *Obj);
-
-    // In a first phase, just read in the debug info and load all clang modules.
-    for (const auto &CU : DwarfContext->compile_units()) {
-      auto CUDie = CU->getUnitDIE(false);
-      if (Options.Verbose) {
-        outs() << "Input compilation unit:";
-        DIDumpOptions DumpOpts;
-        DumpOpts.RecurseDepth = 0;
-        DumpOpts.Verbose = Options.Verbose;
-        CUDie.dump(outs(), 0, DumpOpts);
+    ThreadPool Pool(NumThreads);
+    Pool.async([&] {
+      for (unsigned I = 0; I != NumObjects; ++I) {
+        WaitFor([&] { return Loaded[I] && NumKept >= I; });
+        LinkContext &Ctx = *ObjectContexts[I];
+        RunBuffered(Ctx, [&] { analyzeDebugObject(Ctx, ModuleMap); });
+        Notify([&] { ++NumAnalyzed; });
       }
-
-      if (!registerModuleReference(CUDie, *CU, ModuleMap)) {
-        Units.push_back(llvm::make_unique<CompileUnit>(*CU, UnitID++,
-                                                       !Options.NoODR, ""));
-        maybeUpdateMaxDwarfVersion(CU->getVersion());
+    });
+
+    // As the loaded objects stay in memory until they are cloned, only load
+    // a few objects ahead of the one being cloned.
+    unsigned NumLoadsScheduled = 0;
+    auto ScheduleLoads = [&](unsigned End) {
+      for (; NumLoadsScheduled < std::min(End, NumObjects);
+           ++NumLoadsScheduled) {
+        unsigned I = NumLoadsScheduled;
+        Pool.async([&, I] {
+          LinkContext &Ctx = *ObjectContexts[I];
+          RunBuffered(Ctx, [&] { loadDebugObject(Ctx, Map); });
+          Notify([&] { Loaded.set(I); });
+        });
       }
-    }
+    };
 
-    // Now build the DIE parent links that we will use during the next phase.
-    for (auto &CurrentUnit : Units)
-      analyzeContextInfo(CurrentUnit->getOrigUnit().getUnitDIE(), 0, *CurrentUnit,
-                         &ODRContexts.getRoot(), StringPool, ODRContexts);
-
-    // Then mark all the DIEs that need to be present in the linked
-    // output and collect some information about them. Note that this
-    // loop can not be merged with the previous one becaue cross-cu
-    // references require the ParentIdx to be setup for every CU in
-    // the object file before calling this.
-    for (auto &CurrentUnit : Units)
-      lookForDIEsToKeep(RelocMgr, CurrentUnit->getOrigUnit().getUnitDIE(), *Obj,
-                        *CurrentUnit, 0);
-
-    // The calls to applyValidRelocs inside cloneDIE will walk the
-    // reloc array again (in the same way findValidRelocsInDebugInfo()
-    // did). We need to reset the NextValidReloc index to the beginning.
-    RelocMgr.resetValidRelocs();
-    if (RelocMgr.hasValidRelocs())
-      DIECloner(*this, RelocMgr, DIEAlloc, Units, Options)
-          .cloneAllCompileUnits(*DwarfContext);
-    if (!Options.NoOutput && !Units.empty())
-      patchFrameInfoForObject(*Obj, *DwarfContext,
-                              Units[0]->getOrigUnit().getAddressByteSize());
-
-    // Clean-up before starting working on the next object.
-    endDebugObject();
+    for (unsigned I = 0; I != NumObjects; ++I) {
+      ScheduleLoads(I + 1 + NumThreads);
+      WaitFor([&] { return NumAnalyzed > I; });
+      LinkContext &Ctx = *ObjectContexts[I];
+      errs() << Ctx.Diagnostics;
+      CurrentDebugObject = &Ctx.DMO;
+      keepDebugObjectDIEs(Ctx);
+      Notify([&] { ++NumKept; });
+      cloneDebugObject(Ctx);
+      ObjectContexts[I].reset();
+    }
+    Pool.wait();
   }
+  CurrentDebugObject = nullptr;
 
   // Emit everything that's global.
   if (!Options.NoOutput) {
@@ -3701,6 +3958,7 @@ bool DwarfLinker::link(const DebugMap &Map) {
 /// can insert a new element or return the offset of a preexisitng
 /// one.
 uint32_t NonRelocatableStringpool::getStringOffset(StringRef S) {
+  std::lock_guard<std::mutex> Lock(StringsMutex);
   if (S.empty() && !Strings.empty())
     return 0;
 
@@ -3726,6 +3984,7 @@ uint32_t NonRelocatableStringpool::getStringOffset(StringRef S) {
 /// that go into the output section. A latter call to
 /// getStringOffset() with the same string will chain it though.
 StringRef NonRelocatableStringpool::internString(StringRef S) {
+  std::lock_guard<std::mutex> Lock(StringsMutex);
   std::pair<uint32_t, StringMapEntryBase *> Entry(0, nullptr);
   auto InsertResult = Strings.insert(std::make_pair(S, Entry));
   return InsertResult.first->getKey();
@@ -14,6 +14,7 @@
 #include "llvm/ADT/StringRef.h"
 #include "llvm/Support/Allocator.h"
 #include <cstdint>
+#include <mutex>
 #include <utility>
 
 namespace llvm {
@@ -25,6 +26,10 @@ namespace dsymutil {
 /// has relocation entries for every reference to it. This class
 /// provides this ablitity by just associating offsets with
 /// strings.
+///
+/// Strings can be interned and looked up from several threads at once. As
+/// the offsets are only assigned by getStringOffset(), the layout of the
+/// table only depends on the order of the calls to that method.
 class NonRelocatableStringpool {
 public:
   /// \brief Entries are stored into the StringMap and simply linked
@@ -65,6 +70,7 @@ public:
 
 private:
   MapTy Strings;
+  std::mutex StringsMutex;
   uint32_t CurrentEndOffset = 0;
   MapTy::MapEntryTy Sentinel, *Last;
 };
@@ -78,7 +78,7 @@ static alias FlatOutA("f", desc("Alias for --flat"), aliasopt(FlatOut));
 static opt<unsigned> NumThreads(
     "num-threads",
     desc("Specifies the maximum number (n) of simultaneous threads to use\n"
-         "when linking multiple architectures."),
+         "when linking."),
     value_desc("n"), init(0), cat(DsymCategory));
 static alias NumThreadsA("j", desc("Alias for --num-threads"),
                          aliasopt(NumThreads));
@@ -353,6 +353,10 @@ int main(int argc, char **argv) {
       NumThreads = llvm::thread::hardware_concurrency();
     if (DumpDebugMap || Verbose)
       NumThreads = 1;
+    // The threads that are not needed to link the architectures in parallel
+    // are shared by the links to process their object files in parallel.
+    Options.Threads =
+        std::max<unsigned>(1, NumThreads / DebugMapPtrsOrErr->size());
     NumThreads = std::min<unsigned>(NumThreads, DebugMapPtrsOrErr->size());
 
     llvm::ThreadPool Threads(NumThreads);
@@ -45,6 +45,9 @@ struct LinkOptions {
   /// -oso-prepend-path
   std::string PrependPath;
 
+  /// Number of threads used to link a debug map
+  unsigned Threads = 1;
+
   LinkOptions() = default;
 };
 
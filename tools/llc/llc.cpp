@@ -24,6 +24,7 @@
 #include "llvm/CodeGen/MachineModuleInfo.h"
 #include "llvm/CodeGen/TargetPassConfig.h"
 #include "llvm/CodeGen/TargetSubtargetInfo.h"
+#include "llvm/IR/BinaryRemarks.h"
 #include "llvm/IR/DataLayout.h"
 #include "llvm/IR/DiagnosticInfo.h"
 #include "llvm/IR/DiagnosticPrinter.h"
@@ -47,6 +48,7 @@
 #include "llvm/Support/SourceMgr.h"
 #include "llvm/Support/TargetRegistry.h"
 #include "llvm/Support/TargetSelect.h"
+#include "llvm/Support/TimeProfiler.h"
 #include "llvm/Support/ToolOutputFile.h"
 #include "llvm/Target/TargetMachine.h"
 #include "llvm/Transforms/Utils/Cloning.h"
@@ -139,9 +141,30 @@ static cl::opt<unsigned> PassRemarksHotnessThreshold(
 
 static cl::opt<std::string>
     RemarksFilename("pass-remarks-output",
-                    cl::desc("YAML output filename for pass remarks"),
+                    cl::desc("Output filename for pass remarks"),
                     cl::value_desc("filename"));
 
+static cl::opt<std::string>
+    RemarksFormat("pass-remarks-format",
+                  cl::desc("The format of the pass remarks output file: yaml "
+                           "or binary (default: yaml)"),
+                  cl::value_desc("format"), cl::init("yaml"));
+
+static cl::opt<bool>
+    TimeTrace("time-trace",
+              cl::desc("Record the time spent in passes in a Chrome trace"));
+
+static cl::opt<unsigned> TimeTraceGranularity(
+    "time-trace-granularity",
+    cl::desc(
+        "Minimum time granularity (in microseconds) traced by time profiler"),
+    cl::init(500));
+
+static cl::opt<std::string>
+    TimeTraceFile("time-trace-file",
+                  cl::desc("Specify time trace file destination"),
+                  cl::value_desc("filename"));
+
 namespace {
 static ManagedStatic<std::vector<std::string>> RunPassNames;
 
@@ -321,17 +344,26 @@ int main(int argc, char **argv) {
   if (PassRemarksHotnessThreshold)
     Context.setDiagnosticsHotnessThreshold(PassRemarksHotnessThreshold);
 
-  std::unique_ptr<ToolOutputFile> YamlFile;
+  std::unique_ptr<ToolOutputFile> RemarksFile;
   if (RemarksFilename != "") {
+    if (RemarksFormat != "yaml" && RemarksFormat != "binary") {
+      errs() << argv[0] << ": unknown remarks format '" << RemarksFormat
+             << "'\n";
+      return 1;
+    }
     std::error_code EC;
-    YamlFile =
+    RemarksFile =
         llvm::make_unique<ToolOutputFile>(RemarksFilename, EC, sys::fs::F_None);
     if (EC) {
       errs() << EC.message() << '\n';
       return 1;
     }
-    Context.setDiagnosticsOutputFile(
-        llvm::make_unique<yaml::Output>(YamlFile->os()));
+    if (RemarksFormat == "binary")
+      Context.setDiagnosticsBinaryOutputFile(
+          llvm::make_unique<BinaryRemarkWriter>(RemarksFile->os()));
+    else
+      Context.setDiagnosticsOutputFile(
+          llvm::make_unique<yaml::Output>(RemarksFile->os()));
   }
 
   if (InputLanguage != "" && InputLanguage != "ir" &&
@@ -340,14 +372,26 @@ int main(int argc, char **argv) {
     return 1;
   }
 
+  if (TimeTrace)
+    timeTraceProfilerInitialize(TimeTraceGranularity, argv[0]);
+
   // Compile the module TimeCompilations times to give better compile time
   // metrics.
   for (unsigned I = TimeCompilations; I; --I)
     if (int RetVal = compileModule(argv, Context))
       return RetVal;
 
-  if (YamlFile)
-    YamlFile->keep();
+  if (TimeTrace) {
+    // compileModule() has derived the output filename if none was given.
+    if (Error E = timeTraceProfilerWrite(TimeTraceFile, OutputFilename)) {
+      logAllUnhandledErrors(std::move(E), errs(), Twine(argv[0]) + ": ");
+      return 1;
+    }
+    timeTraceProfilerCleanup();
+  }
+
+  if (RemarksFile)
+    RemarksFile->keep();
   return 0;
 }
 
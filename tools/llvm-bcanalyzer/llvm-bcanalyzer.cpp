@@ -31,6 +31,8 @@
 #include "llvm/Bitcode/BitcodeReader.h"
 #include "llvm/Bitcode/BitstreamReader.h"
 #include "llvm/Bitcode/LLVMBitCodes.h"
+#include "llvm/IR/LLVMContext.h"
+#include "llvm/IR/Module.h"
 #include "llvm/Support/CommandLine.h"
 #include "llvm/Support/Format.h"
 #include "llvm/Support/ManagedStatic.h"
@@ -38,6 +40,7 @@
 #include "llvm/Support/PrettyStackTrace.h"
 #include "llvm/Support/SHA1.h"
 #include "llvm/Support/Signals.h"
+#include "llvm/Support/Timer.h"
 #include "llvm/Support/raw_ostream.h"
 using namespace llvm;
 
@@ -70,6 +73,11 @@ static cl::opt<std::string> CheckHash(
     "check-hash",
     cl::desc("Check module hash using the argument as a string table"));
 
+static cl::opt<bool> TimeLoad(
+    "time-load",
+    cl::desc("Instead of dumping, load the module lazily, materialize it, and "
+             "report the time and heap memory used by each step"));
+
 namespace {
 
 /// CurStreamTypeType - A type for CurStreamType
@@ -959,6 +967,50 @@ static int AnalyzeBitcode() {
   return 0;
 }
 
+static void printLoadStep(StringRef Name, const TimeRecord &Start,
+                          const TimeRecord &End) {
+  outs() << format("%-20s wall %9.4fs  user %9.4fs  heap %+12lld bytes\n",
+                   Name.str().c_str(), End.getWallTime() - Start.getWallTime(),
+                   End.getUserTime() - Start.getUserTime(),
+                   (long long)(End.getMemUsed() - Start.getMemUsed()));
+}
+
+/// Time reading the module through the lazy bitcode reader, the way the
+/// ThinLTO importer does: first the module-level records only, then the
+/// module-level metadata, then every function body.
+static int TimeModuleLoad() {
+  ErrorOr<std::unique_ptr<MemoryBuffer>> MemBufOrErr =
+      MemoryBuffer::getFileOrSTDIN(InputFilename);
+  if (std::error_code EC = MemBufOrErr.getError())
+    return ReportError(Twine("ReportError reading '") + InputFilename +
+                       "': " + EC.message());
+  std::unique_ptr<MemoryBuffer> MemBuf = std::move(MemBufOrErr.get());
+
+  LLVMContext Context;
+  TimeRecord Start = TimeRecord::getCurrentTime(true);
+  Expected<std::unique_ptr<Module>> MOrErr =
+      getLazyBitcodeModule(MemBuf->getMemBufferRef(), Context,
+                           /*ShouldLazyLoadMetadata=*/true);
+  if (!MOrErr)
+    return ReportError(toString(MOrErr.takeError()));
+  std::unique_ptr<Module> M = std::move(*MOrErr);
+  TimeRecord AfterLazyLoad = TimeRecord::getCurrentTime(false);
+
+  if (Error Err = M->materializeMetadata())
+    return ReportError(toString(std::move(Err)));
+  TimeRecord AfterMetadata = TimeRecord::getCurrentTime(false);
+
+  if (Error Err = M->materializeAll())
+    return ReportError(toString(std::move(Err)));
+  TimeRecord AfterAll = TimeRecord::getCurrentTime(false);
+
+  outs() << "Bitcode size: " << MemBuf->getBufferSize() << " bytes\n";
+  printLoadStep("Lazy module load:", Start, AfterLazyLoad);
+  printLoadStep("Module metadata:", AfterLazyLoad, AfterMetadata);
+  printLoadStep("Function bodies:", AfterMetadata, AfterAll);
+  printLoadStep("Total:", Start, AfterAll);
+  return 0;
+}
 
 int main(int argc, char **argv) {
   // Print a stack trace if we signal out.
@@ -967,5 +1019,7 @@ int main(int argc, char **argv) {
   llvm_shutdown_obj Y;  // Call llvm_shutdown() on exit.
   cl::ParseCommandLineOptions(argc, argv, "llvm-bcanalyzer file analyzer\n");
 
+  if (TimeLoad)
+    return TimeModuleLoad();
   return AnalyzeBitcode();
 }
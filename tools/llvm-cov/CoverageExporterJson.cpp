@@ -45,6 +45,8 @@
 #include "CoverageSummaryInfo.h"
 #include "CoverageViewOptions.h"
 #include "llvm/ProfileData/Coverage/CoverageMapping.h"
+#include "llvm/Support/ThreadPool.h"
+#include <algorithm>
 #include <stack>
 
 /// \brief The semantic version combined as a string.
@@ -240,10 +242,36 @@ class CoverageExporterJson {
     // Start List of Files.
     emitArrayStart();
 
-    for (unsigned I = 0, E = SourceFiles.size(); I < E; ++I) {
-      // Render the file.
-      auto FileCoverage = Coverage.getCoverageForFile(SourceFiles[I]);
-      renderFile(FileCoverage, FileReports[I]);
+    // The coverage of the files is computed in parallel, a batch of NumThreads
+    // files at a time, and each batch is written out before the next one is
+    // computed. This bounds the memory used by the coverage of the files,
+    // which can be much larger than the JSON written for it.
+    unsigned NumThreads =
+        CoverageReport::getNumThreads(Options, SourceFiles.size());
+    ThreadPool Pool(NumThreads);
+    std::vector<CoverageData> Batch(NumThreads);
+    for (unsigned Start = 0, E = SourceFiles.size(); Start < E;
+         Start += NumThreads) {
+      unsigned BatchSize = std::min(NumThreads, E - Start);
+      for (unsigned I = 0; I < BatchSize; ++I) {
+        StringRef Filename = SourceFiles[Start + I];
+        // Segments and expansions are not exported in summary-only mode.
+        if (Options.ExportSummaryOnly)
+          Batch[I] = CoverageData(Filename);
+        else if (NumThreads == 1)
+          Batch[I] = Coverage.getCoverageForFile(Filename);
+        else
+          Pool.async([this, &Batch, I, Filename] {
+            Batch[I] = Coverage.getCoverageForFile(Filename);
+          });
+      }
+      Pool.wait();
+
+      // Render the files.
+      for (unsigned I = 0; I < BatchSize; ++I) {
+        renderFile(Batch[I], FileReports[Start + I]);
+        Batch[I] = CoverageData();
+      }
     }
 
     // End List of Files.
@@ -16,6 +16,8 @@
 #include "llvm/ADT/DenseMap.h"
 #include "llvm/Support/Format.h"
 #include "llvm/Support/Path.h"
+#include "llvm/Support/Threading.h"
+#include "llvm/Support/ThreadPool.h"
 #include <numeric>
 
 using namespace llvm;
@@ -319,43 +321,76 @@ void CoverageReport::renderFunctionReports(ArrayRef<std::string> Files,
   }
 }
 
-std::vector<FileCoverageSummary> CoverageReport::prepareFileReports(
-    const coverage::CoverageMapping &Coverage, FileCoverageSummary &Totals,
-    ArrayRef<std::string> Files, const CoverageViewOptions &Options,
+void CoverageReport::prepareSingleFileReport(
+    StringRef Filename, const coverage::CoverageMapping &Coverage,
+    const CoverageViewOptions &Options, FileCoverageSummary &FileReport,
     const CoverageFilter &Filters) {
-  std::vector<FileCoverageSummary> FileReports;
-  unsigned LCP = getRedundantPrefixLen(Files);
-
-  for (StringRef Filename : Files) {
-    FileCoverageSummary Summary(Filename.drop_front(LCP));
-
-    for (const auto &Group : Coverage.getInstantiationGroups(Filename)) {
-      std::vector<FunctionCoverageSummary> InstantiationSummaries;
-      for (const coverage::FunctionRecord *F : Group.getInstantiations()) {
-        if (!Filters.matches(Coverage, *F))
-          continue;
-        auto InstantiationSummary = FunctionCoverageSummary::get(Coverage, *F);
-        Summary.addInstantiation(InstantiationSummary);
-        Totals.addInstantiation(InstantiationSummary);
-        InstantiationSummaries.push_back(InstantiationSummary);
-      }
-      if (InstantiationSummaries.empty())
+  for (const auto &Group : Coverage.getInstantiationGroups(Filename)) {
+    std::vector<FunctionCoverageSummary> InstantiationSummaries;
+    for (const coverage::FunctionRecord *F : Group.getInstantiations()) {
+      if (!Filters.matches(Coverage, *F))
         continue;
+      auto InstantiationSummary = FunctionCoverageSummary::get(Coverage, *F);
+      FileReport.addInstantiation(InstantiationSummary);
+      InstantiationSummaries.push_back(InstantiationSummary);
+    }
+    if (InstantiationSummaries.empty())
+      continue;
 
-      auto GroupSummary =
-          FunctionCoverageSummary::get(Group, InstantiationSummaries);
+    auto GroupSummary =
+        FunctionCoverageSummary::get(Group, InstantiationSummaries);
 
-      if (Options.Debug)
-        outs() << "InstantiationGroup: " << GroupSummary.Name << " with "
-               << "size = " << Group.size() << "\n";
+    if (Options.Debug)
+      outs() << "InstantiationGroup: " << GroupSummary.Name << " with "
+             << "size = " << Group.size() << "\n";
 
-      Summary.addFunction(GroupSummary);
-      Totals.addFunction(GroupSummary);
-    }
+    FileReport.addFunction(GroupSummary);
+  }
+}
 
-    FileReports.push_back(Summary);
+unsigned CoverageReport::getNumThreads(const CoverageViewOptions &Options,
+                                       size_t NumFiles) {
+  // The debug output of the files would be interleaved.
+  if (Options.Debug)
+    return 1;
+  // If NumThreads is not specified, auto-detect a good default.
+  if (Options.NumThreads)
+    return Options.NumThreads;
+  return std::max(1U, std::min(llvm::heavyweight_hardware_concurrency(),
+                               unsigned(NumFiles)));
+}
+
+std::vector<FileCoverageSummary> CoverageReport::prepareFileReports(
+    const coverage::CoverageMapping &Coverage, FileCoverageSummary &Totals,
+    ArrayRef<std::string> Files, const CoverageViewOptions &Options,
+    const CoverageFilter &Filters) {
+  unsigned LCP = getRedundantPrefixLen(Files);
+  unsigned NumThreads = getNumThreads(Options, Files.size());
+
+  std::vector<FileCoverageSummary> FileReports;
+  FileReports.reserve(Files.size());
+  for (StringRef Filename : Files)
+    FileReports.emplace_back(Filename.drop_front(LCP));
+
+  // The summaries of the files are independent of each other, so they are
+  // computed in parallel, each into its own slot of FileReports.
+  if (NumThreads == 1) {
+    for (unsigned I = 0, E = Files.size(); I < E; ++I)
+      prepareSingleFileReport(Files[I], Coverage, Options, FileReports[I],
+                              Filters);
+  } else {
+    ThreadPool Pool(NumThreads);
+    for (unsigned I = 0, E = Files.size(); I < E; ++I)
+      Pool.async([&, I] {
+        prepareSingleFileReport(Files[I], Coverage, Options, FileReports[I],
+                                Filters);
+      });
+    Pool.wait();
   }
 
+  for (const FileCoverageSummary &FileReport : FileReports)
+    Totals += FileReport;
+
   return FileReports;
 }
 
@@ -37,7 +37,21 @@ public:
   void renderFunctionReports(ArrayRef<std::string> Files,
                              const DemangleCache &DC, raw_ostream &OS);
 
-  /// Prepare file reports for the files specified in \p Files.
+  /// Return the number of threads to prepare the reports of \p NumFiles files
+  /// with.
+  static unsigned getNumThreads(const CoverageViewOptions &Options,
+                                size_t NumFiles);
+
+  /// Prepare the file report of \p Filename into \p FileReport. The reports of
+  /// different files can be prepared concurrently.
+  static void prepareSingleFileReport(StringRef Filename,
+                                      const coverage::CoverageMapping &Coverage,
+                                      const CoverageViewOptions &Options,
+                                      FileCoverageSummary &FileReport,
+                                      const CoverageFilter &Filters);
+
+  /// Prepare file reports for the files specified in \p Files. The reports
+  /// are prepared in parallel, using Options.NumThreads threads.
   static std::vector<FileCoverageSummary>
   prepareFileReports(const coverage::CoverageMapping &Coverage,
                      FileCoverageSummary &Totals, ArrayRef<std::string> Files,
@@ -21,6 +21,7 @@
 #include "llvm/IR/DiagnosticPrinter.h"
 #include "llvm/LTO/Caching.h"
 #include "llvm/LTO/LTO.h"
+#include "llvm/LTO/LTOBackend.h"
 #include "llvm/Support/CommandLine.h"
 #include "llvm/Support/FileSystem.h"
 #include "llvm/Support/TargetSelect.h"
@@ -65,9 +66,37 @@ static cl::opt<bool>
                                        "import files for the "
                                        "distributed backend case"));
 
+static cl::opt<std::string> ThinLTOSummaryTable(
+    "thinlto-summary-table",
+    cl::desc("Write a summary table for the distributed backends to the given "
+             "file instead of running the backends"),
+    cl::value_desc("filename"));
+
 static cl::opt<int> Threads("thinlto-threads",
                             cl::init(llvm::heavyweight_hardware_concurrency()));
 
+static cl::opt<bool> ThinLTOOutOfProcess(
+    "thinlto-out-of-process", cl::init(false),
+    cl::desc("Run the ThinLTO backends in separate worker processes"));
+
+static cl::opt<unsigned> ThinLTOWorkerMemoryLimit(
+    "thinlto-worker-memory-limit", cl::init(0),
+    cl::desc("Memory limit of each ThinLTO backend worker process in "
+             "megabytes (default = no limit)"),
+    cl::value_desc("megabytes"));
+
+static cl::opt<std::string> ThinLTOImportState(
+    "thinlto-import-state",
+    cl::desc("Save the ThinLTO import lists to this file and reuse them in "
+             "the next link for the modules not affected by changes"),
+    cl::value_desc("filename"));
+
+static cl::opt<std::string>
+    ThinLTOIndex("thinlto-index",
+                 cl::desc("Individual module index file or summary table to "
+                          "use when running as a ThinLTO backend worker"),
+                 cl::value_desc("filename"));
+
 static cl::list<std::string> SymbolResolutions(
     "r",
     cl::desc("Specify a symbol resolution: filename,symbolname,resolution\n"
@@ -141,50 +170,13 @@ template <typename T> static T check(ErrorOr<T> E, std::string Msg) {
 }
 
 static int usage() {
-  errs() << "Available subcommands: dump-symtab run\n";
+  errs() << "Available subcommands: dump-symtab run thinlto-backend\n";
   return 1;
 }
 
-static int run(int argc, char **argv) {
-  cl::ParseCommandLineOptions(argc, argv, "Resolution-based LTO test harness");
-
-  // FIXME: Workaround PR30396 which means that a symbol can appear
-  // more than once if it is defined in module-level assembly and
-  // has a GV declaration. We allow (file, symbol) pairs to have multiple
-  // resolutions and apply them in the order observed.
-  std::map<std::pair<std::string, std::string>, std::list<SymbolResolution>>
-      CommandLineResolutions;
-  for (std::string R : SymbolResolutions) {
-    StringRef Rest = R;
-    StringRef FileName, SymbolName;
-    std::tie(FileName, Rest) = Rest.split(',');
-    if (Rest.empty()) {
-      llvm::errs() << "invalid resolution: " << R << '\n';
-      return 1;
-    }
-    std::tie(SymbolName, Rest) = Rest.split(',');
-    SymbolResolution Res;
-    for (char C : Rest) {
-      if (C == 'p')
-        Res.Prevailing = true;
-      else if (C == 'l')
-        Res.FinalDefinitionInLinkageUnit = true;
-      else if (C == 'x')
-        Res.VisibleToRegularObj = true;
-      else if (C == 'r')
-        Res.LinkerRedefined = true;
-      else {
-        llvm::errs() << "invalid character " << C << " in resolution: " << R
-                     << '\n';
-        return 1;
-      }
-    }
-    CommandLineResolutions[{FileName, SymbolName}].push_back(Res);
-  }
-
-  std::vector<std::unique_ptr<MemoryBuffer>> MBs;
-
-  Config Conf;
+// Initializes Conf from the command line options that are shared by run and
+// thinlto-backend. Returns false if they are invalid.
+static bool setupConfig(Config &Conf) {
   Conf.DiagHandler = [](const DiagnosticInfo &DI) {
     DiagnosticPrinterRawOStream DP(errs());
     DI.print(DP);
@@ -201,10 +193,6 @@ static int run(int argc, char **argv) {
 
   Conf.DebugPassManager = DebugPassManager;
 
-  if (SaveTemps)
-    check(Conf.addSaveTemps(OutputFilename + "."),
-          "Config::addSaveTemps failed");
-
   // Optimization remarks.
   Conf.RemarksFilename = OptRemarksOutput;
   Conf.RemarksWithHotness = OptRemarksWithHotness;
@@ -232,7 +220,7 @@ static int run(int argc, char **argv) {
     break;
   default:
     llvm::errs() << "invalid cg optimization level: " << CGOptLevel << '\n';
-    return 1;
+    return false;
   }
 
   if (FileType.getNumOccurrences())
@@ -240,10 +228,101 @@ static int run(int argc, char **argv) {
 
   Conf.OverrideTriple = OverrideTriple;
   Conf.DefaultTriple = DefaultTriple;
+  return true;
+}
+
+// Returns the arguments that make a thinlto-backend worker use the same
+// optimization and code generation options as this process.
+static std::vector<std::string> getWorkerArgs() {
+  std::vector<std::string> Args = {"thinlto-backend"};
+  Args.push_back(std::string("-O") + OptLevel.getValue());
+  Args.push_back(std::string("-cg-opt-level=") + CGOptLevel.getValue());
+  if (!MCPU.empty())
+    Args.push_back("-mcpu=" + MCPU);
+  if (!MAttrs.empty())
+    Args.push_back("-mattr=" + join(MAttrs.begin(), MAttrs.end(), ","));
+  if (FileType.getNumOccurrences())
+    Args.push_back(FileType == TargetMachine::CGFT_AssemblyFile
+                       ? "-filetype=asm"
+                       : FileType == TargetMachine::CGFT_ObjectFile
+                             ? "-filetype=obj"
+                             : "-filetype=null");
+  if (!OptPipeline.empty())
+    Args.push_back("-opt-pipeline=" + OptPipeline);
+  if (!AAPipeline.empty())
+    Args.push_back("-aa-pipeline=" + AAPipeline);
+  if (!SamplePGOFile.empty())
+    Args.push_back("-lto-sample-profile-file=" + SamplePGOFile);
+  if (UseNewPM)
+    Args.push_back("-use-new-pm");
+  if (DebugPassManager)
+    Args.push_back("-debug-pass-manager");
+  if (!OverrideTriple.empty())
+    Args.push_back("-override-triple=" + OverrideTriple);
+  if (!DefaultTriple.empty())
+    Args.push_back("-default-triple=" + DefaultTriple);
+  return Args;
+}
+
+static int run(int argc, char **argv) {
+  cl::ParseCommandLineOptions(argc, argv, "Resolution-based LTO test harness");
+
+  // FIXME: Workaround PR30396 which means that a symbol can appear
+  // more than once if it is defined in module-level assembly and
+  // has a GV declaration. We allow (file, symbol) pairs to have multiple
+  // resolutions and apply them in the order observed.
+  std::map<std::pair<std::string, std::string>, std::list<SymbolResolution>>
+      CommandLineResolutions;
+  for (std::string R : SymbolResolutions) {
+    StringRef Rest = R;
+    StringRef FileName, SymbolName;
+    std::tie(FileName, Rest) = Rest.split(',');
+    if (Rest.empty()) {
+      llvm::errs() << "invalid resolution: " << R << '\n';
+      return 1;
+    }
+    std::tie(SymbolName, Rest) = Rest.split(',');
+    SymbolResolution Res;
+    for (char C : Rest) {
+      if (C == 'p')
+        Res.Prevailing = true;
+      else if (C == 'l')
+        Res.FinalDefinitionInLinkageUnit = true;
+      else if (C == 'x')
+        Res.VisibleToRegularObj = true;
+      else if (C == 'r')
+        Res.LinkerRedefined = true;
+      else {
+        llvm::errs() << "invalid character " << C << " in resolution: " << R
+                     << '\n';
+        return 1;
+      }
+    }
+    CommandLineResolutions[{FileName, SymbolName}].push_back(Res);
+  }
+
+  std::vector<std::unique_ptr<MemoryBuffer>> MBs;
+
+  Config Conf;
+  if (!setupConfig(Conf))
+    return 1;
+
+  if (SaveTemps)
+    check(Conf.addSaveTemps(OutputFilename + "."),
+          "Config::addSaveTemps failed");
+
+  Conf.ThinLTOImportStateFile = ThinLTOImportState;
 
   ThinBackend Backend;
   if (ThinLTODistributedIndexes)
     Backend = createWriteIndexesThinBackend("", "", true, "");
+  else if (!ThinLTOSummaryTable.empty())
+    Backend = createWriteSummaryTableThinBackend(ThinLTOSummaryTable);
+  else if (ThinLTOOutOfProcess)
+    Backend = createOutOfProcessThinBackend(
+        Threads,
+        sys::fs::getMainExecutable(argv[0], (void *)(intptr_t)&usage),
+        getWorkerArgs(), ThinLTOWorkerMemoryLimit);
   else
     Backend = createInProcessThinBackend(Threads);
   LTO Lto(std::move(Conf), std::move(Backend));
@@ -309,6 +388,33 @@ static int run(int argc, char **argv) {
   return 0;
 }
 
+static int thinLTOBackend(int argc, char **argv) {
+  cl::ParseCommandLineOptions(argc, argv, "ThinLTO backend worker");
+
+  if (InputFilenames.size() != 1 || ThinLTOIndex.empty()) {
+    llvm::errs() << argv[0]
+                 << ": expected one input file and a -thinlto-index file\n";
+    return 1;
+  }
+
+  Config Conf;
+  if (!setupConfig(Conf))
+    return 1;
+
+  auto AddStream =
+      [&](size_t Task) -> std::unique_ptr<lto::NativeObjectStream> {
+    std::error_code EC;
+    auto S =
+        llvm::make_unique<raw_fd_ostream>(OutputFilename, EC, sys::fs::F_None);
+    check(EC, OutputFilename);
+    return llvm::make_unique<lto::NativeObjectStream>(std::move(S));
+  };
+
+  check(thinBackendWorker(Conf, InputFilenames[0], ThinLTOIndex, AddStream),
+        InputFilenames[0]);
+  return 0;
+}
+
 static int dumpSymtab(int argc, char **argv) {
   for (StringRef F : make_range(argv + 1, argv + argc)) {
     std::unique_ptr<MemoryBuffer> MB = check(MemoryBuffer::getFile(F), F);
@@ -398,5 +504,7 @@ int main(int argc, char **argv) {
     return dumpSymtab(argc - 1, argv + 1);
   if (Subcommand == "run")
     return run(argc - 1, argv + 1);
+  if (Subcommand == "thinlto-backend")
+    return thinLTOBackend(argc - 1, argv + 1);
   return usage();
 }
@@ -8,14 +8,15 @@
 //===----------------------------------------------------------------------===//
 ///
 /// \file
-/// \brief This file implements a tool that can parse the YAML optimization
-/// records and generate an optimization summary annotated source listing
-/// report.
+/// \brief This file implements a tool that can parse the YAML or binary
+/// optimization records and generate an optimization summary annotated source
+/// listing report.
 ///
 //===----------------------------------------------------------------------===//
 
 #include "llvm/Support/CommandLine.h"
 #include "llvm/Demangle/Demangle.h"
+#include "llvm/IR/BinaryRemarks.h"
 #include "llvm/Support/Error.h"
 #include "llvm/Support/ErrorOr.h"
 #include "llvm/Support/FileSystem.h"
@@ -142,6 +143,38 @@ typedef std::map<std::string, std::map<int, std::map<std::string, std::map<int,
           OptReportLocationInfo>>>> LocationInfoTy;
 } // anonymous namespace
 
+static void addLocationInfo(LocationInfoTy &LocationInfo, bool Transformed,
+                            StringRef Pass, StringRef File, int Line,
+                            StringRef Function, int Column,
+                            int VectorizationFactor, int InterleaveCount,
+                            int UnrollCount) {
+  if (Line < 1 || File.empty())
+    return;
+
+  // We track information on both actual and potential transformations. This
+  // way, if there are multiple possible things on a line that are, or could
+  // have been transformed, we can indicate that explicitly in the output.
+  auto UpdateLLII = [Transformed](OptReportLocationItemInfo &LLII) {
+    LLII.Analyzed = true;
+    if (Transformed)
+      LLII.Transformed = true;
+  };
+
+  if (Pass == "inline") {
+    auto &LI = LocationInfo[File][Line][Function][Column];
+    UpdateLLII(LI.Inlined);
+  } else if (Pass == "loop-unroll") {
+    auto &LI = LocationInfo[File][Line][Function][Column];
+    LI.UnrollCount = UnrollCount;
+    UpdateLLII(LI.Unrolled);
+  } else if (Pass == "loop-vectorize") {
+    auto &LI = LocationInfo[File][Line][Function][Column];
+    LI.VectorizationFactor = VectorizationFactor;
+    LI.InterleaveCount = InterleaveCount;
+    UpdateLLII(LI.Vectorized);
+  }
+}
+
 static void collectLocationInfo(yaml::Stream &Stream,
                                 LocationInfoTy &LocationInfo) {
   SmallVector<char, 8> Tmp;
@@ -242,32 +275,31 @@ static void collectLocationInfo(yaml::Stream &Stream,
       }
     }
 
-    if (Line < 1 || File.empty())
-      continue;
+    addLocationInfo(LocationInfo, Transformed, Pass, File, Line, Function,
+                    Column, VectorizationFactor, InterleaveCount, UnrollCount);
+  }
+}
 
-    // We track information on both actual and potential transformations. This
-    // way, if there are multiple possible things on a line that are, or could
-    // have been transformed, we can indicate that explicitly in the output.
-    auto UpdateLLII = [Transformed](OptReportLocationItemInfo &LLII) {
-      LLII.Analyzed = true;
-      if (Transformed)
-        LLII.Transformed = true;
-    };
-
-    if (Pass == "inline") {
-      auto &LI = LocationInfo[File][Line][Function][Column];
-      UpdateLLII(LI.Inlined);
-    } else if (Pass == "loop-unroll") {
-      auto &LI = LocationInfo[File][Line][Function][Column];
-      LI.UnrollCount = UnrollCount;
-      UpdateLLII(LI.Unrolled);
-    } else if (Pass == "loop-vectorize") {
-      auto &LI = LocationInfo[File][Line][Function][Column];
-      LI.VectorizationFactor = VectorizationFactor;
-      LI.InterleaveCount = InterleaveCount;
-      UpdateLLII(LI.Vectorized);
-    }
+static void collectLocationInfo(const Remark &R,
+                                LocationInfoTy &LocationInfo) {
+  if (!R.Loc)
+    return;
+
+  int VectorizationFactor = 1;
+  int InterleaveCount = 1;
+  int UnrollCount = 1;
+  for (const RemarkArgument &Arg : R.Args) {
+    if (Arg.Key == "VectorizationFactor")
+      Arg.Val.getAsInteger(10, VectorizationFactor);
+    else if (Arg.Key == "InterleaveCount")
+      Arg.Val.getAsInteger(10, InterleaveCount);
+    else if (Arg.Key == "UnrollCount")
+      Arg.Val.getAsInteger(10, UnrollCount);
   }
+
+  addLocationInfo(LocationInfo, R.Type == RemarkType::Passed, R.PassName,
+                  R.Loc->File, R.Loc->Line, R.FunctionName, R.Loc->Column,
+                  VectorizationFactor, InterleaveCount, UnrollCount);
 }
 
 static bool readLocationInfo(LocationInfoTy &LocationInfo) {
@@ -279,8 +311,21 @@ static bool readLocationInfo(LocationInfoTy &LocationInfo) {
     return false;
   }
 
+  StringRef Buffer = Buf.get()->getBuffer();
+  if (isBinaryRemarks(Buffer)) {
+    Error E = readBinaryRemarks(Buffer, [&](const Remark &R) {
+      collectLocationInfo(R, LocationInfo);
+    });
+    if (E) {
+      logAllUnhandledErrors(std::move(E), errs(),
+                            "error: Can't read file " + InputFileName + ": ");
+      return false;
+    }
+    return true;
+  }
+
   SourceMgr SM;
-  yaml::Stream Stream(Buf.get()->getBuffer(), SM);
+  yaml::Stream Stream(Buffer, SM);
   collectLocationInfo(Stream, LocationInfo);
 
   return true; 
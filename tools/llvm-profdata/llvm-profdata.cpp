@@ -35,7 +35,13 @@
 
 using namespace llvm;
 
-enum ProfileFormat { PF_None = 0, PF_Text, PF_Binary, PF_GCC };
+enum ProfileFormat {
+  PF_None = 0,
+  PF_Text,
+  PF_Binary,
+  PF_GCC,
+  PF_Compact_Binary
+};
 
 static void warn(StringRef Prefix, Twine Message, std::string Whence = "",
                  std::string Hint = "") {
@@ -150,6 +156,26 @@ static bool isFatalError(instrprof_error IPE) {
   }
 }
 
+/// Add a record read from \p Input to the writer of \p WC.
+static void addRecord(NamedInstrProfRecord &&Record, const WeightedFile &Input,
+                      WriterContext *WC) {
+  const StringRef FuncName = Record.Name;
+  bool Reported = false;
+  WC->Writer.addRecord(std::move(Record), Input.Weight, [&](Error E) {
+    if (Reported) {
+      consumeError(std::move(E));
+      return;
+    }
+    Reported = true;
+    // Only show hint the first time an error occurs.
+    instrprof_error IPE = InstrProfError::take(std::move(E));
+    std::unique_lock<std::mutex> ErrGuard{WC->ErrLock};
+    bool firstTime = WC->WriterErrorCodes.insert(IPE).second;
+    handleMergeWriterError(make_error<InstrProfError>(IPE), Input.Filename,
+                           FuncName, firstTime);
+  });
+}
+
 /// Load an input into a writer context.
 static void loadInput(const WeightedFile &Input, WriterContext *WC) {
   std::unique_lock<std::mutex> CtxGuard{WC->Lock};
@@ -174,30 +200,16 @@ static void loadInput(const WeightedFile &Input, WriterContext *WC) {
 
   auto Reader = std::move(ReaderOrErr.get());
   bool IsIRProfile = Reader->isIRLevelProfile();
-  if (WC->Writer.setIsIRLevelProfile(IsIRProfile)) {
+  if (Error E = WC->Writer.setIsIRLevelProfile(IsIRProfile)) {
+    consumeError(std::move(E));
     WC->Err = make_error<StringError>(
         "Merge IR generated profile with Clang generated profile.",
         std::error_code());
     return;
   }
 
-  for (auto &I : *Reader) {
-    const StringRef FuncName = I.Name;
-    bool Reported = false;
-    WC->Writer.addRecord(std::move(I), Input.Weight, [&](Error E) {
-      if (Reported) {
-        consumeError(std::move(E));
-        return;
-      }
-      Reported = true;
-      // Only show hint the first time an error occurs.
-      instrprof_error IPE = InstrProfError::take(std::move(E));
-      std::unique_lock<std::mutex> ErrGuard{WC->ErrLock};
-      bool firstTime = WC->WriterErrorCodes.insert(IPE).second;
-      handleMergeWriterError(make_error<InstrProfError>(IPE), Input.Filename,
-                             FuncName, firstTime);
-    });
-  }
+  for (auto &I : *Reader)
+    addRecord(std::move(I), Input, WC);
   if (Reader->hasError()) {
     if (Error E = Reader->getError()) {
       instrprof_error IPE = InstrProfError::take(std::move(E));
@@ -207,22 +219,77 @@ static void loadInput(const WeightedFile &Input, WriterContext *WC) {
   }
 }
 
-/// Merge the \p Src writer context into \p Dst.
-static void mergeWriterContexts(WriterContext *Dst, WriterContext *Src) {
-  // If we've already seen a hard error, continuing with the merge would
-  // clobber it.
-  if (Dst->Err || Src->Err)
+/// The records of an input, split by the shard of the function name space they
+/// belong to. The records refer to names owned by the reader.
+struct ShardedInput {
+  std::unique_ptr<InstrProfReader> Reader;
+  std::vector<std::vector<NamedInstrProfRecord>> ShardRecords;
+  Error Err = Error::success();
+};
+
+/// Load an input and split its records into \p NumShards shards by function
+/// name.
+static void loadShardedInput(const WeightedFile &Input, ShardedInput *SI,
+                             unsigned NumShards) {
+  auto ReaderOrErr = InstrProfReader::create(Input.Filename);
+  if (Error E = ReaderOrErr.takeError()) {
+    // Skip the empty profiles by returning sliently.
+    instrprof_error IPE = InstrProfError::take(std::move(E));
+    if (IPE != instrprof_error::empty_raw_profile)
+      SI->Err = make_error<InstrProfError>(IPE);
     return;
+  }
 
-  bool Reported = false;
-  Dst->Writer.mergeRecordsFromWriter(std::move(Src->Writer), [&](Error E) {
-    if (Reported) {
+  SI->Reader = std::move(ReaderOrErr.get());
+  SI->ShardRecords.resize(NumShards);
+  for (auto &I : *SI->Reader)
+    SI->ShardRecords[hash_value(I.Name) % NumShards].push_back(std::move(I));
+  if (SI->Reader->hasError()) {
+    if (Error E = SI->Reader->getError()) {
+      instrprof_error IPE = InstrProfError::take(std::move(E));
+      if (isFatalError(IPE))
+        SI->Err = make_error<InstrProfError>(IPE);
+    }
+  }
+}
+
+/// Merge shard \p Shard of each of the loaded \p Inputs into \p WC, in input
+/// order.
+static void mergeShard(ArrayRef<WeightedFile> Inputs,
+                       MutableArrayRef<ShardedInput> Loaded, unsigned Shard,
+                       WriterContext *WC) {
+  for (unsigned I = 0, E = Inputs.size(); I != E; ++I) {
+    // If there's a pending hard error, don't do more work.
+    if (WC->Err)
+      return;
+    if (!Loaded[I].Reader)
+      continue;
+
+    WC->ErrWhence = Inputs[I].Filename;
+    bool IsIRProfile = Loaded[I].Reader->isIRLevelProfile();
+    if (Error E = WC->Writer.setIsIRLevelProfile(IsIRProfile)) {
       consumeError(std::move(E));
+      WC->Err = make_error<StringError>(
+          "Merge IR generated profile with Clang generated profile.",
+          std::error_code());
       return;
     }
-    Reported = true;
-    Dst->Err = std::move(E);
-  });
+    for (auto &Record : Loaded[I].ShardRecords[Shard])
+      addRecord(std::move(Record), Inputs[I], WC);
+    Loaded[I].ShardRecords[Shard].clear();
+  }
+}
+
+/// Report an error deferred while merging, exiting if it is fatal.
+static void reportDeferredError(Error Err, StringRef Whence) {
+  if (!Err.isA<InstrProfError>())
+    exitWithError(std::move(Err), Whence);
+
+  instrprof_error IPE = InstrProfError::take(std::move(Err));
+  if (isFatalError(IPE))
+    exitWithError(make_error<InstrProfError>(IPE), Whence);
+  else
+    warn("warning: ", toString(make_error<InstrProfError>(IPE)), Whence);
 }
 
 static void mergeInstrProfile(const WeightedFileVector &Inputs,
@@ -260,47 +327,40 @@ static void mergeInstrProfile(const WeightedFileVector &Inputs,
   } else {
     ThreadPool Pool(NumThreads);
 
-    // Load the inputs in parallel (N/NumThreads serial steps).
-    unsigned Ctx = 0;
-    for (const auto &Input : Inputs) {
-      Pool.async(loadInput, Input, Contexts[Ctx].get());
-      Ctx = (Ctx + 1) % NumThreads;
-    }
-    Pool.wait();
-
-    // Merge the writer contexts together (~ lg(NumThreads) serial steps).
-    unsigned Mid = Contexts.size() / 2;
-    unsigned End = Contexts.size();
-    assert(Mid > 0 && "Expected more than one context");
-    do {
-      for (unsigned I = 0; I < Mid; ++I)
-        Pool.async(mergeWriterContexts, Contexts[I].get(),
-                   Contexts[I + Mid].get());
+    // Each context merges the functions whose names hash to its shard, so
+    // the contexts hold disjoint parts of the merged profile and never need
+    // to be merged with each other. The inputs are loaded NumThreads at a
+    // time and split by shard, then each shard merges the batch in input
+    // order, which keeps the result independent of thread scheduling.
+    unsigned NumShards = Contexts.size();
+    for (size_t Begin = 0; Begin < Inputs.size(); Begin += NumThreads) {
+      ArrayRef<WeightedFile> Batch =
+          makeArrayRef(Inputs).slice(Begin).take_front(NumThreads);
+      std::vector<ShardedInput> Loaded(Batch.size());
+      for (unsigned I = 0, E = Batch.size(); I != E; ++I)
+        Pool.async(loadShardedInput, Batch[I], &Loaded[I], NumShards);
       Pool.wait();
-      if (End & 1) {
-        Pool.async(mergeWriterContexts, Contexts[0].get(),
-                   Contexts[End - 1].get());
-        Pool.wait();
-      }
-      End = Mid;
-      Mid /= 2;
-    } while (Mid > 0);
+
+      // Handle deferred hard errors encountered during loading.
+      for (unsigned I = 0, E = Batch.size(); I != E; ++I)
+        if (Loaded[I].Err)
+          reportDeferredError(std::move(Loaded[I].Err), Batch[I].Filename);
+
+      for (unsigned Shard = 0; Shard < NumShards; ++Shard)
+        Pool.async(mergeShard, Batch, MutableArrayRef<ShardedInput>(Loaded),
+                   Shard, Contexts[Shard].get());
+      Pool.wait();
+    }
   }
 
   // Handle deferred hard errors encountered during merging.
-  for (std::unique_ptr<WriterContext> &WC : Contexts) {
-    if (!WC->Err)
-      continue;
-    if (!WC->Err.isA<InstrProfError>())
-      exitWithError(std::move(WC->Err), WC->ErrWhence);
+  for (std::unique_ptr<WriterContext> &WC : Contexts)
+    if (WC->Err)
+      reportDeferredError(std::move(WC->Err), WC->ErrWhence);
 
-    instrprof_error IPE = InstrProfError::take(std::move(WC->Err));
-    if (isFatalError(IPE))
-      exitWithError(make_error<InstrProfError>(IPE), WC->ErrWhence);
-    else
-      warn("warning: ", toString(make_error<InstrProfError>(IPE)),
-           WC->ErrWhence);
-  }
+  // Write the shards out together.
+  for (unsigned I = 1; I < Contexts.size(); ++I)
+    Contexts[0]->Writer.addShard(std::move(Contexts[I]->Writer));
 
   InstrProfWriter &Writer = Contexts[0]->Writer;
   if (OutputFormat == PF_Text) {
@@ -313,7 +373,7 @@ static void mergeInstrProfile(const WeightedFileVector &Inputs,
 
 static sampleprof::SampleProfileFormat FormatMap[] = {
     sampleprof::SPF_None, sampleprof::SPF_Text, sampleprof::SPF_Binary,
-    sampleprof::SPF_GCC};
+    sampleprof::SPF_GCC, sampleprof::SPF_Compact_Binary};
 
 static void mergeSampleProfile(const WeightedFileVector &Inputs,
                                StringRef OutputFilename,
@@ -463,6 +523,9 @@ static int merge_main(int argc, const char *argv[]) {
       cl::desc("Format of output profile"), cl::init(PF_Binary),
       cl::values(clEnumValN(PF_Binary, "binary", "Binary encoding (default)"),
                  clEnumValN(PF_Text, "text", "Text encoding"),
+                 clEnumValN(PF_Compact_Binary, "compbinary",
+                            "Compact binary encoding with MD5 function names "
+                            "(only meaningful for -sample)"),
                  clEnumValN(PF_GCC, "gcc",
                             "GCC encoding (only meaningful for -sample)")));
   cl::opt<bool> OutputSparse("sparse", cl::init(false),
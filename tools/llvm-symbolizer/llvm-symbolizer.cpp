@@ -22,14 +22,17 @@
 #include "llvm/Support/CommandLine.h"
 #include "llvm/Support/Debug.h"
 #include "llvm/Support/FileSystem.h"
+#include "llvm/Support/Format.h"
 #include "llvm/Support/ManagedStatic.h"
 #include "llvm/Support/Path.h"
 #include "llvm/Support/PrettyStackTrace.h"
 #include "llvm/Support/Signals.h"
 #include "llvm/Support/raw_ostream.h"
+#include <chrono>
 #include <cstdio>
 #include <cstring>
 #include <string>
+#include <vector>
 
 using namespace llvm;
 using namespace symbolize;
@@ -92,6 +95,21 @@ static cl::opt<int> ClPrintSourceContextLines(
 static cl::opt<bool> ClVerbose("verbose", cl::init(false),
                                cl::desc("Print verbose line info"));
 
+static cl::opt<unsigned> ClBatchSize(
+    "batch-size", cl::init(0),
+    cl::desc("Read up to N input lines before symbolizing them together, "
+             "grouped by module and on multiple threads (0 = no batching)"));
+
+static cl::opt<unsigned long long> ClCacheSize(
+    "cache-size", cl::init(0),
+    cl::desc("Evict least recently used modules to keep the object files of "
+             "cached modules under N bytes (0 = no limit)"));
+
+static cl::opt<bool>
+    ClPrintStats("print-stats", cl::init(false),
+                 cl::desc("Print throughput and module cache statistics to "
+                          "stderr on exit"));
+
 template<typename T>
 static bool error(Expected<T> &ResOrErr) {
   if (ResOrErr)
@@ -144,6 +162,82 @@ static bool parseCommand(StringRef InputString, bool &IsData,
   return !StringRef(pos, offset_length).getAsInteger(0, ModuleOffset);
 }
 
+template <typename T>
+static void print(DIPrinter &Printer, Expected<T> &ResOrErr) {
+  Printer << (error(ResOrErr) ? T() : ResOrErr.get());
+}
+
+static void printAddress(uint64_t ModuleOffset) {
+  if (ClPrintAddress) {
+    outs() << "0x";
+    outs().write_hex(ModuleOffset);
+    StringRef Delimiter = (ClPrettyPrint == true) ? ": " : "\n";
+    outs() << Delimiter;
+  }
+}
+
+namespace {
+/// An input line and the command parsed from it, if any.
+struct InputCommand {
+  std::string Line;
+  bool IsValid;
+  bool IsData;
+  std::string ModuleName;
+  uint64_t ModuleOffset;
+};
+} // end anonymous namespace
+
+/// Symbolize a batch of input lines at once and print the results in the
+/// order of the input.
+static void symbolizeBatch(LLVMSymbolizer &Symbolizer, DIPrinter &Printer,
+                           ArrayRef<InputCommand> Commands) {
+  std::vector<LLVMSymbolizer::Request> CodeRequests, DataRequests;
+  for (const InputCommand &Cmd : Commands)
+    if (Cmd.IsValid)
+      (Cmd.IsData ? DataRequests : CodeRequests)
+          .push_back({Cmd.ModuleName, Cmd.ModuleOffset});
+
+  std::vector<Expected<DIGlobal>> DataResults =
+      Symbolizer.symbolizeData(DataRequests);
+  std::vector<Expected<DIInliningInfo>> InlinedCodeResults;
+  std::vector<Expected<DILineInfo>> CodeResults;
+  if (ClPrintInlining)
+    InlinedCodeResults = Symbolizer.symbolizeInlinedCode(CodeRequests, ClDwpName);
+  else
+    CodeResults = Symbolizer.symbolizeCode(CodeRequests, ClDwpName);
+
+  size_t NextCode = 0, NextData = 0;
+  for (const InputCommand &Cmd : Commands) {
+    if (!Cmd.IsValid) {
+      outs() << Cmd.Line;
+      continue;
+    }
+    printAddress(Cmd.ModuleOffset);
+    if (Cmd.IsData)
+      print(Printer, DataResults[NextData++]);
+    else if (ClPrintInlining)
+      print(Printer, InlinedCodeResults[NextCode++]);
+    else
+      print(Printer, CodeResults[NextCode++]);
+    outs() << "\n";
+  }
+  outs().flush();
+}
+
+static void printStats(LLVMSymbolizer &Symbolizer, double Seconds) {
+  LLVMSymbolizer::Stats Stats = Symbolizer.getStats();
+  errs() << "Symbolizer statistics:\n"
+         << "  requests:            " << Stats.NumRequests << "\n"
+         << "  module cache hits:   " << Stats.NumCacheHits << "\n"
+         << "  module cache misses: " << Stats.NumCacheMisses << "\n"
+         << "  modules evicted:     " << Stats.NumEvictions << "\n"
+         << "  cache size:          " << Stats.CacheSize << " bytes\n"
+         << "  time:                " << format("%.3f", Seconds) << " s\n"
+         << "  throughput:          "
+         << format("%.1f", Seconds > 0 ? Stats.NumRequests / Seconds : 0.0)
+         << " requests/s\n";
+}
+
 int main(int argc, char **argv) {
   // Print stack trace if we signal out.
   sys::PrintStackTraceOnErrorSignal(argv[0]);
@@ -155,6 +249,7 @@ int main(int argc, char **argv) {
   cl::ParseCommandLineOptions(argc, argv, "llvm-symbolizer\n");
   LLVMSymbolizer::Options Opts(ClPrintFunctions, ClUseSymbolTable, ClDemangle,
                                ClUseRelativeAddress, ClDefaultArch);
+  Opts.MaxCacheSize = ClCacheSize;
 
   for (const auto &hint : ClDsymHint) {
     if (sys::path::extension(hint) == ".dSYM") {
@@ -172,6 +267,8 @@ int main(int argc, char **argv) {
   const int kMaxInputStringLength = 1024;
   char InputString[kMaxInputStringLength];
 
+  auto StartTime = std::chrono::steady_clock::now();
+  std::vector<InputCommand> Batch;
   while (true) {
     if (!fgets(InputString, sizeof(InputString), stdin))
       break;
@@ -179,34 +276,48 @@ int main(int argc, char **argv) {
     bool IsData = false;
     std::string ModuleName;
     uint64_t ModuleOffset = 0;
-    if (!parseCommand(StringRef(InputString), IsData, ModuleName,
-                      ModuleOffset)) {
-      outs() << InputString;
+    bool IsValid = parseCommand(StringRef(InputString), IsData, ModuleName,
+                                ModuleOffset);
+
+    if (ClBatchSize) {
+      Batch.push_back(
+          {InputString, IsValid, IsData, std::move(ModuleName), ModuleOffset});
+      if (Batch.size() == ClBatchSize) {
+        symbolizeBatch(Symbolizer, Printer, Batch);
+        Batch.clear();
+      }
       continue;
     }
 
-    if (ClPrintAddress) {
-      outs() << "0x";
-      outs().write_hex(ModuleOffset);
-      StringRef Delimiter = (ClPrettyPrint == true) ? ": " : "\n";
-      outs() << Delimiter;
+    if (!IsValid) {
+      outs() << InputString;
+      continue;
     }
+
+    printAddress(ModuleOffset);
     if (IsData) {
       auto ResOrErr = Symbolizer.symbolizeData(ModuleName, ModuleOffset);
-      Printer << (error(ResOrErr) ? DIGlobal() : ResOrErr.get());
+      print(Printer, ResOrErr);
     } else if (ClPrintInlining) {
       auto ResOrErr =
           Symbolizer.symbolizeInlinedCode(ModuleName, ModuleOffset, ClDwpName);
-      Printer << (error(ResOrErr) ? DIInliningInfo()
-                                             : ResOrErr.get());
+      print(Printer, ResOrErr);
     } else {
       auto ResOrErr =
           Symbolizer.symbolizeCode(ModuleName, ModuleOffset, ClDwpName);
-      Printer << (error(ResOrErr) ? DILineInfo() : ResOrErr.get());
+      print(Printer, ResOrErr);
     }
     outs() << "\n";
     outs().flush();
   }
+  if (!Batch.empty())
+    symbolizeBatch(Symbolizer, Printer, Batch);
+
+  if (ClPrintStats)
+    printStats(Symbolizer,
+               std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                             StartTime)
+                   .count());
 
   return 0;
 }
@@ -13,7 +13,6 @@
 
 #include <algorithm>
 #include <cassert>
-#include <numeric>
 #include <system_error>
 #include <utility>
 
@@ -27,7 +26,10 @@
 using namespace llvm;
 using namespace llvm::xray;
 
-static cl::SubCommand Account("account", "Function call accounting");
+static cl::SubCommand
+    Account("account",
+            "Function call accounting (the median and percentile durations "
+            "of frequently called functions are sampled estimates)");
 static cl::opt<std::string> AccountInput(cl::Positional,
                                          cl::desc("<xray log file>"),
                                          cl::Required, cl::sub(Account));
@@ -82,9 +84,12 @@ static cl::opt<SortField> AccountSortOutput(
     cl::values(clEnumValN(SortField::FUNCID, "funcid", "function id"),
                clEnumValN(SortField::COUNT, "count", "funciton call counts"),
                clEnumValN(SortField::MIN, "min", "minimum function durations"),
-               clEnumValN(SortField::MED, "med", "median function durations"),
-               clEnumValN(SortField::PCT90, "90p", "90th percentile durations"),
-               clEnumValN(SortField::PCT99, "99p", "99th percentile durations"),
+               clEnumValN(SortField::MED, "med",
+                          "median durations (sampled for frequent calls)"),
+               clEnumValN(SortField::PCT90, "90p",
+                          "90th percentile (sampled for frequent calls)"),
+               clEnumValN(SortField::PCT99, "99p",
+                          "99th percentile (sampled for frequent calls)"),
                clEnumValN(SortField::MAX, "max", "maximum function durations"),
                clEnumValN(SortField::SUM, "sum", "sum of call durations"),
                clEnumValN(SortField::FUNC, "func", "function names")));
@@ -230,13 +235,13 @@ struct ResultRow {
   std::string Function;
 };
 
-ResultRow getStats(std::vector<uint64_t> &Timings) {
-  assert(!Timings.empty());
+ResultRow getStats(const LatencySummary &Latencies) {
+  assert(Latencies.Count != 0);
   ResultRow R;
-  R.Sum = std::accumulate(Timings.begin(), Timings.end(), 0.0);
-  auto MinMax = std::minmax_element(Timings.begin(), Timings.end());
-  R.Min = *MinMax.first;
-  R.Max = *MinMax.second;
+  R.Sum = Latencies.Sum;
+  R.Min = Latencies.Min;
+  R.Max = Latencies.Max;
+  std::vector<uint64_t> Timings = Latencies.Samples;
   auto MedianOff = Timings.size() / 2;
   std::nth_element(Timings.begin(), Timings.begin() + MedianOff, Timings.end());
   R.Median = Timings[MedianOff];
@@ -246,7 +251,7 @@ ResultRow getStats(std::vector<uint64_t> &Timings) {
   auto Pct99Off = std::floor(Timings.size() * 0.99);
   std::nth_element(Timings.begin(), Timings.begin() + Pct90Off, Timings.end());
   R.Pct99 = Timings[Pct99Off];
-  R.Count = Timings.size();
+  R.Count = Latencies.Count;
   return R;
 }
 
@@ -257,10 +262,10 @@ void LatencyAccountant::exportStats(const XRayFileHeader &Header, F Fn) const {
   using TupleType = std::tuple<int32_t, uint64_t, ResultRow>;
   std::vector<TupleType> Results;
   Results.reserve(FunctionLatencies.size());
-  for (auto FT : FunctionLatencies) {
+  for (const auto &FT : FunctionLatencies) {
     const auto &FuncId = FT.first;
-    auto &Timings = FT.second;
-    Results.emplace_back(FuncId, Timings.size(), getStats(Timings));
+    const auto &Latencies = FT.second;
+    Results.emplace_back(FuncId, Latencies.Count, getStats(Latencies));
     auto &Row = std::get<2>(Results.back());
     if (Header.CycleFrequency) {
       double CycleFrequency = Header.CycleFrequency;
@@ -458,16 +463,20 @@ static CommandRegistration Unused(&Account, []() -> Error {
   llvm::xray::FuncIdConversionHelper FuncIdHelper(AccountInstrMap, Symbolizer,
                                                   FunctionAddresses);
   xray::LatencyAccountant FCA(FuncIdHelper, AccountDeduceSiblingCalls);
-  auto TraceOrErr = loadTraceFile(AccountInput);
-  if (!TraceOrErr)
+  auto ReaderOrErr = TraceReader::create(AccountInput);
+  if (!ReaderOrErr)
     return joinErrors(
         make_error<StringError>(
             Twine("Failed loading input file '") + AccountInput + "'",
             std::make_error_code(std::errc::executable_format_error)),
-        TraceOrErr.takeError());
-
-  auto &T = *TraceOrErr;
-  for (const auto &Record : T) {
+        ReaderOrErr.takeError());
+
+  // Stream the records through the accountant rather than loading the whole
+  // trace, so that only the per-thread stacks and per-function latencies are
+  // kept in memory.
+  auto &Reader = **ReaderOrErr;
+  Error Err = Error::success();
+  for (const auto &Record : Reader.records(Err)) {
     if (FCA.accountRecord(Record))
       continue;
     errs()
@@ -488,18 +497,27 @@ static CommandRegistration Unused(&Account, []() -> Error {
         errs() << "  #" << Level-- << "\t"
                << FuncIdHelper.SymbolOrNumber(Entry.first) << '\n';
     }
-    if (!AccountKeepGoing)
+    if (!AccountKeepGoing) {
+      consumeError(std::move(Err));
       return make_error<StringError>(
           Twine("Failed accounting function calls in file '") + AccountInput +
               "'.",
           std::make_error_code(std::errc::executable_format_error));
+    }
   }
+  if (Err)
+    return joinErrors(
+        make_error<StringError>(
+            Twine("Failed loading input file '") + AccountInput + "'",
+            std::make_error_code(std::errc::executable_format_error)),
+        std::move(Err));
+
   switch (AccountOutputFormat) {
   case AccountOutputFormats::TEXT:
-    FCA.exportStatsAsText(OS, T.getFileHeader());
+    FCA.exportStatsAsText(OS, Reader.getFileHeader());
     break;
   case AccountOutputFormats::CSV:
-    FCA.exportStatsAsCSV(OS, T.getFileHeader());
+    FCA.exportStatsAsCSV(OS, Reader.getFileHeader());
     break;
   }
 
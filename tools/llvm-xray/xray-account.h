@@ -14,7 +14,10 @@
 #ifndef LLVM_TOOLS_LLVM_XRAY_XRAY_ACCOUNT_H
 #define LLVM_TOOLS_LLVM_XRAY_XRAY_ACCOUNT_H
 
+#include <algorithm>
+#include <limits>
 #include <map>
+#include <random>
 #include <utility>
 #include <vector>
 
@@ -26,9 +29,40 @@
 namespace llvm {
 namespace xray {
 
+/// The latencies recorded for one function. The count, extrema and sum are
+/// exact. The percentiles are computed from a uniform sample of at most
+/// MaxSamples latencies, which holds every latency of functions called fewer
+/// times than that, so memory grows with the number of functions rather than
+/// with the length of the trace.
+struct LatencySummary {
+  static constexpr size_t MaxSamples = 1 << 12;
+
+  uint64_t Count = 0;
+  uint64_t Min = std::numeric_limits<uint64_t>::max();
+  uint64_t Max = 0;
+  double Sum = 0;
+  std::vector<uint64_t> Samples;
+
+  template <class RNG> void record(uint64_t Latency, RNG &Gen) {
+    ++Count;
+    Min = std::min(Min, Latency);
+    Max = std::max(Max, Latency);
+    Sum += Latency;
+    if (Samples.size() < MaxSamples) {
+      Samples.push_back(Latency);
+      return;
+    }
+    // Reservoir sampling: keep this latency with probability
+    // MaxSamples / Count.
+    uint64_t Slot = std::uniform_int_distribution<uint64_t>(0, Count - 1)(Gen);
+    if (Slot < MaxSamples)
+      Samples[Slot] = Latency;
+  }
+};
+
 class LatencyAccountant {
 public:
-  typedef std::map<int32_t, std::vector<uint64_t>> FunctionLatencyMap;
+  typedef std::map<int32_t, LatencySummary> FunctionLatencyMap;
   typedef std::map<llvm::sys::ProcessInfo::ProcessId,
                    std::pair<uint64_t, uint64_t>>
       PerThreadMinMaxTSCMap;
@@ -47,8 +81,11 @@ private:
   bool DeduceSiblingCalls = false;
   uint64_t CurrentMaxTSC = 0;
 
+  // Fixed seed, so that reports are reproducible.
+  std::minstd_rand SampleGen;
+
   void recordLatency(int32_t FuncId, uint64_t Latency) {
-    FunctionLatencies[FuncId].push_back(Latency);
+    FunctionLatencies[FuncId].record(Latency, SampleGen);
   }
 
 public:
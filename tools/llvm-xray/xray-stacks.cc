@@ -726,30 +726,44 @@ static CommandRegistration Unused(&Stack, []() -> Error {
   // TODO: Someday, support output to files instead of just directly to
   // standard output.
   for (const auto &Filename : StackInputs) {
-    auto TraceOrErr = loadTraceFile(Filename);
-    if (!TraceOrErr) {
+    auto ReaderOrErr = TraceReader::create(Filename);
+    if (!ReaderOrErr) {
       if (!StackKeepGoing)
         return joinErrors(
             make_error<StringError>(
                 Twine("Failed loading input file '") + Filename + "'",
                 std::make_error_code(std::errc::invalid_argument)),
-            TraceOrErr.takeError());
-      logAllUnhandledErrors(TraceOrErr.takeError(), errs(), "");
+            ReaderOrErr.takeError());
+      logAllUnhandledErrors(ReaderOrErr.takeError(), errs(), "");
       continue;
     }
-    auto &T = *TraceOrErr;
+    // The trie only grows with the number of distinct stacks, so stream the
+    // records into it instead of loading the whole trace first.
+    auto &Reader = **ReaderOrErr;
     StackTrie::AccountRecordState AccountRecordState =
         StackTrie::AccountRecordState::CreateInitialState();
-    for (const auto &Record : T) {
+    Error Err = Error::success();
+    for (const auto &Record : Reader.records(Err)) {
       auto error = ST.accountRecord(Record, &AccountRecordState);
       if (error != StackTrie::AccountRecordStatus::OK) {
-        if (!StackKeepGoing)
+        if (!StackKeepGoing) {
+          consumeError(std::move(Err));
           return make_error<StringError>(
               CreateErrorMessage(error, Record, FuncIdHelper),
               make_error_code(errc::illegal_byte_sequence));
+        }
         errs() << CreateErrorMessage(error, Record, FuncIdHelper);
       }
     }
+    if (Err) {
+      if (!StackKeepGoing)
+        return joinErrors(
+            make_error<StringError>(
+                Twine("Failed loading input file '") + Filename + "'",
+                std::make_error_code(std::errc::invalid_argument)),
+            std::move(Err));
+      logAllUnhandledErrors(std::move(Err), errs(), "");
+    }
   }
   if (ST.isEmpty()) {
     return make_error<StringError>(
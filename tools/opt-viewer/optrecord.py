@@ -263,13 +263,93 @@ class Missed(Remark):
         return "red"
 
 
+# The remark classes in the order of the remark types of the binary remark
+# format (see llvm/IR/BinaryRemarks.h).  Failures are not shown, as they have
+# no class to be read from YAML either.
+binary_remark_classes = [Passed, Missed, Analysis, AnalysisFPCommute,
+                         AnalysisAliasing, None]
+binary_remarks_magic = b'RMRK'
+
+
+def read_binary_remarks(data):
+    data = bytearray(data)
+    pos = [len(binary_remarks_magic)]
+    strings = []
+
+    def byte():
+        pos[0] += 1
+        return data[pos[0] - 1]
+
+    def uleb128():
+        value = 0
+        shift = 0
+        while True:
+            b = byte()
+            value |= (b & 0x7f) << shift
+            shift += 7
+            if b < 0x80:
+                return value
+
+    def string():
+        return strings[uleb128()]
+
+    def location():
+        file = uleb128()
+        if file == 0:
+            return None
+        line = uleb128()
+        column = uleb128()
+        return {'File': strings[file - 1], 'Line': line, 'Column': column}
+
+    if uleb128() != 1:
+        raise ValueError('unsupported binary remarks version')
+    while pos[0] < len(data):
+        tag = byte()
+        if tag == 1:
+            size = uleb128()
+            s = bytes(data[pos[0]:pos[0] + size])
+            if not isinstance(s, str):
+                # Python 3
+                s = s.decode('utf-8')
+            strings.append(s)
+            pos[0] += size
+        elif tag == 2:
+            cls = binary_remark_classes[uleb128()]
+            fields = dict(Pass=string(), Name=string(), Function=string())
+            loc = location()
+            if loc:
+                fields['DebugLoc'] = loc
+            if byte():
+                fields['Hotness'] = uleb128()
+            fields['Args'] = []
+            for _ in range(uleb128()):
+                arg = {string(): string()}
+                loc = location()
+                if loc:
+                    arg['DebugLoc'] = loc
+                fields['Args'].append(arg)
+            if cls:
+                remark = cls.__new__(cls)
+                remark.__dict__.update(fields)
+                yield remark
+        else:
+            raise ValueError('unknown binary remarks record {}'.format(tag))
+
+
+def load_remarks(f):
+    data = f.read()
+    if data.startswith(binary_remarks_magic):
+        return read_binary_remarks(data)
+    return yaml.load_all(data, Loader=Loader)
+
+
 def get_remarks(input_file):
     max_hotness = 0
     all_remarks = dict()
     file_remarks = defaultdict(functools.partial(defaultdict, list))
 
-    with open(input_file) as f:
-        docs = yaml.load_all(f, Loader=Loader)
+    with open(input_file, 'rb') as f:
+        docs = load_remarks(f)
         for remark in docs:
             remark.canonicalize()
             # Avoid remarks withoug debug location or if they are duplicated
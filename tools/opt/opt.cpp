@@ -25,6 +25,7 @@
 #include "llvm/Bitcode/BitcodeWriterPass.h"
 #include "llvm/CodeGen/CommandFlags.def"
 #include "llvm/CodeGen/TargetPassConfig.h"
+#include "llvm/IR/BinaryRemarks.h"
 #include "llvm/IR/DataLayout.h"
 #include "llvm/IR/DebugInfo.h"
 #include "llvm/IR/IRPrintingPasses.h"
@@ -49,6 +50,7 @@
 #include "llvm/Support/SystemUtils.h"
 #include "llvm/Support/TargetRegistry.h"
 #include "llvm/Support/TargetSelect.h"
+#include "llvm/Support/TimeProfiler.h"
 #include "llvm/Support/ToolOutputFile.h"
 #include "llvm/Support/YAMLTraits.h"
 #include "llvm/Target/TargetMachine.h"
@@ -249,9 +251,43 @@ static cl::opt<unsigned> PassRemarksHotnessThreshold(
 
 static cl::opt<std::string>
     RemarksFilename("pass-remarks-output",
-                    cl::desc("YAML output filename for pass remarks"),
+                    cl::desc("Output filename for pass remarks"),
                     cl::value_desc("filename"));
 
+static cl::opt<std::string>
+    RemarksFormat("pass-remarks-format",
+                  cl::desc("The format of the pass remarks output file: yaml "
+                           "or binary (default: yaml)"),
+                  cl::value_desc("format"), cl::init("yaml"));
+
+static cl::opt<bool>
+    TimeTrace("time-trace",
+              cl::desc("Record the time spent in passes in a Chrome trace"));
+
+static cl::opt<unsigned> TimeTraceGranularity(
+    "time-trace-granularity",
+    cl::desc(
+        "Minimum time granularity (in microseconds) traced by time profiler"),
+    cl::init(500));
+
+static cl::opt<std::string>
+    TimeTraceFile("time-trace-file",
+                  cl::desc("Specify time trace file destination"),
+                  cl::value_desc("filename"));
+
+/// Writes the time trace, if one was requested, and returns false on error.
+static bool writeTimeTrace(const char *Argv0) {
+  if (!TimeTrace)
+    return true;
+  Error E = timeTraceProfilerWrite(TimeTraceFile, InputFilename);
+  timeTraceProfilerCleanup();
+  if (E) {
+    logAllUnhandledErrors(std::move(E), errs(), Twine(Argv0) + ": ");
+    return false;
+  }
+  return true;
+}
+
 static inline void addPass(legacy::PassManagerBase &PM, Pass *P) {
   // Add the pass to the pass manager...
   PM.add(P);
@@ -421,6 +457,9 @@ int main(int argc, char **argv) {
     return 1;
   }
 
+  if (TimeTrace)
+    timeTraceProfilerInitialize(TimeTraceGranularity, argv[0]);
+
   SMDiagnostic Err;
 
   Context.setDiscardValueNames(DiscardValueNames);
@@ -435,6 +474,11 @@ int main(int argc, char **argv) {
 
   std::unique_ptr<ToolOutputFile> OptRemarkFile;
   if (RemarksFilename != "") {
+    if (RemarksFormat != "yaml" && RemarksFormat != "binary") {
+      errs() << argv[0] << ": unknown remarks format '" << RemarksFormat
+             << "'\n";
+      return 1;
+    }
     std::error_code EC;
     OptRemarkFile =
         llvm::make_unique<ToolOutputFile>(RemarksFilename, EC, sys::fs::F_None);
@@ -442,8 +486,12 @@ int main(int argc, char **argv) {
       errs() << EC.message() << '\n';
       return 1;
     }
-    Context.setDiagnosticsOutputFile(
-        llvm::make_unique<yaml::Output>(OptRemarkFile->os()));
+    if (RemarksFormat == "binary")
+      Context.setDiagnosticsBinaryOutputFile(
+          llvm::make_unique<BinaryRemarkWriter>(OptRemarkFile->os()));
+    else
+      Context.setDiagnosticsOutputFile(
+          llvm::make_unique<yaml::Output>(OptRemarkFile->os()));
   }
 
   // Load the input module...
@@ -543,13 +591,13 @@ int main(int argc, char **argv) {
     // The user has asked to use the new pass manager and provided a pipeline
     // string. Hand off the rest of the functionality to the new code for that
     // layer.
-    return runPassPipeline(argv[0], *M, TM.get(), Out.get(), ThinLinkOut.get(),
-                           OptRemarkFile.get(), PassPipeline, OK, VK,
-                           PreserveAssemblyUseListOrder,
-                           PreserveBitcodeUseListOrder, EmitSummaryIndex,
-                           EmitModuleHash)
-               ? 0
-               : 1;
+    if (!runPassPipeline(argv[0], *M, TM.get(), Out.get(), ThinLinkOut.get(),
+                         OptRemarkFile.get(), PassPipeline, OK, VK,
+                         PreserveAssemblyUseListOrder,
+                         PreserveBitcodeUseListOrder, EmitSummaryIndex,
+                         EmitModuleHash))
+      return 1;
+    return writeTimeTrace(argv[0]) ? 0 : 1;
   }
 
   // Create a PassManager to hold and optimize the collection of passes we are
@@ -779,6 +827,9 @@ int main(int argc, char **argv) {
     Out->os() << BOS->str();
   }
 
+  if (!writeTimeTrace(argv[0]))
+    return 1;
+
   // Declare success.
   if (!NoOutput || PrintBreakpoints)
     Out->keep();
@@ -30,6 +30,7 @@
 #include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/TargetRegistry.h"
 #include "llvm/Support/TargetSelect.h"
+#include "llvm/Support/raw_ostream.h"
 #include "llvm/Testing/Support/Error.h"
 #include "gtest/gtest.h"
 #include <string>
@@ -1371,6 +1372,82 @@ TEST(DWARFDebugInfo, TestFindRecurse) {
   EXPECT_EQ(AbsDieName, StringOpt.getValueOr(nullptr));
 }
 
+TEST(DWARFDebugInfo, TestLazyDIEExtraction) {
+  Triple Triple = getHostTripleForAddrSize(sizeof(void *));
+  if (!isConfigurationSupported(Triple))
+    return;
+
+  uint16_t Version = 4;
+  auto ExpectedDG = dwarfgen::Generator::create(Triple, Version);
+  ASSERT_THAT_EXPECTED(ExpectedDG, Succeeded());
+  dwarfgen::Generator *DG = ExpectedDG.get().get();
+  dwarfgen::CompileUnit &CU = DG->addCompileUnit();
+  {
+    auto CUDie = CU.getUnitDIE();
+    auto InlDie = CUDie.addChild(DW_TAG_subprogram);
+    InlDie.addAttribute(DW_AT_name, DW_FORM_strp, "inl");
+    auto NSDie = CUDie.addChild(DW_TAG_namespace);
+    NSDie.addAttribute(DW_AT_name, DW_FORM_strp, "ns");
+    auto FDie = NSDie.addChild(DW_TAG_subprogram);
+    FDie.addAttribute(DW_AT_name, DW_FORM_strp, "f");
+    FDie.addAttribute(DW_AT_low_pc, DW_FORM_addr, 0x1000U);
+    FDie.addAttribute(DW_AT_high_pc, DW_FORM_addr, 0x1100U);
+    auto InlinedDie = FDie.addChild(DW_TAG_inlined_subroutine);
+    InlinedDie.addAttribute(DW_AT_abstract_origin, DW_FORM_ref4, InlDie);
+    InlinedDie.addAttribute(DW_AT_low_pc, DW_FORM_addr, 0x1010U);
+    InlinedDie.addAttribute(DW_AT_high_pc, DW_FORM_addr, 0x1020U);
+    auto GDie = CUDie.addChild(DW_TAG_subprogram);
+    GDie.addAttribute(DW_AT_name, DW_FORM_strp, "g");
+    GDie.addAttribute(DW_AT_low_pc, DW_FORM_addr, 0x2000U);
+    GDie.addAttribute(DW_AT_high_pc, DW_FORM_addr, 0x2100U);
+  }
+
+  MemoryBufferRef FileBuffer(DG->generate(), "dwarf");
+  auto Obj = object::ObjectFile::createObjectFile(FileBuffer);
+  EXPECT_TRUE((bool)Obj);
+  std::unique_ptr<DWARFContext> DwarfContext = DWARFContext::create(**Obj);
+  DwarfContext->setLazyDIEExtraction(true);
+  DWARFCompileUnit *U = DwarfContext->getCompileUnitAtIndex(0);
+
+  // Looking up an address only extracts the subtree of the namespace, and
+  // parents are found within it.
+  DWARFDie InlinedDie = U->getSubroutineForAddress(0x1015);
+  ASSERT_TRUE(InlinedDie.isValid());
+  EXPECT_EQ(DW_TAG_inlined_subroutine, InlinedDie.getTag());
+  EXPECT_STREQ("inl", InlinedDie.getSubroutineName(DINameKind::ShortName));
+  DWARFDie FDie = InlinedDie.getParent();
+  EXPECT_STREQ("f", FDie.getName(DINameKind::ShortName));
+  DWARFDie NSDie = FDie.getParent();
+  EXPECT_EQ(DW_TAG_namespace, NSDie.getTag());
+  EXPECT_EQ(U->getUnitDIE(), NSDie.getParent());
+
+  SmallVector<DWARFDie, 4> InlinedChain;
+  U->getInlinedChainForAddress(0x1030, InlinedChain);
+  ASSERT_EQ(1u, InlinedChain.size());
+  EXPECT_EQ(FDie, InlinedChain[0]);
+
+  DWARFDie GDie = U->getSubroutineForAddress(0x2050);
+  EXPECT_STREQ("g", GDie.getName(DINameKind::ShortName));
+  EXPECT_FALSE(U->getSubroutineForAddress(0x3000).isValid());
+  EXPECT_EQ(GDie, U->getDIEForOffset(GDie.getOffset()));
+  EXPECT_FALSE(U->getDIEForOffset(GDie.getOffset() + 1).isValid());
+
+  // Walking the children of the unit DIE extracts the other subtrees.
+  std::vector<dwarf::Tag> Tags;
+  for (DWARFDie Child : U->getUnitDIE().children())
+    Tags.push_back(Child.getTag());
+  EXPECT_EQ((std::vector<dwarf::Tag>{DW_TAG_subprogram, DW_TAG_namespace,
+                                     DW_TAG_subprogram}),
+            Tags);
+  EXPECT_EQ(NSDie, U->getUnitDIE().getFirstChild().getSibling());
+
+  DWARFAddressRangesVector Ranges;
+  U->collectAddressRanges(Ranges);
+  ASSERT_EQ(2u, Ranges.size());
+  EXPECT_EQ(0x1000U, Ranges[0].LowPC);
+  EXPECT_EQ(0x2100U, Ranges[1].HighPC);
+}
+
 TEST(DWARFDebugInfo, TestDwarfToFunctions) {
   // Test all of the dwarf::toXXX functions that take a
   // Optional<DWARFFormValue> and extract the values from it.
@@ -3012,4 +3089,114 @@ TEST(DWARFDebugInfo, TestDWARFDieRangeInfoIntersects) {
   AssertRangesDontIntersect(Ranges, {{0x40, 0x41}});
 }
 
+TEST(DWARFDebugInfo, TestParallelUnitParsing) {
+  // Create three compile units, each with a single function and no address
+  // ranges on the unit DIE, so that the address ranges of the units have to
+  // be collected from their DIEs. The units are parsed on multiple threads
+  // when the aranges are built and when .debug_info is dumped; the results
+  // must match parsing the units lazily.
+  StringRef yamldata = R"(
+    debug_str:
+      - ''
+      - /tmp/main.c
+    debug_abbrev:
+      - Code:            0x00000001
+        Tag:             DW_TAG_compile_unit
+        Children:        DW_CHILDREN_yes
+        Attributes:
+          - Attribute:       DW_AT_name
+            Form:            DW_FORM_strp
+      - Code:            0x00000002
+        Tag:             DW_TAG_subprogram
+        Children:        DW_CHILDREN_no
+        Attributes:
+          - Attribute:       DW_AT_low_pc
+            Form:            DW_FORM_addr
+          - Attribute:       DW_AT_high_pc
+            Form:            DW_FORM_addr
+    debug_info:
+      - Length:
+          TotalLength:     30
+        Version:         4
+        AbbrOffset:      0
+        AddrSize:        8
+        Entries:
+          - AbbrCode:        0x00000001
+            Values:
+              - Value:           0x0000000000000001
+          - AbbrCode:        0x00000002
+            Values:
+              - Value:           0x0000000000001000
+              - Value:           0x0000000000002000
+          - AbbrCode:        0x00000000
+            Values:
+      - Length:
+          TotalLength:     30
+        Version:         4
+        AbbrOffset:      0
+        AddrSize:        8
+        Entries:
+          - AbbrCode:        0x00000001
+            Values:
+              - Value:           0x0000000000000001
+          - AbbrCode:        0x00000002
+            Values:
+              - Value:           0x0000000000003000
+              - Value:           0x0000000000004000
+          - AbbrCode:        0x00000000
+            Values:
+      - Length:
+          TotalLength:     30
+        Version:         4
+        AbbrOffset:      0
+        AddrSize:        8
+        Entries:
+          - AbbrCode:        0x00000001
+            Values:
+              - Value:           0x0000000000000001
+          - AbbrCode:        0x00000002
+            Values:
+              - Value:           0x0000000000002000
+              - Value:           0x0000000000003000
+          - AbbrCode:        0x00000000
+            Values:
+  )";
+  auto ErrOrSections = DWARFYAML::EmitDebugSections(yamldata);
+  ASSERT_TRUE((bool)ErrOrSections);
+  std::unique_ptr<DWARFContext> DwarfContext =
+      DWARFContext::create(*ErrOrSections, 8);
+  ASSERT_EQ(3u, DwarfContext->getNumCompileUnits());
+
+  auto getCUOffset = [&](uint64_t Address) -> Optional<uint32_t> {
+    if (auto *CU = DwarfContext->getDIEsForAddress(Address).CompileUnit)
+      return CU->getOffset();
+    return None;
+  };
+  EXPECT_EQ(0u, getCUOffset(0x1000));
+  EXPECT_EQ(0u, getCUOffset(0x1fff));
+  EXPECT_EQ(68u, getCUOffset(0x2000));
+  EXPECT_EQ(34u, getCUOffset(0x3000));
+  EXPECT_EQ(34u, getCUOffset(0x3fff));
+  EXPECT_EQ(None, getCUOffset(0x4000));
+  EXPECT_EQ(None, getCUOffset(0x500));
+
+  // Dumping .debug_info extracts the DIEs of all units in parallel.
+  DIDumpOptions DumpOpts;
+  DumpOpts.DumpType = DIDT_DebugInfo;
+  DwarfContext->dump(nulls(), DumpOpts);
+  std::unique_ptr<DWARFContext> LazyContext =
+      DWARFContext::create(*ErrOrSections, 8);
+  for (unsigned I = 0; I < 3; ++I) {
+    DWARFCompileUnit *CU = DwarfContext->getCompileUnitAtIndex(I);
+    DWARFCompileUnit *LazyCU = LazyContext->getCompileUnitAtIndex(I);
+    ASSERT_EQ(LazyCU->getNumDIEs(), CU->getNumDIEs());
+    for (unsigned J = 0, E = CU->getNumDIEs(); J < E; ++J) {
+      EXPECT_EQ(LazyCU->getDIEAtIndex(J).getOffset(),
+                CU->getDIEAtIndex(J).getOffset());
+      EXPECT_EQ(LazyCU->getDIEAtIndex(J).getTag(),
+                CU->getDIEAtIndex(J).getTag());
+    }
+  }
+}
+
 } // end anonymous namespace
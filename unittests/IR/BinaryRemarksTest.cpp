@@ -0,0 +1,112 @@
+//===- BinaryRemarksTest.cpp - Binary optimization remark unit tests ------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/IR/BinaryRemarks.h"
+#include "llvm/AsmParser/Parser.h"
+#include "llvm/IR/DiagnosticInfo.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/IR/LLVMContext.h"
+#include "llvm/IR/Module.h"
+#include "llvm/Support/SourceMgr.h"
+#include "llvm/Support/raw_ostream.h"
+#include "gtest/gtest.h"
+
+using namespace llvm;
+
+namespace {
+
+static const char ModuleStr[] = R"(
+define void @"\01foo"() !dbg !4 {
+  ret void, !dbg !7
+}
+
+!llvm.dbg.cu = !{!0}
+!llvm.module.flags = !{!3}
+
+!0 = distinct !DICompileUnit(language: DW_LANG_C99, file: !1, emissionKind: FullDebug)
+!1 = !DIFile(filename: "t.c", directory: "/")
+!3 = !{i32 2, !"Debug Info Version", i32 3}
+!4 = distinct !DISubprogram(name: "foo", scope: !1, file: !1, line: 2, type: !5, scopeLine: 2, unit: !0)
+!5 = !DISubroutineType(types: !6)
+!6 = !{null}
+!7 = !DILocation(line: 3, column: 5, scope: !4)
+)";
+
+TEST(BinaryRemarksTest, RoundTrip) {
+  LLVMContext Context;
+  SMDiagnostic Err;
+  std::unique_ptr<Module> M = parseAssemblyString(ModuleStr, Err, Context);
+  ASSERT_TRUE(M);
+  Function *F = M->getFunction("\01foo");
+  const Instruction *Ret = &F->getEntryBlock().front();
+
+  std::string Buffer;
+  raw_string_ostream OS(Buffer);
+  Context.setDiagnosticsBinaryOutputFile(
+      llvm::make_unique<BinaryRemarkWriter>(OS));
+  EXPECT_TRUE(Context.hasDiagnosticsOutputFile());
+
+  OptimizationRemark Passed("loop-unroll", "FullyUnrolled", Ret);
+  using Argument = DiagnosticInfoOptimizationBase::Argument;
+  Passed << "unrolled " << Argument("UnrollCount", 4u) << " times"
+         << DiagnosticInfoOptimizationBase::setExtraArgs()
+         << Argument("Callee", F);
+  Passed.setHotness(100);
+  Context.diagnose(Passed);
+  OptimizationRemarkMissed Missed("loop-unroll", "Unroll", Ret);
+  Missed << "not unrolled";
+  Context.diagnose(Missed);
+  OS.flush();
+
+  ASSERT_TRUE(isBinaryRemarks(Buffer));
+  std::vector<Remark> Remarks;
+  Error E = readBinaryRemarks(
+      Buffer, [&](const Remark &R) { Remarks.push_back(R); });
+  ASSERT_FALSE(!!E);
+  ASSERT_EQ(2u, Remarks.size());
+
+  const Remark &R = Remarks[0];
+  EXPECT_EQ(RemarkType::Passed, R.Type);
+  EXPECT_EQ("loop-unroll", R.PassName);
+  EXPECT_EQ("FullyUnrolled", R.RemarkName);
+  EXPECT_EQ("foo", R.FunctionName);
+  ASSERT_TRUE(R.Loc.hasValue());
+  EXPECT_EQ("t.c", R.Loc->File);
+  EXPECT_EQ(3u, R.Loc->Line);
+  EXPECT_EQ(5u, R.Loc->Column);
+  ASSERT_TRUE(R.Hotness.hasValue());
+  EXPECT_EQ(100u, *R.Hotness);
+  ASSERT_EQ(4u, R.Args.size());
+  EXPECT_EQ("String", R.Args[0].Key);
+  EXPECT_EQ("unrolled ", R.Args[0].Val);
+  EXPECT_EQ("UnrollCount", R.Args[1].Key);
+  EXPECT_EQ("4", R.Args[1].Val);
+  EXPECT_FALSE(R.Args[1].Loc.hasValue());
+  EXPECT_EQ("Callee", R.Args[3].Key);
+  EXPECT_EQ("foo", R.Args[3].Val);
+  ASSERT_TRUE(R.Args[3].Loc.hasValue());
+  EXPECT_EQ(2u, R.Args[3].Loc->Line);
+
+  EXPECT_EQ(RemarkType::Missed, Remarks[1].Type);
+  EXPECT_EQ("Unroll", Remarks[1].RemarkName);
+  EXPECT_FALSE(Remarks[1].Hotness.hasValue());
+  ASSERT_EQ(1u, Remarks[1].Args.size());
+  EXPECT_EQ("not unrolled", Remarks[1].Args[0].Val);
+
+  // Truncated files and unknown records are diagnosed.
+  E = readBinaryRemarks(Buffer.substr(0, Buffer.size() - 1),
+                        [](const Remark &) {});
+  EXPECT_TRUE(!!E);
+  consumeError(std::move(E));
+  E = readBinaryRemarks("RMRK\x01\x03", [](const Remark &) {});
+  EXPECT_TRUE(!!E);
+  consumeError(std::move(E));
+}
+
+} // end anonymous namespace
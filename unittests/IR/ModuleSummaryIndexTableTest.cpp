@@ -0,0 +1,236 @@
+//===- ModuleSummaryIndexTableTest.cpp - Summary table unit tests ---------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/IR/ModuleSummaryIndexTable.h"
+#include "llvm/Support/Endian.h"
+#include "llvm/Support/raw_ostream.h"
+#include "gtest/gtest.h"
+
+using namespace llvm;
+
+namespace {
+
+static std::unique_ptr<FunctionSummary>
+makeFunction(GlobalValue::LinkageTypes Linkage, unsigned InstCount,
+             std::vector<ValueInfo> Refs,
+             std::vector<FunctionSummary::EdgeTy> Calls) {
+  FunctionSummary::FFlags FFlags = {};
+  FFlags.NoRecurse = true;
+  return llvm::make_unique<FunctionSummary>(
+      GlobalValueSummary::GVFlags(Linkage, false, true, false), InstCount,
+      FFlags, std::move(Refs), std::move(Calls),
+      std::vector<GlobalValue::GUID>{42},
+      std::vector<FunctionSummary::VFuncId>{},
+      std::vector<FunctionSummary::VFuncId>{},
+      std::vector<FunctionSummary::ConstVCall>{},
+      std::vector<FunctionSummary::ConstVCall>{{{7, 8}, {1, 2, 3}}});
+}
+
+class SummaryTableTest : public testing::Test {
+protected:
+  ModuleSummaryIndex Index;
+  StringRef PathA, PathB;
+  GlobalValue::GUID Foo, Bar, Var, Alias, Ext;
+  std::string Table;
+
+  void SetUp() override {
+    PathA = Index.addModule("a.o", 1, {{1, 2, 3, 4, 5}})->first();
+    PathB = Index.addModule("b.o", 2)->first();
+    Foo = GlobalValue::getGUID("foo");
+    Bar = GlobalValue::getGUID("bar");
+    Var = GlobalValue::getGUID("var");
+    Alias = GlobalValue::getGUID("alias");
+    Ext = GlobalValue::getGUID("ext");
+
+    // a.o defines foo, which calls bar from b.o and the external ext.
+    auto FooS = makeFunction(
+        GlobalValue::ExternalLinkage, 10, {},
+        {{Index.getOrInsertValueInfo(Bar),
+          CalleeInfo(CalleeInfo::HotnessType::Hot)},
+         {Index.getOrInsertValueInfo(Ext),
+          CalleeInfo(CalleeInfo::HotnessType::Cold)}});
+    FooS->setModulePath(PathA);
+    Index.addGlobalValueSummary(Index.getOrInsertValueInfo(Foo),
+                                std::move(FooS));
+
+    // b.o defines bar, which refers to var, and an alias to bar.
+    auto BarS = makeFunction(GlobalValue::InternalLinkage, 3,
+                             {Index.getOrInsertValueInfo(Var)}, {});
+    BarS->setModulePath(PathB);
+    BarS->setOriginalName(123);
+    GlobalValueSummary *BarPtr = BarS.get();
+    Index.addGlobalValueSummary(Index.getOrInsertValueInfo(Bar),
+                                std::move(BarS));
+    auto VarS = llvm::make_unique<GlobalVarSummary>(
+        GlobalValueSummary::GVFlags(GlobalValue::InternalLinkage, true, false,
+                                    true),
+        std::vector<ValueInfo>{});
+    VarS->setModulePath(PathB);
+    Index.addGlobalValueSummary(Index.getOrInsertValueInfo(Var),
+                                std::move(VarS));
+    auto AliasS = llvm::make_unique<AliasSummary>(GlobalValueSummary::GVFlags(
+        GlobalValue::WeakAnyLinkage, false, true, false));
+    AliasS->setModulePath(PathB);
+    AliasS->setAliasee(BarPtr);
+    AliasS->setAliaseeGUID(Bar);
+    Index.addGlobalValueSummary(Index.getOrInsertValueInfo(Alias),
+                                std::move(AliasS));
+    Index.cfiFunctionDefs().insert("foo");
+
+    // The backend of a.o imports bar and the alias.
+    StringMap<std::map<std::string, GVSummaryMapTy>> ModuleToSummaries;
+    auto &ForA = ModuleToSummaries["a.o"];
+    ForA["a.o"][Foo] = Index.findSummaryInModule(Foo, PathA);
+    ForA["b.o"][Bar] = Index.findSummaryInModule(Bar, PathB);
+    ForA["b.o"][Alias] = Index.findSummaryInModule(Alias, PathB);
+
+    raw_string_ostream OS(Table);
+    summarytab::write(Index, ModuleToSummaries, OS);
+    OS.flush();
+  }
+};
+
+TEST_F(SummaryTableTest, Lookup) {
+  ASSERT_TRUE(summarytab::isSummaryTable(Table));
+  auto ReaderOrErr = summarytab::Reader::create(Table);
+  ASSERT_TRUE(!!ReaderOrErr);
+  summarytab::Reader &R = *ReaderOrErr;
+
+  ASSERT_EQ(2u, R.modules().size());
+  EXPECT_EQ("a.o", R.getModulePath(R.modules()[0]));
+  EXPECT_EQ(1u, R.modules()[0].ModuleId);
+  EXPECT_EQ(5u, R.modules()[0].Hash[4]);
+  EXPECT_EQ(3u, R.modules()[0].Needed.Size);
+  EXPECT_EQ(0u, R.modules()[1].Needed.Size);
+  EXPECT_EQ(nullptr, R.findModule("c.o"));
+
+  ASSERT_EQ(Index.size(), R.entries().size());
+  for (unsigned I = 1; I < R.entries().size(); ++I)
+    EXPECT_LT(R.entries()[I - 1].GUID, R.entries()[I].GUID);
+
+  const summarytab::storage::Entry *E = R.findEntry(Ext);
+  ASSERT_NE(nullptr, E);
+  EXPECT_EQ(0u, E->Summaries.Size);
+  EXPECT_EQ(nullptr, R.findEntry(GlobalValue::getGUID("missing")));
+
+  EXPECT_NE(nullptr, R.findSummaryInModule(Foo, "a.o"));
+  EXPECT_EQ(nullptr, R.findSummaryInModule(Foo, "b.o"));
+  const summarytab::storage::GlobalValueSummary *S =
+      R.findSummaryInModule(Var, "b.o");
+  ASSERT_NE(nullptr, S);
+  EXPECT_EQ(GlobalValueSummary::GlobalVarKind, S->Kind);
+  EXPECT_EQ(&R.entries()[S->Entry], R.findEntry(Var));
+}
+
+TEST_F(SummaryTableTest, Materialize) {
+  auto ReaderOrErr = summarytab::Reader::create(Table);
+  ASSERT_TRUE(!!ReaderOrErr);
+
+  ModuleSummaryIndex ForB;
+  Error Err = ReaderOrErr->materializeForModule("c.o", ForB);
+  EXPECT_TRUE(!!Err);
+  consumeError(std::move(Err));
+  ASSERT_FALSE(!!ReaderOrErr->materializeForModule("b.o", ForB));
+  EXPECT_EQ(1u, ForB.modulePaths().size());
+  EXPECT_EQ(0u, ForB.size());
+
+  ModuleSummaryIndex ForA;
+  ASSERT_FALSE(!!ReaderOrErr->materializeForModule("a.o", ForA));
+  EXPECT_EQ(2u, ForA.modulePaths().size());
+  EXPECT_EQ(1u, ForA.getModuleId("a.o"));
+  EXPECT_EQ(4u, ForA.getModuleHash("a.o")[3]);
+  EXPECT_EQ(1u, ForA.cfiFunctionDefs().count("foo"));
+
+  // var is not imported, so it is not part of the index and the edge to it is
+  // dropped, as are the edges to ext.
+  EXPECT_FALSE(ForA.getValueInfo(Var));
+  EXPECT_FALSE(ForA.getValueInfo(Ext));
+
+  auto *FooS = dyn_cast_or_null<FunctionSummary>(
+      ForA.findSummaryInModule(Foo, "a.o"));
+  ASSERT_NE(nullptr, FooS);
+  EXPECT_EQ(10u, FooS->instCount());
+  EXPECT_TRUE(FooS->fflags().NoRecurse);
+  EXPECT_FALSE(FooS->fflags().ReadNone);
+  EXPECT_TRUE(FooS->flags().Live);
+  ASSERT_EQ(1u, FooS->calls().size());
+  EXPECT_EQ(Bar, FooS->calls()[0].first.getGUID());
+  EXPECT_EQ(CalleeInfo::HotnessType::Hot, FooS->calls()[0].second.Hotness);
+  ASSERT_EQ(1u, FooS->type_tests().size());
+  EXPECT_EQ(42u, FooS->type_tests()[0]);
+  ASSERT_EQ(1u, FooS->type_checked_load_const_vcalls().size());
+  EXPECT_EQ(8u, FooS->type_checked_load_const_vcalls()[0].VFunc.Offset);
+  EXPECT_EQ(3u, FooS->type_checked_load_const_vcalls()[0].Args.size());
+
+  auto *BarS = dyn_cast_or_null<FunctionSummary>(
+      ForA.findSummaryInModule(Bar, "b.o"));
+  ASSERT_NE(nullptr, BarS);
+  EXPECT_EQ(GlobalValue::InternalLinkage, BarS->linkage());
+  EXPECT_EQ(123u, BarS->getOriginalName());
+  EXPECT_TRUE(BarS->refs().empty());
+
+  auto *AliasS =
+      dyn_cast_or_null<AliasSummary>(ForA.findSummaryInModule(Alias, "b.o"));
+  ASSERT_NE(nullptr, AliasS);
+  EXPECT_EQ(GlobalValue::WeakAnyLinkage, AliasS->linkage());
+  EXPECT_EQ(Bar, AliasS->getAliaseeGUID());
+  EXPECT_EQ(BarS, &AliasS->getAliasee());
+}
+
+TEST_F(SummaryTableTest, Corrupt) {
+  auto ReaderOrErr = summarytab::Reader::create(Table);
+  ASSERT_TRUE(!!ReaderOrErr);
+  const summarytab::storage::Range<summarytab::storage::Word> Needed =
+      ReaderOrErr->modules()[0].Needed;
+  ASSERT_EQ(3u, Needed.Size);
+  uint32_t SummaryOffset =
+      support::endian::read32le(Table.data() + Needed.Offset);
+
+  auto ExpectCorrupt = [&](std::string Data) {
+    auto ReaderOrErr = summarytab::Reader::create(Data);
+    if (!ReaderOrErr) {
+      consumeError(ReaderOrErr.takeError());
+      return;
+    }
+    ModuleSummaryIndex ForA;
+    Error Err = ReaderOrErr->materializeForModule("a.o", ForA);
+    EXPECT_TRUE(!!Err);
+    consumeError(std::move(Err));
+  };
+
+  // A needed summary offset past the end of the table.
+  std::string Data = Table;
+  support::endian::write32le(&Data[Needed.Offset], Table.size());
+  ExpectCorrupt(Data);
+
+  // Entry and module indices past the end of their arrays.
+  Data = Table;
+  support::endian::write32le(&Data[SummaryOffset + 4], 1000);
+  ExpectCorrupt(Data);
+  Data = Table;
+  support::endian::write32le(&Data[SummaryOffset + 8], 1000);
+  ExpectCorrupt(Data);
+
+  // A range of references past the end of the table.
+  Data = Table;
+  support::endian::write32le(&Data[SummaryOffset + 28], 1u << 30);
+  ExpectCorrupt(Data);
+
+  // A truncated table.
+  ExpectCorrupt(Table.substr(0, Table.size() - 4));
+}
+
+TEST(SummaryTableReaderTest, Invalid) {
+  EXPECT_FALSE(summarytab::isSummaryTable("BC"));
+  auto ReaderOrErr = summarytab::Reader::create("LSUM");
+  EXPECT_FALSE(!!ReaderOrErr);
+  consumeError(ReaderOrErr.takeError());
+}
+
+} // end anonymous namespace
@@ -11,7 +11,9 @@
 #include "llvm/ADT/SmallString.h"
 #include "llvm/Support/Endian.h"
 #include "gtest/gtest.h"
+#include <algorithm>
 #include <string>
+#include <vector>
 
 using namespace llvm;
 
@@ -77,6 +79,51 @@ TEST(StringTableBuilderTest, BasicWinCOFF) {
   EXPECT_EQ(23U, B.getOffset("river horse"));
 }
 
+TEST(StringTableBuilderTest, LargeELF) {
+  // Enough strings to sort the table in parallel, many of which are suffixes
+  // of others.
+  std::vector<std::string> Strings;
+  for (unsigned I = 0; I != 40000; ++I) {
+    Strings.push_back("sym" + std::to_string(I));
+    Strings.push_back("_sym" + std::to_string(I));
+    Strings.push_back(std::to_string(I * 7));
+  }
+  Strings.push_back("");
+
+  StringTableBuilder B(StringTableBuilder::ELF);
+  for (const std::string &S : Strings)
+    B.add(S);
+  B.finalize();
+
+  // Build the table the way the serial sort does: each string follows the
+  // ones that are greater when compared from their ends, and is merged into
+  // the previous one if it is its suffix. The builder refers to the strings,
+  // so sort a copy of them.
+  std::vector<std::string> Sorted(Strings);
+  std::sort(Sorted.begin(), Sorted.end());
+  Sorted.erase(std::unique(Sorted.begin(), Sorted.end()), Sorted.end());
+  std::sort(Sorted.begin(), Sorted.end(),
+            [](const std::string &L, const std::string &R) {
+              return std::lexicographical_compare(R.rbegin(), R.rend(),
+                                                  L.rbegin(), L.rend());
+            });
+  std::string Expected(1, '\x00');
+  StringRef Previous;
+  for (const std::string &S : Sorted) {
+    if (!Previous.endswith(S)) {
+      Expected += S;
+      Expected += '\x00';
+      Previous = S;
+    }
+    EXPECT_EQ(Expected.size() - S.size() - 1, B.getOffset(S));
+  }
+
+  SmallString<64> Data;
+  raw_svector_ostream OS(Data);
+  B.write(OS);
+  EXPECT_EQ(Expected, Data);
+}
+
 TEST(StringTableBuilderTest, ELFInOrder) {
   StringTableBuilder B(StringTableBuilder::ELF);
   EXPECT_EQ(1U, B.add("foo"));
@@ -220,6 +220,36 @@ TEST_F(InstrProfTest, test_writer_merge) {
   ASSERT_EQ(0U, R->Counts[1]);
 }
 
+TEST_F(InstrProfTest, test_writer_add_shard) {
+  Writer.addRecord({"func1", 0x1234, {42}}, Err);
+
+  InstrProfWriter Shard1, Shard2;
+  Shard1.addRecord({"func2", 0x1234, {1, 2}}, Err);
+  Shard2.addRecord({"func3", 0x5678, {3}}, Err);
+  Shard2.addRecord({"func3", 0x5678, {4}}, Err);
+  Shard1.addShard(std::move(Shard2));
+  Writer.addShard(std::move(Shard1));
+
+  auto Profile = Writer.writeBuffer();
+  readProfile(std::move(Profile));
+
+  Expected<InstrProfRecord> R = Reader->getInstrProfRecord("func1", 0x1234);
+  EXPECT_THAT_ERROR(R.takeError(), Succeeded());
+  ASSERT_EQ(1U, R->Counts.size());
+  ASSERT_EQ(42U, R->Counts[0]);
+
+  R = Reader->getInstrProfRecord("func2", 0x1234);
+  EXPECT_THAT_ERROR(R.takeError(), Succeeded());
+  ASSERT_EQ(2U, R->Counts.size());
+  ASSERT_EQ(1U, R->Counts[0]);
+  ASSERT_EQ(2U, R->Counts[1]);
+
+  R = Reader->getInstrProfRecord("func3", 0x5678);
+  EXPECT_THAT_ERROR(R.takeError(), Succeeded());
+  ASSERT_EQ(1U, R->Counts.size());
+  ASSERT_EQ(7U, R->Counts[0]);
+}
+
 static const char callee1[] = "callee1";
 static const char callee2[] = "callee2";
 static const char callee3[] = "callee3";
@@ -271,6 +301,54 @@ TEST_P(MaybeSparseInstrProfTest, get_icall_data_read_write) {
   ASSERT_EQ(StringRef((const char *)VD[2].Value, 7), StringRef("callee1"));
 }
 
+TEST_P(MaybeSparseInstrProfTest, get_instr_prof_record_ref) {
+  NamedInstrProfRecord Record1("caller", 0x1234, {1, 2, 3});
+  Record1.reserveSites(IPVK_IndirectCallTarget, 2);
+  InstrProfValueData VD0[] = {{(uint64_t)callee1, 1}, {(uint64_t)callee2, 2}};
+  Record1.addValueData(IPVK_IndirectCallTarget, 0, VD0, 2, nullptr);
+  Record1.addValueData(IPVK_IndirectCallTarget, 1, nullptr, 0, nullptr);
+  Writer.addRecord(std::move(Record1), Err);
+  Writer.addRecord({"caller", 0x1235, {4}}, Err);
+  Writer.addRecord({"callee1", 0x1235, {3, 4}}, Err);
+  Writer.addRecord({"callee2", 0x1235, {3, 4}}, Err);
+  auto Profile = Writer.writeBuffer();
+  readProfile(std::move(Profile));
+
+  Expected<InstrProfRecordRef> R =
+      Reader->getInstrProfRecordRef("caller", 0x1234);
+  EXPECT_THAT_ERROR(R.takeError(), Succeeded());
+  ASSERT_EQ(0x1234U, R->getHash());
+  ASSERT_EQ(3U, R->getCounts().size());
+  ASSERT_EQ(1U, R->getCounts()[0]);
+  ASSERT_EQ(3U, R->getCounts()[2]);
+  ASSERT_EQ(2U, R->getNumValueSites(IPVK_IndirectCallTarget));
+  ASSERT_EQ(0U, R->getNumValueSites(IPVK_MemOPSize));
+
+  InstrProfRecord Record;
+  EXPECT_THAT_ERROR(R->readValueProfData(Record), Succeeded());
+  ASSERT_EQ(2U, Record.getNumValueSites(IPVK_IndirectCallTarget));
+  ASSERT_EQ(2U, Record.getNumValueDataForSite(IPVK_IndirectCallTarget, 0));
+  ASSERT_EQ(0U, Record.getNumValueDataForSite(IPVK_IndirectCallTarget, 1));
+
+  Expected<InstrProfRecord> Full = R->getRecord();
+  EXPECT_THAT_ERROR(Full.takeError(), Succeeded());
+  ASSERT_EQ(3U, Full->Counts.size());
+  ASSERT_EQ(2U, Full->Counts[1]);
+  ASSERT_EQ(2U, Full->getNumValueSites(IPVK_IndirectCallTarget));
+
+  R = Reader->getInstrProfRecordRef("caller", 0x1235);
+  EXPECT_THAT_ERROR(R.takeError(), Succeeded());
+  ASSERT_EQ(1U, R->getCounts().size());
+  ASSERT_EQ(4U, R->getCounts()[0]);
+  ASSERT_EQ(0U, R->getNumValueSites(IPVK_IndirectCallTarget));
+
+  R = Reader->getInstrProfRecordRef("caller", 0x5678);
+  ASSERT_TRUE(ErrorEquals(instrprof_error::hash_mismatch, R.takeError()));
+
+  R = Reader->getInstrProfRecordRef("bar", 0x1234);
+  ASSERT_TRUE(ErrorEquals(instrprof_error::unknown_function, R.takeError()));
+}
+
 TEST_P(MaybeSparseInstrProfTest, annotate_vp_data) {
   NamedInstrProfRecord Record("caller", 0x1234, {1, 2});
   Record.reserveSites(IPVK_IndirectCallTarget, 1);
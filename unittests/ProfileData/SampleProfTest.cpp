@@ -10,6 +10,8 @@
 #include "llvm/ProfileData/SampleProf.h"
 #include "llvm/ADT/StringMap.h"
 #include "llvm/ADT/StringRef.h"
+#include "llvm/IR/BasicBlock.h"
+#include "llvm/IR/Function.h"
 #include "llvm/IR/LLVMContext.h"
 #include "llvm/IR/Metadata.h"
 #include "llvm/IR/Module.h"
@@ -97,11 +99,15 @@ struct SampleProfTest : ::testing::Test {
     StringMap<FunctionSamples> &ReadProfiles = Reader->getProfiles();
     ASSERT_EQ(2u, ReadProfiles.size());
 
-    FunctionSamples &ReadFooSamples = ReadProfiles[FooName];
+    std::string FooGUID;
+    StringRef FooRep = getRepInFormat(FooName, Format, FooGUID);
+    FunctionSamples &ReadFooSamples = ReadProfiles[FooRep];
     ASSERT_EQ(7711u, ReadFooSamples.getTotalSamples());
     ASSERT_EQ(610u, ReadFooSamples.getHeadSamples());
 
-    FunctionSamples &ReadBarSamples = ReadProfiles[BarName];
+    std::string BarGUID;
+    StringRef BarRep = getRepInFormat(BarName, Format, BarGUID);
+    FunctionSamples &ReadBarSamples = ReadProfiles[BarRep];
     ASSERT_EQ(20301u, ReadBarSamples.getTotalSamples());
     ASSERT_EQ(1437u, ReadBarSamples.getHeadSamples());
 
@@ -162,6 +168,55 @@ TEST_F(SampleProfTest, roundtrip_binary_profile) {
   testRoundTrip(SampleProfileFormat::SPF_Binary);
 }
 
+TEST_F(SampleProfTest, roundtrip_compact_binary_profile) {
+  testRoundTrip(SampleProfileFormat::SPF_Compact_Binary);
+}
+
+TEST_F(SampleProfTest, compact_binary_profile_reads_module_functions) {
+  createWriter(SampleProfileFormat::SPF_Compact_Binary);
+
+  StringMap<FunctionSamples> Profiles;
+  for (StringRef Name : {"_Z3fooi", "_Z3bari", "_Z3bazi"}) {
+    FunctionSamples &Samples = Profiles[Name];
+    Samples.setName(Name);
+    Samples.addTotalSamples(Name.size() * 10);
+    Samples.addHeadSamples(1);
+    Samples.addBodySamples(1, 0, Name.size() * 10);
+    Samples.addCalledTargetSamples(1, 0, "_Z3quxi", 5);
+  }
+  ASSERT_TRUE(NoError(Writer->write(Profiles)));
+  Writer->getOutputStream().flush();
+
+  auto Profile = MemoryBuffer::getMemBufferCopy(Data);
+  readProfile(Profile);
+  ASSERT_EQ(SPF_Compact_Binary, Reader->getFormat());
+
+  // Only the profiles of the functions defined in the module are read.
+  Module M("my_module", Context);
+  FunctionType *FnType =
+      FunctionType::get(Type::getVoidTy(Context), /*isVarArg=*/false);
+  Function *Foo = Function::Create(FnType, GlobalValue::ExternalLinkage,
+                                   "_Z3fooi.cold", &M);
+  BasicBlock::Create(Context, "entry", Foo);
+  Function *Bar =
+      Function::Create(FnType, GlobalValue::ExternalLinkage, "_Z3bari", &M);
+  Reader->collectFuncsToUse(M);
+  ASSERT_TRUE(NoError(Reader->read()));
+
+  ASSERT_EQ(1u, Reader->getProfiles().size());
+  FunctionSamples *ReadFooSamples = Reader->getSamplesFor(*Foo);
+  ASSERT_TRUE(ReadFooSamples != nullptr);
+  ASSERT_EQ(70u, ReadFooSamples->getTotalSamples());
+  ASSERT_EQ(std::to_string(Function::getGUID("_Z3fooi")),
+            ReadFooSamples->getName());
+  auto CallTargets = ReadFooSamples->findCallTargetMapAt(1, 0);
+  ASSERT_TRUE(NoError(CallTargets.getError()));
+  ASSERT_EQ(1u, CallTargets->size());
+  ASSERT_EQ(Function::getGUID("_Z3quxi"),
+            FunctionSamples::getGUID(CallTargets->begin()->first()));
+  ASSERT_TRUE(Reader->getSamplesFor(*Bar) == nullptr);
+}
+
 TEST_F(SampleProfTest, sample_overflow_saturation) {
   const uint64_t Max = std::numeric_limits<uint64_t>::max();
   sampleprof_error Result;
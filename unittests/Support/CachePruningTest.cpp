@@ -9,6 +9,9 @@
 
 #include "llvm/Support/CachePruning.h"
 #include "llvm/Support/Error.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/raw_ostream.h"
 #include "gtest/gtest.h"
 
 using namespace llvm;
@@ -95,3 +98,47 @@ TEST(CachePruningPolicyParser, Errors) {
   EXPECT_EQ("Unknown key: 'foo'",
             toString(parseCachePruningPolicy("foo=bar").takeError()));
 }
+
+TEST(CachePruningTest, EvictsCheapestEntriesFirst) {
+  SmallString<128> Dir;
+  ASSERT_FALSE(sys::fs::createUniqueDirectory("cache-pruning", Dir));
+
+  auto MakeEntry = [&](StringRef Name, size_t Size) {
+    SmallString<128> Path(Dir);
+    sys::path::append(Path, Name);
+    std::error_code EC;
+    raw_fd_ostream OS(Path, EC, sys::fs::F_None);
+    ASSERT_FALSE(EC);
+    OS << std::string(Size, 'x');
+  };
+  auto HasEntry = [&](StringRef Name) {
+    SmallString<128> Path(Dir);
+    sys::path::append(Path, Name);
+    return sys::fs::exists(Path);
+  };
+
+  // The small entry took much longer to produce per byte, so it survives even
+  // though the size-based policy alone would have kept the large one last.
+  MakeEntry("llvmcache-small", 100);
+  MakeEntry("llvmcache-large", 1000);
+  MakeEntry("llvmcache-unknown", 10);
+  recordCacheEntryCost(Dir, "llvmcache-small", std::chrono::milliseconds(500));
+  recordCacheEntryCost(Dir, "llvmcache-large", std::chrono::milliseconds(50));
+
+  CachePruningPolicy Policy;
+  Policy.Interval = std::chrono::seconds(0);
+  Policy.MaxSizeFiles = 1;
+  EXPECT_TRUE(pruneCache(Dir, Policy));
+  EXPECT_TRUE(HasEntry("llvmcache-small"));
+  EXPECT_FALSE(HasEntry("llvmcache-large"));
+  EXPECT_FALSE(HasEntry("llvmcache-unknown"));
+
+  // Records of removed entries are dropped from the cost file.
+  SmallString<128> CostFile(Dir);
+  sys::path::append(CostFile, "llvmcache.costs");
+  uint64_t CostFileSize;
+  ASSERT_FALSE(sys::fs::file_size(CostFile, CostFileSize));
+  EXPECT_EQ(StringRef("llvmcache-small 500\n").size(), CostFileSize);
+
+  ASSERT_FALSE(sys::fs::remove_directories(Dir));
+}
@@ -17,6 +17,7 @@
 #include "llvm/Config/config.h"
 #include "llvm/Support/Error.h"
 #include "gtest/gtest.h"
+#include <string>
 
 using namespace llvm;
 
@@ -66,6 +67,74 @@ TEST(CompressionTest, Zlib) {
   TestZlibCompression(BinaryDataStr, zlib::DefaultCompression);
 }
 
+void TestZlibParallelCompression(StringRef Input,
+                                 zlib::CompressionLevel Level) {
+  const size_t ChunkSize = 1 << 12;
+  SmallString<32> Compressed;
+  Error E = zlib::compressParallel(Input, Compressed, Level, ChunkSize);
+  EXPECT_FALSE(E);
+  consumeError(std::move(E));
+
+  // The stream starts with the same header as the one of compress().
+  SmallString<32> Serial;
+  E = zlib::compress(Input, Serial, Level);
+  EXPECT_FALSE(E);
+  consumeError(std::move(E));
+  EXPECT_EQ(Serial.substr(0, 2), Compressed.substr(0, 2));
+
+  // The chunks form a single stream that zlib can uncompress.
+  SmallString<32> Uncompressed;
+  E = zlib::uncompress(Compressed, Uncompressed, Input.size());
+  EXPECT_FALSE(E);
+  consumeError(std::move(E));
+  EXPECT_EQ(Input, Uncompressed);
+
+  // Both streams are uncompressed in parallel, or serially for the stream of
+  // compress() which has no chunks.
+  for (StringRef Stream : {StringRef(Compressed), StringRef(Serial)}) {
+    std::string Output(Input.size(), '\0');
+    size_t Size = Output.size();
+    E = zlib::uncompressParallel(Stream, &Output[0], Size);
+    EXPECT_FALSE(E);
+    consumeError(std::move(E));
+    EXPECT_EQ(Input.size(), Size);
+    EXPECT_EQ(Input, Output);
+
+    // Uncompression fails if expected length is too short.
+    Size = Output.size() - 1;
+    E = zlib::uncompressParallel(Stream, &Output[0], Size);
+    EXPECT_EQ("zlib error: Z_BUF_ERROR", llvm::toString(std::move(E)));
+  }
+
+  // A corrupted checksum is detected.
+  Compressed.back() ^= 1;
+  std::string Output(Input.size(), '\0');
+  size_t Size = Output.size();
+  E = zlib::uncompressParallel(Compressed, &Output[0], Size);
+  EXPECT_EQ("zlib error: Z_DATA_ERROR", llvm::toString(std::move(E)));
+}
+
+TEST(CompressionTest, ZlibParallel) {
+  std::string Input;
+  for (unsigned I = 0; I != 10000; ++I)
+    Input += "line " + std::to_string(I * I % 997) + "\n";
+
+  TestZlibParallelCompression(Input, zlib::NoCompression);
+  TestZlibParallelCompression(Input, zlib::BestSizeCompression);
+  TestZlibParallelCompression(Input, zlib::BestSpeedCompression);
+  TestZlibParallelCompression(Input, zlib::DefaultCompression);
+
+  // Inputs of at most one chunk are compressed like compress() does.
+  SmallString<32> Compressed, Serial;
+  Error E = zlib::compressParallel("hello, world!", Compressed);
+  EXPECT_FALSE(E);
+  consumeError(std::move(E));
+  E = zlib::compress("hello, world!", Serial);
+  EXPECT_FALSE(E);
+  consumeError(std::move(E));
+  EXPECT_EQ(Serial, Compressed);
+}
+
 TEST(CompressionTest, ZlibCRC32) {
   EXPECT_EQ(
       0x414FA339U,
@@ -15,7 +15,9 @@
 #include "llvm/Support/Parallel.h"
 #include "gtest/gtest.h"
 #include <array>
+#include <atomic>
 #include <random>
+#include <vector>
 
 uint32_t array[1024 * 1024];
 
@@ -50,4 +52,32 @@ TEST(Parallel, parallel_for) {
   ASSERT_EQ(range[2049], 1u);
 }
 
+TEST(Parallel, nested) {
+  // Every outer task waits on an inner group; pool threads must keep running
+  // queued work while they wait instead of blocking.
+  std::atomic<uint32_t> Count(0);
+  for_each_n(parallel::par, 0, 64, [&Count](size_t) {
+    for_each_n(parallel::par, 0, 2048, [&Count](size_t) { ++Count; });
+  });
+  ASSERT_EQ(Count, 64u * 2048u);
+}
+
+TEST(Parallel, sort_in_for_each) {
+  std::vector<std::vector<uint32_t>> Vectors(16);
+  std::mt19937 randEngine;
+  std::uniform_int_distribution<uint32_t> dist;
+  for (auto &V : Vectors) {
+    V.resize(16 * 1024);
+    for (auto &I : V)
+      I = dist(randEngine);
+  }
+
+  for_each(parallel::par, Vectors.begin(), Vectors.end(),
+           [](std::vector<uint32_t> &V) {
+             sort(parallel::par, V.begin(), V.end());
+           });
+  for (auto &V : Vectors)
+    ASSERT_TRUE(std::is_sorted(V.begin(), V.end()));
+}
+
 #endif